@@ -12,10 +12,25 @@ layout(location = 3) in vec2 uv;
 //     vec4 gl_Position;
 // };
 
+struct InstanceData {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    vec4 boundingSphere;
+    int textureIndex;
+    uint materialIndex;
+    uint batchIndex;
+    uint entityId;
+    uint flags;
+};
+
+// Per instance data, indexed with gl_InstanceIndex.
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
+
 // Push Constants
 layout(push_constant) uniform Push {
     mat4 projectionViewMatrix; // projection * view
-    mat4 modelMatrix; // model matrix
 } push;
 
 invariant gl_Position;
@@ -23,7 +38,7 @@ invariant gl_Position;
 // gl_Positions is the default output variable.
 // gl_VertexIndex contains the current vertex index for everytime the main() function is executed.
 void main() {
-    vec4 worldPosition = push.modelMatrix * vec4(position, 1.0);
+    vec4 worldPosition = instances[gl_InstanceIndex].modelMatrix * vec4(position, 1.0);
 
     gl_Position = push.projectionViewMatrix * worldPosition;
 }
\ No newline at end of file
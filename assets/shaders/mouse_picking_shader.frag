@@ -15,7 +15,7 @@ layout (location = 0) flat in uint64_t inId;
 // layout (location = 0) out float outColor;
 
 // Shader Storage Buffer Object (SSBO)
-layout(std140, set = 1, binding = 0) writeonly buffer MousePickingStorageBuffer {
+layout(std140, set = 2, binding = 0) writeonly buffer MousePickingStorageBuffer {
     int64_t objectId;
 } ssbo;
 
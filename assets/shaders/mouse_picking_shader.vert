@@ -10,33 +10,41 @@ layout(location = 3) in vec2 uv;
 // Output
 layout(location = 0) out uint64_t outId;
 
-struct PointLight {
-  vec4 position;
-  vec4 color;  // w is intensity
-};
-
 // Uniform Buffer Object (UBO)
 layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projectionMatrix;
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[10];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;
+    vec4 clusterDepth;
 } ubo;
 
-// Push Constants
-layout(push_constant) uniform Push {
-    mat4 modelMatrix; // projection * view * matrix
-    uint64_t objectId;
-} push;
+struct InstanceData {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    vec4 boundingSphere;
+    int textureIndex;
+    uint materialIndex;
+    uint batchIndex;
+    uint entityId;
+    uint flags;
+};
+
+// Per instance data, indexed with gl_InstanceIndex.
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
 
 invariant gl_Position;
 
 // gl_Positions is the default output variable.
 // gl_VertexIndex contains the current vertex index for everytime the main() function is executed.
 void main() {
-    vec4 worldPosition = push.modelMatrix * vec4(position, 1.0);
+    InstanceData instance = instances[gl_InstanceIndex];
+    vec4 worldPosition = instance.modelMatrix * vec4(position, 1.0);
     gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldPosition;
-    outId = push.objectId;
+    outId = uint64_t(instance.entityId);
 }
\ No newline at end of file
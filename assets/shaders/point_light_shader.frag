@@ -6,19 +6,16 @@ layout(location = 0) in vec2 fragOffset;
 // Output
 layout (location = 0) out vec4 outColor;
 
-struct PointLight {
-    vec4 position; // ignore w
-    vec4 color;  // w is intensity
-};
-
 // Uniform Buffer Object (UBO)
 layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projectionMatrix;
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[10];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;
+    vec4 clusterDepth;
 } ubo;
 
 layout(push_constant) uniform Push {
@@ -14,19 +14,16 @@ const vec3 OFFSETS[6] = vec3[](
     vec3(1.0, 1.0, 0.0) // Bottom-Right
 );
 
-struct PointLight {
-    vec4 position; // ignore w
-    vec4 color;  // w is intensity
-};
-
 // Uniform Buffer Object (UBO)
 layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projectionMatrix;
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[10];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;
+    vec4 clusterDepth;
 } ubo;
 
 layout(push_constant) uniform Push {
@@ -1,8 +1,5 @@
 #version 450
 
-layout(location = 0) in vec4 inPos;
-layout(location = 1) in vec3 inLightPos;
-
 // Outputs
 // layout (location = 0) out float outColor;
 
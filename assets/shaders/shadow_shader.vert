@@ -1,5 +1,4 @@
 #version 450 // GLSL version 4.50
-#extension GL_EXT_multiview : enable
 // #extension GL_EXT_debug_printf : enable
 
 // Input
@@ -8,25 +7,43 @@ layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
-layout(location = 0) out vec4 outPos;
-layout(location = 1) out vec3 outLightPos;
+// Specialization Constant
+layout (constant_id = 0) const int numShadowedLights = 10;
+
+// Every shadowed point light's face matrices and atlas tiles.
+struct LightShadow {
+    mat4 viewProjection[6];
+    vec4 faceRects[6];
+    vec4 params;
+};
 
 // Uniform Buffer Object
-layout(set = 0, binding = 0) uniform LightUbo {
-    mat4 projectionMatrix;
-    mat4 viewMatries[6];
-} lightUbo;
+layout(set = 2, binding = 0) uniform ShadowUbo {
+    LightShadow lights[numShadowedLights];
+} shadowUbo;
 
 
-// Dynamic Uniform Buffer Object
-layout(set = 1, binding = 0) uniform DynamicUbo {
-    mat4 modelMatrix; // projection * view * matrix
+struct InstanceData {
+    mat4 modelMatrix;
     mat4 normalMatrix;
-} dynamicUbo;
+    vec4 boundingSphere;
+    int textureIndex;
+    uint materialIndex;
+    uint batchIndex;
+    uint entityId;
+    uint flags;
+};
+
+// Per instance data, indexed with gl_InstanceIndex.
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
 
 // Push Constants
 layout(push_constant) uniform Push {
-    vec4 lightPos;
+    uint shadowIndex; // Light whose shadow is being rendered.
+    uint face;        // Cube face being rendered, the viewport is set to its tile of the atlas.
+    uint skipFlags;   // Instances with any of these flags are not drawn.
 } push;
 
 out gl_PerVertex 
@@ -37,9 +54,12 @@ out gl_PerVertex
 // gl_Positions is the default output variable.
 // gl_VertexIndex contains the current vertex index for everytime the main() function is executed.
 void main() {
-    // debugPrintfEXT("The ViewIndex is %i\n", gl_ViewIndex);
+    // Place skipped instances outside the clip volume, so their triangles are clipped before rasterization.
+    if ((instances[gl_InstanceIndex].flags & push.skipFlags) != 0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
     // vec3 flippedPosition = vec3(-position.x, position.y, position.z);
-    gl_Position = lightUbo.projectionMatrix * lightUbo.viewMatries[gl_ViewIndex] * dynamicUbo.modelMatrix * vec4(position, 1.0);
-    outPos = vec4(position, 1.0);
-    outLightPos = push.lightPos.xyz;
+    gl_Position = shadowUbo.lights[push.shadowIndex].viewProjection[push.face] * instances[gl_InstanceIndex].modelMatrix * vec4(position, 1.0);
 }
\ No newline at end of file
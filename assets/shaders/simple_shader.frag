@@ -12,17 +12,18 @@ layout(location = 1) in vec3 inWorldPosition;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
 layout(location = 4) in vec3 inLocalPos;
-layout(location = 5) in vec3 inLightPos;
+layout(location = 6) flat in int inTextureIndex;
 
 // Outputs
 layout (location = 0) out vec4 outColor;
 
 // Specialization Constant
-layout (constant_id = 0) const int numLights = 10;
+layout (constant_id = 0) const int numShadowedLights = 10;
 
 struct PointLight {
-  vec4 position;
-  vec4 color;  // w is intensity
+  vec4 position;    // w is the radius of influence
+  vec4 color;       // w is intensity
+  int shadowIndex;  // Index into the shadow UBO, or -1 without a shadow.
 };
 
 // Uniform Buffer Object (UBO)
@@ -31,35 +32,89 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[numLights];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;  // Clusters along x, y and z, and the tile size in pixels (w).
+    vec4 clusterDepth;  // Near and far plane, then the scale and bias turning the log of a view depth into a slice.
 } ubo;
 
+// Every point light, and the light grid: each cluster's (offset, count) range of the light index list, see LightGrid.
+layout(std430, set = 0, binding = 1) readonly buffer LightBuffer {
+    PointLight lights[];
+};
+layout(std430, set = 0, binding = 2) readonly buffer ClusterBuffer {
+    uvec2 clusters[];
+};
+layout(std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+
 // Shadows
-layout(set = 2, binding = 0) uniform samplerCube samplerShadowCubeMap;
+// Every shadowed point light's face matrices and atlas tiles, see ShadowRenderSystem::LightShadow.
+struct LightShadow {
+    mat4 viewProjection[6];
+    vec4 faceRects[6]; // Atlas UV offset (xy) and size (zw) of every face's tile.
+    vec4 params;       // x is 1 if the light has a shadow.
+};
+
+layout(set = 2, binding = 0) uniform sampler2D samplerShadowAtlas;
+layout(set = 2, binding = 1) uniform ShadowUbo {
+    LightShadow lights[numShadowedLights];
+} shadowUbo;
 
 // Textures
 layout(set = 3, binding = 0) uniform sampler2D samplerTextures[];
 
 // Push Constants
 layout(push_constant) uniform Push {
-    int imageIndex;
     bool textureMapping;
     int shadows;
     float shadowBias;
     float shadowOpacity;
 } push;
 
-// From https://stackoverflow.com/questions/10786951/omnidirectional-shadow-mapping-with-depth-cubemap
-// Convert the light-to-fragment vector to a depth value so it can be compared with a sampled depth value.
-float VectorToDepthValue(vec3 Vec) {
-    vec3 AbsVec = abs(Vec);
-    float LocalZcomp = max(AbsVec.x, max(AbsVec.y, AbsVec.z));
+// Cube face the light-to-fragment vector falls in, in the order +X, -X, +Y, -Y, +Z, -Z.
+int CubeFace(vec3 lightToFragment) {
+    vec3 absVec = abs(lightToFragment);
+    if (absVec.x >= absVec.y && absVec.x >= absVec.z) {
+        return lightToFragment.x >= 0.0 ? 0 : 1;
+    }
+    if (absVec.y >= absVec.z) {
+        return lightToFragment.y >= 0.0 ? 2 : 3;
+    }
+    return lightToFragment.z >= 0.0 ? 4 : 5;
+}
+
+// How much of the light reaches the fragment: 1 when lit, the shadow opacity when shadowed.
+float ShadowFactor(int shadowIndex, vec3 surfaceNormal, vec3 directionToLight) {
+    if (push.shadows != 1 || shadowIndex < 0 || shadowUbo.lights[shadowIndex].params.x == 0.0) {
+        return 1.0;
+    }
+
+    int face = CubeFace(-directionToLight);
+    vec4 lightClip = shadowUbo.lights[shadowIndex].viewProjection[face] * vec4(inWorldPosition, 1.0);
+    vec3 lightNdc = lightClip.xyz / lightClip.w;
+    if (lightNdc.z >= 1.0) {
+        return 1.0; // Past the light's range, where nothing was drawn into its tiles.
+    }
+
+    // Stay half a texel inside the tile, so filtering never reads a neighbouring one.
+    vec4 rect = shadowUbo.lights[shadowIndex].faceRects[face];
+    vec2 halfTexel = 0.5 / vec2(textureSize(samplerShadowAtlas, 0));
+    vec2 uv = clamp(rect.xy + (lightNdc.xy * 0.5 + 0.5) * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);
+    float sampledDepth = texture(samplerShadowAtlas, uv).x;
+
+    // Check if fragment is in shadow
+    float bias = max(push.shadowBias * (1.0 - clamp(dot(surfaceNormal, normalize(directionToLight)), 0, 1)), push.shadowBias);
+    return (sampledDepth + bias > lightNdc.z) ? 1.0 : push.shadowOpacity;
+}
 
-    const float f = 25.0;
-    const float n = 0.01;
-    float NormZComp = (f+n) / (f-n) - (2*f*n)/(f-n)/LocalZcomp;
-    return (NormZComp + 1.0) * 0.5;
+// Cluster of the light grid the fragment falls in.
+uint ClusterIndex() {
+    float viewDepth = (ubo.viewMatrix * vec4(inWorldPosition, 1.0)).z;
+    uint slice = uint(clamp(floor(log(viewDepth) * ubo.clusterDepth.z + ubo.clusterDepth.w), 0.0, float(ubo.clusterGrid.z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy) / ubo.clusterGrid.w, ubo.clusterGrid.xy - 1);
+    return (slice * ubo.clusterGrid.y + tile.y) * ubo.clusterGrid.x + tile.x;
 }
 
 void main() {
@@ -81,12 +136,21 @@ void main() {
 
     vec3 cameraPositionWorld = ubo.inverseViewMatrix[3].xyz;
 
-    // Loop through point lights.
-    for (int i = 0; i < numLights; i++) {
-        PointLight light = ubo.lights[i];
+    // Loop through the point lights reaching the fragment's cluster.
+    uvec2 cluster = clusters[ClusterIndex()];
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++) {
+        PointLight light = lights[lightIndices[i]];
 
         vec3 directionToLight = light.position.xyz - inWorldPosition;
-        float attenuation = light.color.w / dot(directionToLight, directionToLight); // distance squared
+        float distanceSquared = dot(directionToLight, directionToLight);
+        if (distanceSquared >= light.position.w * light.position.w) {
+            continue;
+        }
+
+        // Fade the light out towards its radius of influence, so it ends without a seam at the cluster edges.
+        float window = clamp(1.0 - pow(distanceSquared / (light.position.w * light.position.w), 2.0), 0.0, 1.0);
+        float attenuation = light.color.w / distanceSquared * window * window;
+        attenuation *= ShadowFactor(light.shadowIndex, surfaceNormal, directionToLight);
         float cosAngIncidence = dot(surfaceNormal, directionToLight);
         cosAngIncidence = clamp(cosAngIncidence, 0, 1);
 
@@ -103,24 +167,10 @@ void main() {
         specularLighting += light.color.xyz * attenuation * blinnTerm;
     }
 
-    // Shadow
-	vec3 lightVec = inWorldPosition - inLightPos;
-    float sampledDist = texture(samplerShadowCubeMap, lightVec).x;
-    float dist = VectorToDepthValue(inLightPos - inWorldPosition);
-    // float dist = length(lightVec);
-
-	// Check if fragment is in shadow
-    float bias = max(push.shadowBias * (1.0 - clamp(dot(surfaceNormal, (inLightPos - inWorldPosition)), 0, 1)), push.shadowBias);
-    float shadow = 1.0;
-
-    if (push.shadows == 1) {
-        shadow = (sampledDist + bias > dist) ? 1.0 : push.shadowOpacity;
-    }
-
-    if (push.imageIndex == -1 || !push.textureMapping) {
-        outColor = vec4(inColor * (specularLighting + diffuseLighting) * shadow, 1.0); // RGBA
+    if (inTextureIndex == -1 || !push.textureMapping) {
+        outColor = vec4(inColor * (specularLighting + diffuseLighting), 1.0); // RGBA
     } else {
-        outColor = vec4(texture(samplerTextures[push.imageIndex], inUV).xyz * (specularLighting + diffuseLighting) * shadow, 1.0); // RGBA
+        outColor = vec4(texture(samplerTextures[nonuniformEXT(inTextureIndex)], inUV).xyz * (specularLighting + diffuseLighting), 1.0); // RGBA
     }
-    // outColor = vec4((specularLighting + diffuseLighting) * inColor * shadow, 1.0); // RGBA
+    // outColor = vec4((specularLighting + diffuseLighting) * inColor, 1.0); // RGBA
 }
\ No newline at end of file
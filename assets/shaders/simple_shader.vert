@@ -13,12 +13,7 @@ layout(location = 1) out vec3 outWorldPosition;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 layout(location = 4) out vec3 outLocalPos;
-layout(location = 5) out vec3 outLightPos;
-
-struct PointLight {
-  vec4 position;
-  vec4 color;  // w is intensity
-};
+layout(location = 6) flat out int outTextureIndex;
 
 // Uniform Buffer Object (UBO)
 layout(set = 0, binding = 0) uniform GlobalUbo {
@@ -26,22 +21,35 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[10];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;
+    vec4 clusterDepth;
 } ubo;
 
-// Dynamic Uniform Buffer Object
-layout(set = 1, binding = 0) uniform DynamicUbo {
-    mat4 modelMatrix; // projection * view * matrix
+struct InstanceData {
+    mat4 modelMatrix;
     mat4 normalMatrix;
-} dynamicUbo;
+    vec4 boundingSphere;
+    int textureIndex;
+    uint materialIndex;
+    uint batchIndex;
+    uint entityId;
+    uint flags;
+};
+
+// Per instance data, indexed with gl_InstanceIndex.
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
 
 invariant gl_Position;
 
 // gl_Positions is the default output variable.
 // gl_VertexIndex contains the current vertex index for everytime the main() function is executed.
 void main() {
-    vec4 worldPosition = dynamicUbo.modelMatrix * vec4(position, 1.0);
+    InstanceData instance = instances[gl_InstanceIndex];
+    vec4 worldPosition = instance.modelMatrix * vec4(position, 1.0);
 
     // w = 1 refers to a position. w = 0 refers to a direction.
     gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldPosition;
@@ -58,10 +66,10 @@ void main() {
     // vec3 normalWorldSpace = normalize(normalMatrix * normal);
 
     // Instead, we compute the normal matrix on the CPU side.
-    outNormal = normalize(mat3(dynamicUbo.normalMatrix) * normal);
+    outNormal = normalize(mat3(instance.normalMatrix) * normal);
     outWorldPosition = worldPosition.xyz;
     outColor = color;
     outUV = uv;
     outLocalPos = position;
-    outLightPos = ubo.lights[0].position.xyz;
+    outTextureIndex = instance.textureIndex;
 }
\ No newline at end of file
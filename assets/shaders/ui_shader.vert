@@ -6,19 +6,16 @@ layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
-struct PointLight {
-  vec4 position;
-  vec4 color;  // w is intensity
-};
-
 // Uniform Buffer Object (UBO)
 layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projectionMatrix;
     mat4 viewMatrix;
     mat4 inverseProjectionMatrix;
     mat4 inverseViewMatrix;
-    PointLight lights[10];
     vec3 ambientLightColor;
+    uint lightCount;
+    uvec4 clusterGrid;
+    vec4 clusterDepth;
 } ubo;
 
 // gl_Positions is the default output variable.
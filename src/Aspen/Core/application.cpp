@@ -1,13 +1,47 @@
 #include "Aspen/Core/application.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
-	Application::Application() {
+	namespace {
+		// The files of the default scene. loadEntities() builds it from them and prefetchDefaultSceneAssets() decodes them ahead of time.
+		constexpr const char* VASE_MODEL = "assets/models/smooth_vase.obj";
+		constexpr const char* CUBE_MODEL = "assets/models/cube.obj";
+		constexpr const char* DRAGON_MODEL = "assets/models/dragon-lowres2.obj";
+		constexpr const char* SPHERE_MODEL = "assets/models/UV-Sphere.obj";
+		constexpr const char* TEAPOT_MODEL = "assets/models/teapot.obj";
+		constexpr const char* BUNNY_MODEL = "assets/models/bunny.obj";
+		constexpr std::array DEFAULT_SCENE_MODELS{VASE_MODEL, CUBE_MODEL, DRAGON_MODEL, SPHERE_MODEL, TEAPOT_MODEL, BUNNY_MODEL};
+
+		constexpr const char* LATTICE_WALL_TEXTURE = "assets/textures/LaticeWall.png";
+		constexpr const char* RUSTED_PLATES_TEXTURE = "assets/textures/RustedPlates.png";
+		constexpr const char* WOOL_TEXTURE = "assets/textures/Wool.jpg";
+		constexpr const char* CERAMIC_TEXTURE = "assets/textures/Ceramic.png";
+		constexpr std::array DEFAULT_SCENE_TEXTURES{LATTICE_WALL_TEXTURE, RUSTED_PLATES_TEXTURE, WOOL_TEXTURE, CERAMIC_TEXTURE};
+	} // namespace
+
+	Application::Application(const std::optional<StressSceneSettings>& stressScene, uint32_t spawnBenchmarkCount) {
 		s_Instance = this;
+		CpuProfiler::setThreadName("Main");
+
+		// The members are initialised by now: the window, the device, the swap chain and the render systems, which create
+		// everything but their pipelines.
+		startupTimeline.record("Window, device and render systems", StartupTimeline::MAIN_THREAD, 0.0, startupTimeline.now());
+
 		window.setEventCallback(BIND_EVENT_FN(Application::OnEvent));
 
-		// Create the mouse picking render pass and tell it to use the attachment from the depth pre-pass.
+		// The rest of startup runs as a small dependency graph. Decoding the default scene's files and compiling the
+		// pipelines only need the device, so they go to the workers. The main thread uploads ImGui's fonts and builds the
+		// scene meanwhile, waiting for each file as it gets to it, and only waits for the pipelines before the first frame.
+		if (!stressScene && !std::filesystem::exists(SCENE_SNAPSHOT_PATH)) {
+			prefetchDefaultSceneAssets();
+		}
+		std::vector<std::future<void>> pipelineBuilds = buildPipelines();
 
-		setupImGui();
+		{
+			StartupTimeline::Scope scope{startupTimeline, "ImGui"};
+			setupImGui();
+		}
 
 		m_Scene = std::make_shared<Scene>(device);
 
@@ -22,7 +56,48 @@ namespace Aspen {
 		auto& camController = cameraEntity.getComponent<CameraControllerArcball>();
 		camController.offset = glm::vec3{0.0f, -1.5f, -3.0f};
 
-		loadEntities();
+		// A generated scene replaces the default content. Otherwise restore the last saved layout if there is one, or build the default scene.
+		{
+			StartupTimeline::Scope scope{startupTimeline, "Scene"};
+			if (stressScene) {
+				generateStressScene(*stressScene);
+			} else if (!loadScene(SCENE_SNAPSHOT_PATH)) {
+				loadEntities();
+			}
+		}
+		assetLoader.clear(); // Everything decoded has been uploaded.
+
+		if (spawnBenchmarkCount > 0) {
+			benchmarkEntitySpawning(spawnBenchmarkCount);
+		}
+
+		{
+			StartupTimeline::Scope scope{startupTimeline, "Scene data, acceleration structures and ray tracing pipeline"};
+			finalizeScene();
+		}
+
+		{
+			StartupTimeline::Scope scope{startupTimeline, "Waiting for pipelines"};
+			for (auto& build : pipelineBuilds) {
+				build.get(); // Rethrows if a build failed.
+			}
+		}
+
+		// Every render system has created its pipelines by now.
+		PipelineCache& pipelineCache = device.getPipelineCache();
+		PipelineCache::Stats pipelineStats = pipelineCache.getStats();
+		appState.pipelineCacheWarm = pipelineStats.warmStart;
+		appState.pipelineCount = static_cast<int>(pipelineStats.pipelines);
+		appState.pipelineCreationTime = pipelineStats.creationTime;
+		appState.shaderModuleCount = static_cast<int>(pipelineStats.shaderModules);
+		appState.shaderModuleHits = static_cast<int>(pipelineStats.shaderModuleHits);
+		std::cout << "Created " << pipelineStats.pipelines << " pipelines in " << pipelineStats.creationTime << " ms summed over all threads ("
+		          << (pipelineStats.warmStart ? "warm start, " + std::to_string(pipelineStats.loadedBytes) + " bytes cached" : std::string{"cold start"}) << ")" << std::endl;
+
+		// Persist the cache right away, so the next run starts warm even if this one does not exit cleanly.
+		pipelineCache.save();
+
+		appState.startupTime = startupTimeline.now();
 	}
 
 	Application::~Application() {
@@ -52,6 +127,7 @@ namespace Aspen {
 		init_info.MinImageCount = renderer.getSwapChainImageCount();
 		init_info.ImageCount = renderer.getSwapChainImageCount();
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+		init_info.PipelineCache = device.getPipelineCache().getPipelineCache();
 
 		ImGui_ImplVulkan_Init(&init_info, renderer.getPresentRenderPass());
 
@@ -67,6 +143,157 @@ namespace Aspen {
 		ImGui_ImplVulkan_DestroyFontUploadObjects();
 	}
 
+	// Compiles the pipelines of the render systems on the worker threads. The constructors already created the layouts and
+	// render passes they need, and every job only touches the pipelines of its own system.
+	// The ray tracing pipeline is not among them, its layout depends on the scene's textures so finalizeScene() builds it.
+	std::vector<std::future<void>> Application::buildPipelines() {
+		// Roughly the most expensive first, the simple render system's fragment shader is the uber shader.
+		std::vector<std::pair<std::string, std::function<void()>>> builds{
+		    {"Simple pipelines", [this] { simpleRenderSystem.createPipelines(); }},
+		    {"Shadow pipelines", [this] { shadowRenderSystem.createPipelines(); }},
+		    {"Depth pre-pass pipelines", [this] { depthPrePassRenderSystem.createPipelines(); }},
+		    {"Culling pipelines", [this] { cullingRenderSystem.createPipelines(); }},
+		    {"Point light pipelines", [this] { pointLightRenderSystem.createPipelines(); }},
+		    {"Outline pipelines", [this] { outlineRenderSystem.createPipelines(); }},
+		    {"Mouse picking pipelines", [this] { mousePickingRenderSystem.createPipelines(); }},
+		    {"UI pipelines", [this] { uiRenderSystem.createPipelines(); }},
+		};
+
+		std::vector<std::future<void>> futures;
+		futures.reserve(builds.size());
+		for (auto& [name, build] : builds) {
+			futures.push_back(threadPool.submit([this, name = std::move(name), build = std::move(build)](uint32_t threadIndex) {
+				StartupTimeline::Scope scope{startupTimeline, name, threadIndex};
+				build();
+			}));
+		}
+		return futures;
+	}
+
+	// Declares the frame's images and passes. The render systems build their framebuffers around the baked images.
+	// Every pass lists what it reads and writes, the graph derives the barriers between them and culls the passes whose
+	// output nothing consumes, e.g. the shadow passes while ray tracing or the picking pass unless a pick was requested.
+	Application::FrameGraph Application::createRenderGraph() {
+		FrameGraph graph{};
+
+		{
+			RenderGraph::ImageDesc desc{};
+			VulkanTools::getSupportedDepthFormat(device.physicalDevice(), &desc.format);
+			desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			graph.sceneDepth = renderGraph.createImage("Scene Depth", desc);
+		}
+		{
+			// Farthest depth of every texel's footprint, at every level down to a single texel. See CullingRenderSystem.
+			RenderGraph::ImageDesc desc{};
+			desc.format = VK_FORMAT_R32_SFLOAT;
+			desc.powerOfTwo = true;
+			desc.mipLevels = 0;
+			desc.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			desc.mipViews = true;
+			graph.depthPyramidImage = renderGraph.createImage("Depth Pyramid", desc);
+		}
+		{
+			// The static casters' shadow atlas and the one sampled by the scene (the static tiles with the animated casters on top).
+			// Both are only partially redrawn, so they keep their contents between frames.
+			RenderGraph::ImageDesc desc{};
+			desc.format = VK_FORMAT_D32_SFLOAT;
+			desc.extent = {ShadowRenderSystem::ATLAS_SIZE, ShadowRenderSystem::ATLAS_SIZE};
+			desc.swapChainSized = false;
+			desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			desc.persistent = true;
+			graph.staticShadowMap = renderGraph.createImage("Static Shadow Atlas", desc);
+
+			desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			graph.shadowMap = renderGraph.createImage("Shadow Atlas", desc);
+		}
+		{
+			RenderGraph::ImageDesc desc{};
+			desc.format = renderer.getSwapChainImageFormat();
+			desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			graph.sceneColor = renderGraph.createImage("Scene Color", desc);
+		}
+		{
+			// The ray generation shader writes through a UNORM view, storage images cannot be sRGB.
+			RenderGraph::ImageDesc desc{};
+			desc.format = renderer.getSwapChainImageFormat();
+			desc.viewFormat = VK_FORMAT_B8G8R8A8_UNORM;
+			desc.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			desc.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+			graph.rayTracingOutput = renderGraph.createImage("Ray Tracing Output", desc);
+		}
+		{
+			RenderGraph::ImageDesc desc{};
+			desc.format = renderer.getSwapChainImageFormat();
+			desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			graph.rayTracingColor = renderGraph.createImage("Ray Tracing Color", desc);
+		}
+		graph.culledDraws = renderGraph.importBuffer("Culled Draws");
+		graph.pickResult = renderGraph.importBuffer("Mouse Picking Result");
+
+		const RenderGraph::Access indirectDraws = RenderGraph::buffer(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+		const RenderGraph::Access loadDepth = RenderGraph::depthAttachment(VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+		graph.culling = renderGraph.addPass(CullingRenderSystem::CULLING_PASS, [&](RenderGraph::PassBuilder& pass) {
+			pass.write(graph.culledDraws, RenderGraph::buffer(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+		});
+		graph.depthPrePass = renderGraph.addPass("Depth Pre-Pass", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.culledDraws, indirectDraws)
+			    .write(graph.sceneDepth, RenderGraph::depthAttachment());
+		});
+		graph.depthPyramidPass = renderGraph.addPass(CullingRenderSystem::DEPTH_PYRAMID_PASS, [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.sceneDepth, RenderGraph::sampledImage(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL))
+			    .write(graph.depthPyramidImage, RenderGraph::storageImage(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+		});
+		graph.occlusionCulling = renderGraph.addPass(CullingRenderSystem::OCCLUSION_CULLING_PASS, [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.depthPyramidImage, RenderGraph::sampledImage(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT))
+			    .readWrite(graph.culledDraws, RenderGraph::buffer(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+		});
+		graph.lateDepthPrePass = renderGraph.addPass("Late Depth Pre-Pass", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.culledDraws, indirectDraws)
+			    .readWrite(graph.sceneDepth, loadDepth);
+		});
+		graph.staticShadows = renderGraph.addPass("Static Shadows", [&](RenderGraph::PassBuilder& pass) {
+			pass.readWrite(graph.staticShadowMap, loadDepth);
+		});
+		graph.shadowComposite = renderGraph.addPass("Shadow Composite", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.staticShadowMap, RenderGraph::transferSource())
+			    .readWrite(graph.shadowMap, RenderGraph::transferDestination());
+		});
+		graph.dynamicShadows = renderGraph.addPass("Dynamic Shadows", [&](RenderGraph::PassBuilder& pass) {
+			pass.readWrite(graph.shadowMap, loadDepth);
+		});
+		graph.scene = renderGraph.addPass("Scene", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.culledDraws, indirectDraws)
+			    .read(graph.shadowMap, RenderGraph::sampledImage(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL))
+			    .readWrite(graph.sceneDepth, loadDepth)
+			    .write(graph.sceneColor, RenderGraph::colorAttachment());
+		});
+		graph.rayTracing = renderGraph.addPass("Ray Tracing", [&](RenderGraph::PassBuilder& pass) {
+			pass.write(graph.rayTracingOutput, RenderGraph::storageImage(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT));
+		});
+		graph.rayTracingResolve = renderGraph.addPass("Ray Tracing Resolve", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.rayTracingOutput, RenderGraph::transferSource())
+			    .write(graph.rayTracingColor, RenderGraph::transferDestination());
+		});
+		graph.rayTracingOverlay = renderGraph.addPass("Ray Tracing Overlay", [&](RenderGraph::PassBuilder& pass) {
+			pass.readWrite(graph.rayTracingColor, RenderGraph::colorAttachment(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+			    .readWrite(graph.sceneDepth, loadDepth);
+		});
+		graph.mousePicking = renderGraph.addPass("Mouse Picking", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.culledDraws, indirectDraws)
+			    .readWrite(graph.sceneDepth, loadDepth)
+			    .write(graph.pickResult, RenderGraph::buffer(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT));
+		});
+		graph.ui = renderGraph.addPass("UI", [&](RenderGraph::PassBuilder& pass) {
+			pass.read(graph.sceneColor, RenderGraph::sampledImage(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT))
+			    .read(graph.rayTracingColor, RenderGraph::sampledImage(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT))
+			    .sideEffect();
+		});
+
+		renderGraph.bake(renderer.getTargetExtent());
+		return graph;
+	}
+
 	void Application::run() {
 		std::cout << "maxPushConstantSize = " << device.properties.limits.maxPushConstantsSize << "\n";
 		std::cout << "maxMemoryAllocationCount = " << device.properties.limits.maxMemoryAllocationCount << "\n";
@@ -141,10 +368,21 @@ namespace Aspen {
 
 				appState.FIXED_DELTA_TIME = 1.0 / static_cast<double>(appState.update_rate);
 
+				{
+					auto& dynamicResolution = renderer.getDynamicResolution();
+					dynamicResolution.setEnabled(appState.dynamicResolution);
+					dynamicResolution.setTargetFrameTime(appState.gpuFrameBudget);
+					dynamicResolution.setMinScale(appState.minRenderScale);
+				}
+
+				if (renderer.getFramesInFlight() != appState.framesInFlight) {
+					renderer.setFramesInFlight(appState.framesInFlight);
+					mousePickingRenderSystem.requeueUnusedSlots(renderer.getFramesInFlight());
+				}
+
 				if (renderer.getDesiredPresentMode() != !appState.enable_vsync) {
 					renderer.setDesiredPresentMode(!appState.enable_vsync); // 0/False is V-sync, 1/True is Mailbox
-					renderer.recreateSwapChain();
-					mousePickingRenderSystem.onResize();
+					renderer.recreateSwapChain(); // Same size, the offscreen targets stay.
 				}
 
 				if (!appState.useRayTracer) {
@@ -210,6 +448,7 @@ namespace Aspen {
 	}
 
 	void Application::update(double deltaTime) {
+		ASPEN_PROFILE_SCOPE("Application::update");
 		auto [cameraComponent, cameraArcball, cameraTransform] = cameraEntity.getComponent<CameraComponent, CameraControllerArcball, TransformComponent>();
 		CameraControllerSystem::OnUpdate(cameraArcball, {renderer.getSwapChainExtent().width, renderer.getSwapChainExtent().height});
 		CameraSystem::OnUpdateArcball(cameraTransform, cameraArcball, appState.FIXED_DELTA_TIME);
@@ -219,6 +458,16 @@ namespace Aspen {
 		cameraComponent.camera.setPerspectiveProjection(glm::radians(65.0f), aspect, 0.1f, 100.0f);
 		cameraComponent.camera.setView(cameraTransform.translation, cameraTransform.rotation);
 
+		// Sync point for structural changes recorded by other threads.
+		m_Scene->playbackCommandBuffers();
+
+		auto spinning = m_Scene->getSpinningComponents();
+		for (const auto& entity : spinning) {
+			auto [spin, transform] = spinning.get<SpinComponent, TransformComponent>(entity);
+			transform.rotation = glm::normalize(glm::angleAxis(spin.angularSpeed * static_cast<float>(deltaTime), spin.axis) * transform.rotation);
+			transform.isTransformUpdated = true;
+		}
+
 		rayTracingRenderSystem.updateTLAS(m_Scene);
 
 		// auto group = m_Scene->getPointLights();
@@ -238,128 +487,316 @@ namespace Aspen {
 	}
 
 	void Application::render(double deltaTime) {
+		// Collect the previous frame first, so its render() has ended too.
+		CpuProfiler::endFrame();
+		ASPEN_PROFILE_SCOPE("Application::render");
 		auto [cameraComponent, cameraArcball, cameraTransform] = cameraEntity.getComponent<CameraComponent, CameraControllerArcball, TransformComponent>();
 
 		if (auto* commandBuffer = renderer.beginFrame()) {
+			// The previous frame is fully recorded, so its bind counts are final.
+			{
+				const auto bindStats = Pipeline::getBindStats();
+				appState.pipelineBinds = static_cast<int>(bindStats.pipelineBinds);
+				appState.descriptorSetBinds = static_cast<int>(bindStats.descriptorSetBinds);
+				Pipeline::resetBindStats();
+			}
+
+			// The GPU is done with the pick this frame index recorded last time, select whatever it found. Picks a newer
+			// request superseded are dropped.
+			if (auto pick = mousePickingRenderSystem.resolve(renderer.getFrameIndex())) {
+				appState.mousePickingLatency = static_cast<int>(pick->latency);
+				if (pick->requestId == mousePickingRenderSystem.getLatestRequestId()) {
+					if (pick->objectId != -1) {
+						uiState.selectedEntity.setEntity(static_cast<entt::entity>(pick->objectId));
+						uiState.gizmoVisible = true;
+					} else {
+						uiState.selectedEntity.setEntity(entt::null);
+						uiState.gizmoVisible = false;
+					}
+				}
+			}
+
 			FrameInfo frameInfo{
 			    renderer.getFrameIndex(),
 			    static_cast<float>(deltaTime),                                                                                                                     // Interpolation - Normalized value.
-			    {globalRenderSystem.getUboDescriptorSets()[renderer.getFrameIndex()], globalRenderSystem.getDynamicUboDescriptorSets()[renderer.getFrameIndex()]}, // Get the global descriptor sets of the current frame.
-			    static_cast<uint32_t>(globalRenderSystem.getDynamicUboBuffers()[renderer.getFrameIndex()]->getAlignmentSize()),
+			    {globalRenderSystem.getUboDescriptorSets()[renderer.getFrameIndex()], globalRenderSystem.getInstanceDescriptorSets()[renderer.getFrameIndex()]}, // Get the global descriptor sets of the current frame.
+			    globalRenderSystem.getDrawList(),
 			    commandBuffer,
 			    cameraComponent.camera,
 			    m_Scene,
 			    appState};
 
-			// Update our UBO buffer.
-			globalRenderSystem.updateUBOs(frameInfo);
+			// Update our UBO buffer. The lights are written with the shadow they were given.
 			shadowRenderSystem.updateUBOs(frameInfo);
+			globalRenderSystem.updateUBOs(frameInfo, shadowRenderSystem.getShadowedLights());
+
+			// The depth pre-pass and the main pass each draw the whole scene, and so does every shadow cache tile being redrawn.
+			{
+				const int passCount = 2 + static_cast<int>(shadowRenderSystem.getStaticFaceCount());
+				appState.drawCallsUnbatched = static_cast<int>(m_Scene->getRenderComponents().size()) * passCount;
+				appState.drawCallsBatched = static_cast<int>(frameInfo.drawList.batches.size()) * passCount;
+
+				const auto& drawList = frameInfo.drawList;
+				const bool indirect = appState.useIndirectDraw && drawList.indirectDrawCount > 0;
+				appState.drawCallsRecorded = static_cast<int>(indirect ? 1 + drawList.looseBatches.size() : drawList.batches.size()) * passCount;
+			}
 
 			/*
-			    Depth Prepass & Shadow Mapping Pass
+			    Switch the render graph's passes for this frame, it culls the ones whose output nothing consumes.
 			*/
-			{
-				renderer.beginRenderPass(commandBuffer, depthPrePassRenderSystem.prepareRenderInfo());
-				depthPrePassRenderSystem.render(frameInfo, uiState.selectedEntity.getEntity());
-				renderer.endRenderPass(commandBuffer);
+			const bool gpuCulling = appState.useIndirectDraw && appState.useGPUCulling;
+			// Only the scene and picking passes draw what occlusion culling keeps, the ray tracer traces everything.
+			const bool occlusionCulling = gpuCulling && appState.useOcclusionCulling && !appState.useRayTracer;
+			renderGraph.setPassEnabled(frameGraph.culling, gpuCulling);
+			renderGraph.setPassEnabled(frameGraph.depthPyramidPass, occlusionCulling);
+			renderGraph.setPassEnabled(frameGraph.occlusionCulling, occlusionCulling);
+			renderGraph.setPassEnabled(frameGraph.lateDepthPrePass, occlusionCulling);
+			renderGraph.setPassEnabled(frameGraph.staticShadows, shadowRenderSystem.getStaticFaceCount() != 0);
+			renderGraph.setPassEnabled(frameGraph.shadowComposite, shadowRenderSystem.getCompositedFaceCount() != 0);
+			renderGraph.setPassEnabled(frameGraph.dynamicShadows, shadowRenderSystem.getDynamicFaceCount() != 0);
+			renderGraph.setPassEnabled(frameGraph.scene, !appState.useRayTracer);
+			renderGraph.setPassEnabled(frameGraph.rayTracing, appState.useRayTracer);
+			renderGraph.setPassEnabled(frameGraph.rayTracingResolve, appState.useRayTracer);
+			renderGraph.setPassEnabled(frameGraph.rayTracingOverlay, appState.useRayTracer);
+			if (mousePickingRenderSystem.hasQueuedRequest()) {
+				renderGraph.requestOutput(frameGraph.pickResult, RenderGraph::buffer(VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT));
+			}
+			renderGraph.compile();
 
-				renderer.beginRenderPass(commandBuffer, shadowRenderSystem.prepareRenderInfo());
-				shadowRenderSystem.render(frameInfo);
-				renderer.endRenderPass(commandBuffer);
+			/*
+			    GPU Culling. The draw list has to point at its output before the passes drawing from it are recorded.
+			*/
+			if (gpuCulling) {
+				cullingRenderSystem.prepare(frameInfo, globalRenderSystem.getDrawList(), *globalRenderSystem.getInstanceBuffers()[renderer.getFrameIndex()], occlusionCulling);
 			}
 
 			/*
-			    Render Scene to texture - Offscreen rendering
+			    Record the raster passes into secondary command buffers, in parallel unless disabled.
+			    Render systems only read the scene and the draw list while recording, the groups they use already exist after updateUBOs().
 			*/
-			if (!appState.useRayTracer) {
-				renderer.beginRenderPass(commandBuffer, simpleRenderSystem.prepareRenderInfo());
-				simpleRenderSystem.render(frameInfo);
-				pointLightRenderSystem.render(frameInfo);
-				// Only render an outline if an entity has been selected.
-				if (uiState.selectedEntity) {
-					outlineRenderSystem.render(frameInfo, uiState.selectedEntity.getEntity());
-				}
-				renderer.endRenderPass(commandBuffer);
-			} else {
-				rayTracingRenderSystem.render(frameInfo);
+			secondaryCommandBuffers.reset(frameInfo.frameIndex);
+			recordingStats.assign(secondaryCommandBuffers.getThreadCount(), {});
+			Timer recordTimer{};
+
+			const entt::entity selectedEntity = uiState.selectedEntity.getEntity();
+			const bool drawOutline = static_cast<bool>(uiState.selectedEntity); // Only render an outline if an entity has been selected.
+			std::vector<std::future<void>> recordings;
+
+			RenderInfo depthPrePassRenderInfo{};
+			VkCommandBuffer depthPrePassCommands = VK_NULL_HANDLE;
+			if (renderGraph.isPassLive(frameGraph.depthPrePass)) {
+				depthPrePassRenderInfo = depthPrePassRenderSystem.prepareRenderInfo();
+				recordings.push_back(recordRenderPass(frameInfo, depthPrePassRenderInfo, depthPrePassCommands, [this, selectedEntity](FrameInfo& passFrameInfo) {
+					depthPrePassRenderSystem.render(passFrameInfo, selectedEntity);
+				}));
+			}
+
+			RenderInfo lateDepthPrePassRenderInfo{};
+			VkCommandBuffer lateDepthPrePassCommands = VK_NULL_HANDLE;
+			if (renderGraph.isPassLive(frameGraph.lateDepthPrePass)) {
+				lateDepthPrePassRenderInfo = depthPrePassRenderSystem.prepareRenderInfo(true);
+				recordings.push_back(recordRenderPass(frameInfo, lateDepthPrePassRenderInfo, lateDepthPrePassCommands, [this](FrameInfo& passFrameInfo) {
+					depthPrePassRenderSystem.renderLate(passFrameInfo);
+				}));
+			}
 
-				// std::shared_ptr<Framebuffer> offscreenPass = rayTracingRenderSystem.getResources();
-				// rayTracingRenderSystem.copyToImage(commandBuffer, offscreenPass->attachments[0].image, offscreenPass->attachments[0].description.finalLayout, offscreenPass->width, offscreenPass->height);
+			// When the main pass records one draw per batch it is split by batch range. The last command buffer draws the point lights and outline on top.
+			RenderInfo mainRenderInfo{};
+			std::vector<VkCommandBuffer> mainCommands;
+			if (renderGraph.isPassLive(frameGraph.scene)) {
+				mainRenderInfo = simpleRenderSystem.prepareRenderInfo();
 
-				renderer.beginRenderPass(commandBuffer, rayTracingRenderSystem.prepareRenderInfo());
-				pointLightRenderSystem.render(frameInfo);
-				// Only render an outline if an entity has been selected.
-				if (uiState.selectedEntity) {
-					outlineRenderSystem.render(frameInfo, uiState.selectedEntity.getEntity());
+				const auto batchCount = static_cast<uint32_t>(frameInfo.drawList.batches.size());
+				uint32_t pieceCount = 1;
+				if (appState.parallelRecording && frameInfo.drawList.isSplittable(appState.useIndirectDraw)) {
+					pieceCount = std::clamp(batchCount / MIN_BATCHES_PER_RECORDING, 1u, threadPool.getThreadCount());
+				}
+
+				mainCommands.resize(pieceCount + 1);
+				for (uint32_t i = 0; i < pieceCount; ++i) {
+					DrawRange range{};
+					if (pieceCount > 1) {
+						range.first = batchCount * i / pieceCount;
+						range.count = batchCount * (i + 1) / pieceCount - range.first;
+					}
+					recordings.push_back(recordRenderPass(frameInfo, mainRenderInfo, mainCommands[i], [this, range](FrameInfo& passFrameInfo) {
+						passFrameInfo.drawRange = range;
+						simpleRenderSystem.render(passFrameInfo);
+					}));
 				}
-				renderer.endRenderPass(commandBuffer);
+				recordings.push_back(recordRenderPass(frameInfo, mainRenderInfo, mainCommands.back(), [this, selectedEntity, drawOutline](FrameInfo& passFrameInfo) {
+					pointLightRenderSystem.render(passFrameInfo);
+					if (drawOutline) {
+						outlineRenderSystem.render(passFrameInfo, selectedEntity);
+					}
+				}));
 			}
 
 			/*
 			    Find object id at the mouse cursor by performing depth testing on the depth pre-pass.
 			*/
-			bool mousePickingRead = false;
-			{
-				if (mousePicking) {
-					mousePicking = false; // Reset bool.
-					mousePickingRead = true;
-
-					auto& storageBuffer = mousePickingRenderSystem.getStorageBuffer();
-					// Reset the SSBO.
-					MousePickingRenderSystem::MousePickingStorageBuffer ssbo{};
-					ssbo.objectId = -1;
-					storageBuffer->writeToBuffer(&ssbo); // Write data to the SSBO.
-					storageBuffer->flush();              // Make buffer data visible to device.
-
-					// auto resources = mousePickingRenderSystem.getMousePickingResources();
-					renderer.beginRenderPass(commandBuffer, mousePickingRenderSystem.prepareRenderInfo());
-					// renderer.beginRenderPass(commandBuffer, resources.frameBuffer, resources.renderPass, VkRect2D{{0, 0}, renderer.getSwapChainExtent()}, clearValues);
-					mousePickingRenderSystem.render(frameInfo);
-					renderer.endRenderPass(commandBuffer);
-				}
+			RenderInfo mousePickingRenderInfo{};
+			VkCommandBuffer mousePickingCommands = VK_NULL_HANDLE;
+			if (renderGraph.isPassLive(frameGraph.mousePicking)) {
+				// Written into this frame index's readback slot and resolved when it comes around again.
+				mousePickingRenderSystem.beginPick(frameInfo.frameIndex);
+
+				mousePickingRenderInfo = mousePickingRenderSystem.prepareRenderInfo(frameInfo.frameIndex);
+				recordings.push_back(recordRenderPass(frameInfo, mousePickingRenderInfo, mousePickingCommands, [this](FrameInfo& passFrameInfo) {
+					mousePickingRenderSystem.render(passFrameInfo);
+				}));
+			}
+
+			// Wait for every recording before rethrowing, the jobs reference frameInfo.
+			for (auto& recording : recordings) {
+				recording.wait();
+			}
+			for (auto& recording : recordings) {
+				recording.get();
+			}
+
+			appState.recordTime = recordTimer.elapsedMillis();
+			appState.threadRecordTimes.resize(recordingStats.size());
+			appState.geometryBinds = 0;
+			appState.skippedBinds = 0;
+			for (size_t i = 0; i < recordingStats.size(); ++i) {
+				appState.threadRecordTimes[i] = recordingStats[i].recordTime;
+				appState.geometryBinds += static_cast<int>(recordingStats[i].geometryBinds);
+				appState.skippedBinds += static_cast<int>(recordingStats[i].skippedBinds);
 			}
 
+			// The passes recorded inline into the primary command buffer (ray tracing overlay, UI) share the frame sets.
+			globalRenderSystem.bindFrameDescriptorSets(frameInfo);
+
+			/*
+			    Execute the live passes in the graph's order, each after the barriers it needs.
+			*/
+			auto executeRenderPass = [this](VkCommandBuffer cmdBuffer, const RenderInfo& renderInfo, uint32_t count, const VkCommandBuffer* secondaries) {
+				renderer.beginRenderPass(cmdBuffer, renderInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				vkCmdExecuteCommands(cmdBuffer, count, secondaries);
+				renderer.endRenderPass(cmdBuffer);
+			};
+
+			renderGraph.setExecute(frameGraph.culling, [&](VkCommandBuffer) {
+				cullingRenderSystem.render(frameInfo, globalRenderSystem.getDrawList());
+			});
+			renderGraph.setExecute(frameGraph.depthPrePass, [&](VkCommandBuffer cmdBuffer) {
+				executeRenderPass(cmdBuffer, depthPrePassRenderInfo, 1, &depthPrePassCommands);
+			});
+			renderGraph.setExecute(frameGraph.depthPyramidPass, [&](VkCommandBuffer) {
+				cullingRenderSystem.buildDepthPyramid(frameInfo);
+			});
+			renderGraph.setExecute(frameGraph.occlusionCulling, [&](VkCommandBuffer) {
+				cullingRenderSystem.renderLate(frameInfo, globalRenderSystem.getDrawList());
+			});
+			renderGraph.setExecute(frameGraph.lateDepthPrePass, [&](VkCommandBuffer cmdBuffer) {
+				executeRenderPass(cmdBuffer, lateDepthPrePassRenderInfo, 1, &lateDepthPrePassCommands);
+			});
+
+			// The shadow passes draw only the tiles that changed, switching the viewport between them, so they are recorded inline.
+			renderGraph.setExecute(frameGraph.staticShadows, [&](VkCommandBuffer) {
+				shadowRenderSystem.renderStatic(frameInfo);
+			});
+			renderGraph.setExecute(frameGraph.shadowComposite, [&](VkCommandBuffer) {
+				shadowRenderSystem.composite(frameInfo);
+			});
+			renderGraph.setExecute(frameGraph.dynamicShadows, [&](VkCommandBuffer) {
+				shadowRenderSystem.renderDynamic(frameInfo);
+			});
+
+			/*
+			    Render Scene to texture - Offscreen rendering
+			*/
+			renderGraph.setExecute(frameGraph.scene, [&](VkCommandBuffer cmdBuffer) {
+				executeRenderPass(cmdBuffer, mainRenderInfo, static_cast<uint32_t>(mainCommands.size()), mainCommands.data());
+			});
+			renderGraph.setExecute(frameGraph.rayTracing, [&](VkCommandBuffer) {
+				rayTracingRenderSystem.render(frameInfo);
+			});
+			renderGraph.setExecute(frameGraph.rayTracingResolve, [&](VkCommandBuffer cmdBuffer) {
+				rayTracingRenderSystem.resolve(cmdBuffer);
+			});
+			renderGraph.setExecute(frameGraph.rayTracingOverlay, [&](VkCommandBuffer cmdBuffer) {
+				renderer.beginRenderPass(cmdBuffer, rayTracingRenderSystem.prepareRenderInfo());
+				pointLightRenderSystem.render(frameInfo);
+				if (drawOutline) {
+					outlineRenderSystem.render(frameInfo, selectedEntity);
+				}
+				renderer.endRenderPass(cmdBuffer);
+			});
+
+			renderGraph.setExecute(frameGraph.mousePicking, [&](VkCommandBuffer cmdBuffer) {
+				executeRenderPass(cmdBuffer, mousePickingRenderInfo, 1, &mousePickingCommands);
+			});
+
 			/*
 			    Render UI (also renders scene from texture into a UI window)
 			*/
-			{
-				renderer.beginPresentRenderPass(commandBuffer);
-				// simpleRenderSystem.render(frameInfo);
-				// pointLightRenderSystem.render(frameInfo);
+			renderGraph.setExecute(frameGraph.ui, [&](VkCommandBuffer cmdBuffer) {
+				renderer.beginPresentRenderPass(cmdBuffer);
 				uiRenderSystem.render(frameInfo, uiState, appState);
-				renderer.endRenderPass(commandBuffer);
+				renderer.endRenderPass(cmdBuffer);
+			});
+
+			renderGraph.execute(commandBuffer, &renderer.getProfiler());
+
+			{
+				const auto& graphStats = renderGraph.getStats();
+				appState.renderGraphPasses = static_cast<int>(graphStats.livePasses);
+				appState.renderGraphCulledPasses = static_cast<int>(graphStats.culledPasses);
+				appState.renderGraphBarriers = static_cast<int>(graphStats.imageBarriers + graphStats.memoryBarriers);
+				appState.renderGraphBarrierBatches = static_cast<int>(graphStats.barrierBatches);
+				appState.transientMemory = static_cast<double>(graphStats.transientMemory) / (1024.0 * 1024.0);
+				appState.transientMemoryUnaliased = static_cast<double>(graphStats.transientMemoryUnaliased) / (1024.0 * 1024.0);
 			}
 
 			renderer.endFrame();
 
-			if (mousePickingRead) {
-				mousePickingRead = false; // Reset bool.
+			// The first frame has been submitted, startup is over.
+			if (appState.timeToFirstFrame == 0.0) {
+				appState.timeToFirstFrame = startupTimeline.now();
+				startupTimeline.record("First frame", StartupTimeline::MAIN_THREAD, appState.startupTime, appState.timeToFirstFrame);
+				startupTimeline.print(std::cout);
+				std::cout << "Time to first frame: " << appState.timeToFirstFrame << " ms" << std::endl;
+			}
 
-				auto& storageBuffer = mousePickingRenderSystem.getStorageBuffer();
+			appState.geometryBinds += static_cast<int>(frameInfo.bindState.recordedBinds);
+			appState.skippedBinds += static_cast<int>(frameInfo.bindState.skippedBinds);
+		}
+		Input::OnUpdate(); // Update input manager state.
+	}
 
-				// std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	std::future<void> Application::recordRenderPass(const FrameInfo& frameInfo, const RenderInfo& renderInfo, VkCommandBuffer& commandBuffer, std::function<void(FrameInfo&)> record) {
+		auto job = [this, &frameInfo, renderInfo, &commandBuffer, record = std::move(record)](uint32_t threadIndex) {
+			ASPEN_PROFILE_SCOPE("Record render pass");
+			Timer timer{};
 
-				// Read from our SSBO buffer.
+			FrameInfo passFrameInfo = frameInfo;
+			passFrameInfo.commandBuffer = secondaryCommandBuffers.begin(frameInfo.frameIndex, threadIndex, renderInfo);
+			passFrameInfo.bindState = {};
 
-				MousePickingRenderSystem::MousePickingStorageBuffer ssbo{};
-				storageBuffer->invalidate();          // Make buffer data visible to host.
-				storageBuffer->readFromBuffer(&ssbo); // Read info from the SSBO.
+			// Secondary command buffers do not inherit bound state, so every pass binds the frame sets itself.
+			globalRenderSystem.bindFrameDescriptorSets(passFrameInfo);
+			record(passFrameInfo);
 
-				// auto group = m_Scene->getMetaDataComponents();
-				// auto& tagComponent = group.get<TagComponent>(static_cast<entt::entity>(ssbo.objectId));
-				// std::cout << "Entity ID: " << ssbo.objectId << ", Tag: " << tagComponent.tag << std::endl;
+			secondaryCommandBuffers.end(passFrameInfo.commandBuffer);
+			commandBuffer = passFrameInfo.commandBuffer;
 
-				if (ssbo.objectId != -1) {
-					uiState.selectedEntity.setEntity(static_cast<entt::entity>(ssbo.objectId));
-					uiState.gizmoVisible = true;
-				} else {
-					// std::cout << "Entity ID: " << ssbo.objectId << std::endl;
-					uiState.selectedEntity.setEntity(entt::null);
-					uiState.gizmoVisible = false;
-				}
-			}
+			auto& stats = recordingStats[threadIndex];
+			stats.recordTime += timer.elapsedMillis();
+			stats.geometryBinds += passFrameInfo.bindState.recordedBinds;
+			stats.skippedBinds += passFrameInfo.bindState.skippedBinds;
+		};
+
+		if (appState.parallelRecording) {
+			return threadPool.submit(std::move(job));
 		}
-		Input::OnUpdate(); // Update input manager state.
+
+		// Record on the main thread, with the pool after the workers'.
+		std::promise<void> recorded;
+		job(threadPool.getThreadCount());
+		recorded.set_value();
+		return recorded.get_future();
 	}
 
 	void Application::OnEvent(Event& e) {
@@ -394,6 +831,9 @@ namespace Aspen {
 					case Key::Escape:
 						m_Running = false; // Set flag to close the application.
 						break;
+					case Key::F5:
+						saveScene(SCENE_SNAPSHOT_PATH);
+						break;
 				}
 			}
 		} else if (e.GetEventType() == EventType::KeyReleased) {
@@ -413,7 +853,11 @@ namespace Aspen {
 				// Mouse Picking
 				case Mouse::Button0:
 					if ((!uiState.gizmoVisible || !ImGuizmo::IsOver()) && uiState.gizmoActive && uiState.viewportHovered) {
-						mousePicking = true;
+						if (appState.useCPUPicking) {
+							pickEntity();
+						} else {
+							mousePickingRenderSystem.requestPick(Input::GetMousePosition());
+						}
 					}
 					break;
 			}
@@ -421,29 +865,164 @@ namespace Aspen {
 		// std::cout << e.ToString() << std::endl;
 	}
 
+	// Cast a ray from the camera through the mouse cursor and select whatever it hits first.
+	void Application::pickEntity() {
+		Timer pickTimer{};
+		const Camera& camera = cameraEntity.getComponent<CameraComponent>().camera;
+
+		// The scene texture is drawn 1:1 at the swap chain extent, starting at the top-left corner of the viewport window.
+		glm::vec2 extent{renderer.getSwapChainExtent().width, renderer.getSwapChainExtent().height};
+		glm::vec2 mousePosition = Input::GetMousePosition() - uiState.viewportBounds[0];
+		glm::vec2 ndc = (mousePosition / extent) * 2.0f - 1.0f;
+
+		// Unproject the cursor onto the near and far planes (depth is in the 0-1 range).
+		glm::mat4 inverseProjView = camera.getInverseView() * camera.getInverseProjection();
+		glm::vec4 nearPoint = inverseProjView * glm::vec4(ndc, 0.0f, 1.0f);
+		glm::vec4 farPoint = inverseProjView * glm::vec4(ndc, 1.0f, 1.0f);
+		nearPoint /= nearPoint.w;
+		farPoint /= farPoint.w;
+
+		glm::vec3 rayDirection = glm::vec3(farPoint) - glm::vec3(nearPoint);
+		float maxDistance = glm::length(rayDirection);
+		RayHit hit = m_Scene->rayCast(Math::Ray{glm::vec3(nearPoint), rayDirection / maxDistance}, maxDistance);
+
+		if (hit) {
+			uiState.selectedEntity.setEntity(hit.entity);
+			uiState.gizmoVisible = true;
+		} else {
+			uiState.selectedEntity.setEntity(entt::null);
+			uiState.gizmoVisible = false;
+		}
+
+		appState.mousePickingTime = pickTimer.elapsedMillis();
+	}
+
+	bool Application::loadScene(const std::string& filePath) {
+		ASPEN_PROFILE_SCOPE("Application::loadScene");
+		if (!std::filesystem::exists(filePath)) {
+			return false;
+		}
+
+		Timer loadTimer{};
+		if (!SceneSerializer(*m_Scene).deserialize(filePath)) {
+			return false;
+		}
+
+		std::cout << "Loaded scene snapshot " << filePath << " in " << loadTimer.elapsedMillis() << " ms" << std::endl;
+		return true;
+	}
+
+	void Application::saveScene(const std::string& filePath) {
+		Timer saveTimer{};
+		if (SceneSerializer(*m_Scene).serialize(filePath)) {
+			std::cout << "Saved scene snapshot " << filePath << " in " << saveTimer.elapsedMillis() << " ms" << std::endl;
+		}
+	}
+
+	void Application::generateStressScene(const StressSceneSettings& settings) {
+		Timer generateTimer{};
+		Math::AABB bounds = SceneGenerator(*m_Scene).generate(settings);
+		std::cout << "Generated " << settings.entityCount << " entities and " << settings.pointLightCount << " point lights (seed " << settings.seed << ") in " << generateTimer.elapsedMillis() << " ms" << std::endl;
+
+		// Frame the whole scene.
+		if (bounds.isValid()) {
+			auto& camController = cameraEntity.getComponent<CameraControllerArcball>();
+			camController.offset = glm::vec3{0.0f};
+			camController.focalPoint = bounds.center();
+			camController.distance = glm::length(bounds.max - bounds.min) + 2.0f;
+		}
+	}
+
+	// Builds the scene wide GPU data once all renderable entities exist.
+	void Application::finalizeScene() {
+		appState.totalVertexCount = 0;
+		appState.totalIndexCount = 0;
+
+		auto group = m_Scene->getRenderComponents();
+		for (const auto& entity : group) {
+			auto& mesh = group.get<MeshComponent>(entity);
+			appState.totalVertexCount += static_cast<int>(mesh.geometry->vertices.size());
+			appState.totalIndexCount += static_cast<int>(mesh.geometry->indices.size());
+		}
+
+		m_Scene->updateSceneData();
+
+		// Assign these textures to render systems.
+		simpleRenderSystem.assignTextures(*m_Scene);
+		rayTracingRenderSystem.createAccelerationStructures(m_Scene);
+		rayTracingRenderSystem.assignTextures(*m_Scene);
+	}
+
+	// Compares creating entities one at a time against the bulk API, each in a fresh scene and both with the same tag.
+	// Both runs show up in the startup timeline, the throughput is printed right away.
+	void Application::benchmarkEntitySpawning(uint32_t count) {
+		std::vector<TransformComponent> transforms(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			transforms[i].translation = glm::vec3(static_cast<float>(i % 100), 0.0f, static_cast<float>(i / 100));
+		}
+
+		const std::string suffix = " (" + std::to_string(count) + " entities)";
+		double singleTime;
+		{
+			Scene scene{device};
+			double start = startupTimeline.now();
+			{
+				StartupTimeline::Scope scope{startupTimeline, "createEntity" + suffix};
+				for (uint32_t i = 0; i < count; ++i) {
+					Entity entity = scene.createEntity("Benchmark");
+					entity.getComponent<TransformComponent>() = transforms[i];
+				}
+			}
+			singleTime = startupTimeline.now() - start;
+		}
+
+		double bulkTime;
+		{
+			Scene scene{device};
+			double start = startupTimeline.now();
+			{
+				StartupTimeline::Scope scope{startupTimeline, "createEntities" + suffix};
+				scene.createEntities(count, transforms, "Benchmark");
+			}
+			bulkTime = startupTimeline.now() - start;
+		}
+
+		std::cout << "Entity spawning" << suffix << ":" << std::endl;
+		std::cout << "    createEntity:   " << singleTime << " ms, " << count / (singleTime / 1000.0) << " entities/s" << std::endl;
+		std::cout << "    createEntities: " << bulkTime << " ms, " << count / (bulkTime / 1000.0) << " entities/s (" << singleTime / bulkTime << "x)" << std::endl;
+	}
+
 	bool Application::OnWindowClose(WindowCloseEvent& e) {
 		m_Running = false;
 		return true;
 	}
 
+	// The offscreen targets only grow, a smaller window renders into their top left corner. Most resizes therefore only
+	// recreate the swap chain, and the frames in flight keep running while it is replaced.
 	bool Application::OnWindowResize(WindowResizeEvent& e) {
-		vkDeviceWaitIdle(device.device());
-
+		ASPEN_PROFILE_SCOPE("Application::OnWindowResize");
 		window.resetWindowResizedFlag();
 		renderer.recreateSwapChain();
-		depthPrePassRenderSystem.onResize();
-		simpleRenderSystem.onResize();
-		rayTracingRenderSystem.onResize();
-		mousePickingRenderSystem.onResize();
 
 		uiState.viewportSize = glm::vec2(renderer.getSwapChainExtent().width, renderer.getSwapChainExtent().height);
 
-		if (!appState.useRayTracer) {
-			std::shared_ptr<Framebuffer> offscreenPass = simpleRenderSystem.getResources();
-			uiState.viewportTexture = ImGui_ImplVulkan_UpdateTexture(uiState.viewportTexture, offscreenPass->sampler, offscreenPass->attachments[0].view, offscreenPass->attachments[0].description.finalLayout);
-		} else {
-			std::shared_ptr<Framebuffer> offscreenRayTracingPass = rayTracingRenderSystem.getResources();
-			uiState.viewportTexture = ImGui_ImplVulkan_UpdateTexture(uiState.viewportTexture, offscreenRayTracingPass->sampler, offscreenRayTracingPass->attachments[0].view, offscreenRayTracingPass->attachments[0].description.finalLayout);
+		if (renderer.fitTargetExtent()) {
+			renderer.waitForFrames(); // They still use the images the render graph is about to destroy.
+			renderGraph.bake(renderer.getTargetExtent());
+			depthPrePassRenderSystem.onResize();
+			cullingRenderSystem.onResize();
+			shadowRenderSystem.onResize();
+			simpleRenderSystem.onResize();
+			rayTracingRenderSystem.onResize();
+			mousePickingRenderSystem.onResize();
+
+			if (!appState.useRayTracer) {
+				std::shared_ptr<Framebuffer> offscreenPass = simpleRenderSystem.getResources();
+				uiState.viewportTexture = ImGui_ImplVulkan_UpdateTexture(uiState.viewportTexture, offscreenPass->sampler, offscreenPass->attachments[0].view, offscreenPass->attachments[0].description.finalLayout);
+			} else {
+				std::shared_ptr<Framebuffer> offscreenRayTracingPass = rayTracingRenderSystem.getResources();
+				uiState.viewportTexture = ImGui_ImplVulkan_UpdateTexture(uiState.viewportTexture, offscreenRayTracingPass->sampler, offscreenRayTracingPass->attachments[0].view, offscreenRayTracingPass->attachments[0].description.finalLayout);
+			}
 		}
 
 		// createPipeline(); // Right now this is not required as the new render pass will be compatible with the old one but is put here for future proofing.
@@ -469,7 +1048,7 @@ namespace Aspen {
 	}
 
 	// Temporary helper function, creates a 1x1x1 cube centered at offset
-	void createCubeModel(Device& device, glm::vec3 offset, MeshComponent& meshComponent) {
+	void createCubeModel(Device& device, glm::vec3 offset, MeshComponent::Geometry& meshComponent) {
 		meshComponent.vertices = {
 
 		    // Left face (orange)
@@ -533,7 +1112,7 @@ namespace Aspen {
 	}
 
 	// Temporary helper function, creates a quad.
-	void createFloorModel(Device& device, glm::vec3 offset, MeshComponent& meshComponent) {
+	void createFloorModel(Device& device, glm::vec3 offset, MeshComponent::Geometry& meshComponent) {
 		meshComponent.vertices = {
 
 		    // Top face (blue, remember y axis points down)
@@ -554,7 +1133,29 @@ namespace Aspen {
 		Aspen::Model::makeBuffer(device, meshComponent);
 	}
 
+	// Starts decoding the meshes and textures of the default scene on the worker threads, while the pipelines are being built.
+	void Application::prefetchDefaultSceneAssets() {
+		for (const char* filePath : DEFAULT_SCENE_MODELS) {
+			assetLoader.prefetchModel(filePath);
+		}
+		for (const char* filePath : DEFAULT_SCENE_TEXTURES) {
+			assetLoader.prefetchImage(filePath);
+		}
+	}
+
 	void Application::loadEntities() {
+		// The files were decoded on the worker threads, see prefetchDefaultSceneAssets(). Only the uploads happen here.
+		// Every model is uploaded once, entities using the same file share its geometry and are drawn as instances of it.
+		std::unordered_map<std::string, std::shared_ptr<MeshComponent::Geometry>> geometries;
+		for (const char* filePath : DEFAULT_SCENE_MODELS) {
+			auto& geometry = geometries[filePath] = std::make_shared<MeshComponent::Geometry>();
+			assetLoader.loadModel(*geometry, filePath);
+			Model::makeBuffer(device, *geometry);
+		}
+		auto loadTexture = [&](Texture2D& texture, const std::string& filePath) {
+			return m_Scene->addTexture(texture, assetLoader.loadImage(filePath), filePath, VK_FORMAT_R8G8B8A8_SRGB, device.graphicsQueue());
+		};
+
 		// // Create Floor
 		// {
 		// 	floor = m_Scene->createEntity("Floor");
@@ -581,13 +1182,9 @@ namespace Aspen {
 				objectTransform.rotation *= glm::angleAxis(glm::radians(10.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 				objectTransform.scale = {2.0f, 2.0f, 2.0f};
 
-				auto& objectMesh = object.addComponent<MeshComponent>();
-				Model::createModelFromFile(device, objectMesh, "assets/models/smooth_vase.obj");
-				auto texID = m_Scene->addTexture(objectMesh.texture, "assets/textures/LaticeWall.png", VK_FORMAT_R8G8B8A8_SRGB, device.graphicsQueue());
-				std::cout << "Vase 1 Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-				appState.totalVertexCount += objectMesh.vertices.size();
-				appState.totalIndexCount += objectMesh.indices.size();
+				auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(VASE_MODEL));
+				auto texID = loadTexture(objectMesh.texture, LATTICE_WALL_TEXTURE);
+				std::cout << "Vase 1 Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 				auto& objectMaterial = object.addComponent<MaterialComponent>();
 				objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -601,13 +1198,9 @@ namespace Aspen {
 			objectTransform.translation = {0.36f, 0.0f, 1.23f};
 			objectTransform.scale = {2.0f, 2.0f, 2.0f};
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/smooth_vase.obj");
-			auto texID = m_Scene->addTexture(objectMesh.texture, "assets/textures/RustedPlates.png", VK_FORMAT_R8G8B8A8_SRGB, device.graphicsQueue());
-			std::cout << "Vase 2 Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(VASE_MODEL));
+			auto texID = loadTexture(objectMesh.texture, RUSTED_PLATES_TEXTURE);
+			std::cout << "Vase 2 Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -625,13 +1218,9 @@ namespace Aspen {
 				objectTransform.rotation = glm::angleAxis(glm::radians(45.0f), glm::vec3(0.0f, -1.0f, 0.0f));
 				objectTransform.scale = glm::vec3(0.5f);
 
-				auto& objectMesh = object.addComponent<MeshComponent>();
-				Model::createModelFromFile(device, objectMesh, "assets/models/cube.obj");
-				auto texID = m_Scene->addTexture(objectMesh.texture, "assets/textures/Wool.jpg", VK_FORMAT_R8G8B8A8_SRGB, device.graphicsQueue());
-				std::cout << "Cube 1 Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-				appState.totalVertexCount += objectMesh.vertices.size();
-				appState.totalIndexCount += objectMesh.indices.size();
+				auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(CUBE_MODEL));
+				auto texID = loadTexture(objectMesh.texture, WOOL_TEXTURE);
+				std::cout << "Cube 1 Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 				auto& objectMaterial = object.addComponent<MaterialComponent>();
 				objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -646,12 +1235,8 @@ namespace Aspen {
 			objectTransform.rotation = glm::angleAxis(glm::radians(-45.0f), glm::vec3(0.0f, -1.0f, 0.0f));
 			objectTransform.scale = glm::vec3(0.5f, 1.0f, 0.5f);
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/cube.obj");
-			std::cout << "Cube 2 Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(CUBE_MODEL));
+			std::cout << "Cube 2 Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -667,11 +1252,8 @@ namespace Aspen {
 			objectTransform.scale = glm::vec3(5.5f);
 
 			auto& objectMesh = object.addComponent<MeshComponent>();
-			createCubeModel(device, {0.0f, 0.0f, 0.0f}, objectMesh);
-			std::cout << "Cornell Box Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			createCubeModel(device, {0.0f, 0.0f, 0.0f}, *objectMesh.geometry);
+			std::cout << "Cornell Box Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -686,13 +1268,9 @@ namespace Aspen {
 			objectTransform.rotation = glm::angleAxis(glm::radians(100.0f), glm::vec3(0.0f, -1.0f, 0.0f));
 			objectTransform.scale = glm::vec3(3.5f);
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/dragon-lowres2.obj");
-			auto texID = m_Scene->addTexture(objectMesh.texture, "assets/textures/Ceramic.png", VK_FORMAT_R8G8B8A8_SRGB, device.graphicsQueue());
-			std::cout << "Chinese Dragon Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(DRAGON_MODEL));
+			auto texID = loadTexture(objectMesh.texture, CERAMIC_TEXTURE);
+			std::cout << "Chinese Dragon Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Lambertian;
@@ -709,12 +1287,8 @@ namespace Aspen {
 			objectTransform.translation = {1.0f, -3.0f, 4.0f};
 			objectTransform.scale = glm::vec3(1.0f);
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/UV-Sphere.obj");
-			std::cout << "Sphere Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(SPHERE_MODEL));
+			std::cout << "Sphere Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Metallic;
@@ -729,12 +1303,8 @@ namespace Aspen {
 			objectTransform.translation = {-1.5f, -2.0f, 4.25f};
 			objectTransform.scale = glm::vec3(0.1f);
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/teapot.obj");
-			std::cout << "Teapot Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(TEAPOT_MODEL));
+			std::cout << "Teapot Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Metallic;
@@ -750,12 +1320,8 @@ namespace Aspen {
 			objectTransform.rotation = glm::angleAxis(glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 			objectTransform.scale = glm::vec3(0.6f);
 
-			auto& objectMesh = object.addComponent<MeshComponent>();
-			Model::createModelFromFile(device, objectMesh, "assets/models/bunny.obj");
-			std::cout << "Bunny Vertex Count: " << objectMesh.vertices.size() << std::endl;
-
-			appState.totalVertexCount += objectMesh.vertices.size();
-			appState.totalIndexCount += objectMesh.indices.size();
+			auto& objectMesh = object.addComponent<MeshComponent>(geometries.at(BUNNY_MODEL));
+			std::cout << "Bunny Vertex Count: " << objectMesh.geometry->vertices.size() << std::endl;
 
 			auto& objectMaterial = object.addComponent<MaterialComponent>();
 			objectMaterial.materialModel = MaterialComponent::MaterialType::Dielectric;
@@ -765,13 +1331,6 @@ namespace Aspen {
 			objectMaterial.refractionIndex = 1.31f; // Water/Ice
 		}
 
-		m_Scene->updateSceneData();
-
-		// Assign these textures to render systems.
-		simpleRenderSystem.assignTextures(*m_Scene);
-		rayTracingRenderSystem.createAccelerationStructures(m_Scene);
-		rayTracingRenderSystem.assignTextures(*m_Scene);
-
 		// Create point lights
 		{
 			// https://www.color-hex.com/color-palette/5361
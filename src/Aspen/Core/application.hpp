@@ -1,7 +1,14 @@
 #pragma once
 #include "pch.h"
 
+#include <filesystem>
+
 #include "Aspen/Core/timer.hpp"
+#include "Aspen/Core/thread_pool.hpp"
+#include "Aspen/Core/startup_timeline.hpp"
+#include "Aspen/Core/asset_loader.hpp"
+#include "Aspen/Renderer/secondary_command_buffers.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
 #include "Aspen/Renderer/System/simple_render_system.hpp"
 #include "Aspen/Renderer/System/point_light_render_system.hpp"
 #include "Aspen/Renderer/System/ui_render_system.hpp"
@@ -10,7 +17,11 @@
 #include "Aspen/Renderer/System/shadow_render_system.hpp"
 #include "Aspen/Renderer/System/outline_render_system.hpp"
 #include "Aspen/Renderer/System/ray_tracing_render_system.hpp"
+#include "Aspen/Renderer/System/culling_render_system.hpp"
 #include "Aspen/Scene/entity.hpp"
+#include "Aspen/Scene/entity_command_buffer.hpp"
+#include "Aspen/Scene/scene_serializer.hpp"
+#include "Aspen/Scene/scene_generator.hpp"
 #include "Aspen/System/camera_controller_system.hpp"
 #include "Aspen/System/camera_system.hpp"
 
@@ -22,8 +33,10 @@ namespace Aspen {
 	public:
 		static constexpr int WIDTH = 1280;
 		static constexpr int HEIGHT = 720;
+		static constexpr const char* SCENE_SNAPSHOT_PATH = "assets/scene.snapshot";
+		static constexpr uint32_t MIN_BATCHES_PER_RECORDING = 64; // The main pass is only split when every piece gets at least this many batches.
 
-		Application();
+		Application(const std::optional<StressSceneSettings>& stressScene = std::nullopt, uint32_t spawnBenchmarkCount = 0);
 		~Application();
 
 		Application(const Application&) = delete;
@@ -45,14 +58,27 @@ namespace Aspen {
 		}
 
 	private:
+		void prefetchDefaultSceneAssets();
 		void loadEntities();
+		bool loadScene(const std::string& filePath);
+		void saveScene(const std::string& filePath);
+		void generateStressScene(const StressSceneSettings& settings);
+		void finalizeScene();
+		void pickEntity();
+		void benchmarkEntitySpawning(uint32_t count);
 		void renderUI(VkCommandBuffer commandBuffer, Camera camera);
+		struct FrameGraph;
+		FrameGraph createRenderGraph();
+		std::vector<std::future<void>> buildPipelines();
+		std::future<void> recordRenderPass(const FrameInfo& frameInfo, const RenderInfo& renderInfo, VkCommandBuffer& commandBuffer, std::function<void(FrameInfo&)> record);
 		void setupImGui();
 		bool OnWindowClose(WindowCloseEvent& e);
 		bool OnWindowResize(WindowResizeEvent& e);
 
 		inline static Application* s_Instance = nullptr;
 
+		StartupTimeline startupTimeline{}; // First, so it starts before the window and device are created.
+
 		ApplicationState appState{};
 		UIState uiState{};
 
@@ -60,6 +86,48 @@ namespace Aspen {
 		Device device{window};
 		Renderer renderer{window, device, !appState.enable_vsync};
 
+		// Render passes are recorded into secondary command buffers by the workers. The last pool belongs to the main thread,
+		// which records everything itself when parallel recording is disabled.
+		struct RecordingStats {
+			double recordTime = 0.0;
+			uint32_t geometryBinds = 0;
+			uint32_t skippedBinds = 0;
+		};
+		ThreadPool threadPool{};
+		AssetLoader assetLoader{threadPool, startupTimeline};
+		SecondaryCommandBuffers secondaryCommandBuffers{device, threadPool.getThreadCount() + 1};
+		std::vector<RecordingStats> recordingStats; // Indexed by thread, every thread only writes its own entry.
+
+		// The frame's passes and the images they share, declared once in createRenderGraph().
+		struct FrameGraph {
+			RenderGraph::ResourceHandle sceneDepth;
+			RenderGraph::ResourceHandle depthPyramidImage;
+			RenderGraph::ResourceHandle staticShadowMap;
+			RenderGraph::ResourceHandle shadowMap;
+			RenderGraph::ResourceHandle sceneColor;
+			RenderGraph::ResourceHandle rayTracingOutput;
+			RenderGraph::ResourceHandle rayTracingColor;
+			RenderGraph::ResourceHandle culledDraws;
+			RenderGraph::ResourceHandle pickResult;
+
+			RenderGraph::PassHandle culling;
+			RenderGraph::PassHandle depthPrePass;
+			RenderGraph::PassHandle depthPyramidPass;
+			RenderGraph::PassHandle occlusionCulling;
+			RenderGraph::PassHandle lateDepthPrePass;
+			RenderGraph::PassHandle staticShadows;
+			RenderGraph::PassHandle shadowComposite;
+			RenderGraph::PassHandle dynamicShadows;
+			RenderGraph::PassHandle scene;
+			RenderGraph::PassHandle rayTracing;
+			RenderGraph::PassHandle rayTracingResolve;
+			RenderGraph::PassHandle rayTracingOverlay;
+			RenderGraph::PassHandle mousePicking;
+			RenderGraph::PassHandle ui;
+		};
+		RenderGraph renderGraph{device};
+		FrameGraph frameGraph = createRenderGraph();
+
 		Timer timer{};
 		float fpsUpdateCooldown = 1.0f;
 
@@ -69,27 +137,43 @@ namespace Aspen {
 
 		std::shared_ptr<Scene> m_Scene;
 
-		bool mousePicking = false;
-
 		GlobalRenderSystem globalRenderSystem{device, renderer};
+		CullingRenderSystem cullingRenderSystem{
+		    device,
+		    renderer,
+		    globalRenderSystem.getDescriptorSetLayout(),
+		    renderGraph,
+		    frameGraph.sceneDepth,
+		    frameGraph.depthPyramidImage};
 		DepthPrePassRenderSystem depthPrePassRenderSystem{
 		    device,
 		    renderer,
-		    globalRenderSystem.getDescriptorSetLayout()};
+		    globalRenderSystem.getDescriptorSetLayout(),
+		    renderGraph,
+		    frameGraph.sceneDepth};
 		ShadowRenderSystem shadowRenderSystem{
 		    device,
 		    renderer,
-		    globalRenderSystem.getDescriptorSetLayout()};
+		    globalRenderSystem.getDescriptorSetLayout(),
+		    renderGraph,
+		    frameGraph.staticShadowMap,
+		    frameGraph.shadowMap};
 		SimpleRenderSystem simpleRenderSystem{
 		    device,
 		    renderer,
 		    globalRenderSystem.getDescriptorSetLayout(),
+		    renderGraph,
+		    frameGraph.sceneColor,
 		    depthPrePassRenderSystem.getResources(),
-		    shadowRenderSystem.getResources()};
+		    shadowRenderSystem.getResources(),
+		    shadowRenderSystem.getUboDescriptorInfos()};
 		RayTracingRenderSystem rayTracingRenderSystem{
 		    device,
 		    renderer,
 		    globalRenderSystem.getDescriptorSetLayout(),
+		    renderGraph,
+		    frameGraph.rayTracingOutput,
+		    frameGraph.rayTracingColor,
 		    depthPrePassRenderSystem.getResources()};
 		PointLightRenderSystem pointLightRenderSystem{
 		    device,
@@ -0,0 +1,87 @@
+#include "Aspen/Core/asset_loader.hpp"
+
+#include "Aspen/Core/cpu_profiler.hpp"
+
+namespace Aspen {
+	AssetLoader::~AssetLoader() {
+		clear();
+	}
+
+	void AssetLoader::prefetchModel(const std::string& filePath) {
+		auto& pending = models[filePath];
+		if (pending) {
+			return;
+		}
+
+		pending = std::make_unique<PendingModel>();
+		auto job = [this, &geometry = pending->geometry, filePath](uint32_t threadIndex) {
+			StartupTimeline::Scope scope{timeline, "Decode " + filePath, threadIndex};
+			Model::loadModelFromFile(geometry, filePath);
+		};
+		pending->done = threadPool.submit(std::move(job)).share();
+	}
+
+	void AssetLoader::prefetchImage(const std::string& filePath) {
+		auto& pending = images[filePath];
+		if (pending) {
+			return;
+		}
+
+		pending = std::make_unique<PendingImage>();
+		auto job = [this, &image = pending->image, filePath](uint32_t threadIndex) {
+			StartupTimeline::Scope scope{timeline, "Decode " + filePath, threadIndex};
+			Texture::loadImage(filePath, image);
+		};
+		pending->done = threadPool.submit(std::move(job)).share();
+	}
+
+	void AssetLoader::loadModel(MeshComponent::Geometry& mesh, const std::string& filePath) {
+		ASPEN_PROFILE_SCOPE("AssetLoader::loadModel");
+		auto& pending = models[filePath];
+		if (!pending) {
+			pending = std::make_unique<PendingModel>();
+			Model::loadModelFromFile(pending->geometry, filePath);
+		} else if (pending->done.valid()) {
+			pending->done.get(); // Rethrows if decoding failed.
+		}
+
+		const MeshComponent::Geometry& decoded = pending->geometry;
+		mesh.vertices = decoded.vertices;
+		mesh.indices = decoded.indices;
+		mesh.assetPath = decoded.assetPath;
+		mesh.assetHash = decoded.assetHash;
+	}
+
+	const ImageProperties& AssetLoader::loadImage(const std::string& filePath) {
+		ASPEN_PROFILE_SCOPE("AssetLoader::loadImage");
+		auto& pending = images[filePath];
+		if (!pending) {
+			pending = std::make_unique<PendingImage>();
+			Texture::loadImage(filePath, pending->image);
+		} else if (pending->done.valid()) {
+			pending->done.get(); // Rethrows if decoding failed.
+		}
+
+		return pending->image;
+	}
+
+	void AssetLoader::clear() {
+		// The jobs write into the entries, so they have to finish before they are freed.
+		for (auto& [filePath, pending] : models) {
+			if (pending->done.valid()) {
+				pending->done.wait();
+			}
+		}
+		for (auto& [filePath, pending] : images) {
+			if (pending->done.valid()) {
+				pending->done.wait();
+			}
+			if (pending->image.pixels) {
+				Texture::freeImage(pending->image);
+			}
+		}
+
+		models.clear();
+		images.clear();
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Core/model.hpp"
+#include "Aspen/Core/startup_timeline.hpp"
+#include "Aspen/Core/thread_pool.hpp"
+#include "Aspen/Renderer/texture.hpp"
+
+namespace Aspen {
+	// Decodes meshes and textures on the worker threads ahead of the code that uploads them.
+	//
+	// Decoding only touches CPU memory, so it can start before the device is ready for uploads. The GPU side (buffers,
+	// images and the copies into them) stays on the main thread, which owns the queues. A file requested without being
+	// prefetched is decoded on the calling thread, and a file used several times is only decoded once.
+	class AssetLoader {
+	public:
+		AssetLoader(ThreadPool& threadPool, StartupTimeline& timeline)
+		    : threadPool(threadPool), timeline(timeline) {}
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) = delete;            // Move Constructor
+		AssetLoader& operator=(AssetLoader&&) = delete; // Move Assignment Operator
+
+		void prefetchModel(const std::string& filePath);
+		void prefetchImage(const std::string& filePath);
+
+		// Copies the decoded model into the geometry's CPU side arrays, waiting for it if it is still being decoded.
+		void loadModel(MeshComponent::Geometry& mesh, const std::string& filePath);
+		// The decoded image stays owned by the loader until clear().
+		const ImageProperties& loadImage(const std::string& filePath);
+
+		// Frees everything decoded so far, once it has been uploaded. Waits for decodes still in flight.
+		void clear();
+
+	private:
+		// Written by one job, read by the main thread once done is ready.
+		struct PendingModel {
+			std::shared_future<void> done;
+			MeshComponent::Geometry geometry;
+		};
+		struct PendingImage {
+			std::shared_future<void> done;
+			ImageProperties image{};
+		};
+
+		ThreadPool& threadPool;
+		StartupTimeline& timeline;
+
+		// Only accessed from the main thread, the jobs hold on to their own entry.
+		std::unordered_map<std::string, std::unique_ptr<PendingModel>> models;
+		std::unordered_map<std::string, std::unique_ptr<PendingImage>> images;
+	};
+} // namespace Aspen
\ No newline at end of file
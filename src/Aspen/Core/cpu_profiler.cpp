@@ -0,0 +1,167 @@
+#include "Aspen/Core/cpu_profiler.hpp"
+
+#include <iomanip>
+#include <mutex>
+
+namespace Aspen {
+	namespace {
+		// Written by its own thread only, read by the thread collecting the frame.
+		struct ThreadBuffer {
+			std::array<CpuProfiler::Event, CpuProfiler::EVENT_CAPACITY> events{};
+			std::atomic<uint64_t> written{0};
+			uint64_t collected = 0; // Collecting thread only.
+			uint32_t depth = 0;     // Owning thread only.
+			uint32_t index = 0;
+			std::string name; // Guarded by registryMutex.
+		};
+
+		const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+		std::unordered_set<std::string> internedNames;
+		thread_local ThreadBuffer* localBuffer = nullptr;
+
+		// Main thread only.
+		CpuProfiler::Frame lastFrame;
+		uint32_t captureFramesLeft = 0;
+		std::string capturePath;
+		std::vector<CpuProfiler::Event> capturedEvents;
+
+		ThreadBuffer& getLocalBuffer() {
+			if (localBuffer == nullptr) {
+				std::lock_guard<std::mutex> lock{registryMutex};
+				auto& buffer = threadBuffers.emplace_back(std::make_unique<ThreadBuffer>());
+				buffer->index = static_cast<uint32_t>(threadBuffers.size() - 1);
+				buffer->name = "Thread " + std::to_string(buffer->index);
+				localBuffer = buffer.get();
+			}
+			return *localBuffer;
+		}
+
+		void writeJsonString(std::ostream& stream, const std::string& value) {
+			stream << '"';
+			for (char c : value) {
+				if (c == '"' || c == '\\') {
+					stream << '\\' << c;
+				} else if (static_cast<unsigned char>(c) < 0x20) {
+					stream << ' ';
+				} else {
+					stream << c;
+				}
+			}
+			stream << '"';
+		}
+
+		// Complete events ("ph": "X") in microseconds, see the Trace Event Format.
+		void writeTrace(const std::string& filePath, const std::vector<CpuProfiler::Event>& events) {
+			std::ofstream file{filePath, std::ios::trunc};
+			if (!file.is_open()) {
+				std::cout << "Failed to write CPU trace " << filePath << std::endl;
+				return;
+			}
+
+			file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			const auto threadNames = CpuProfiler::getThreadNames();
+			for (size_t thread = 0; thread < threadNames.size(); thread++) {
+				file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":";
+				writeJsonString(file, threadNames[thread]);
+				file << "}},\n";
+			}
+			for (size_t i = 0; i < events.size(); i++) {
+				const auto& event = events[i];
+				file << "{\"name\":";
+				writeJsonString(file, event.name);
+				file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << static_cast<double>(event.start) / 1e3
+				     << ",\"dur\":" << static_cast<double>(event.end - event.start) / 1e3 << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+			}
+			file << "]}\n";
+
+			std::cout << "Wrote " << events.size() << " CPU profiler events to " << filePath << std::endl;
+		}
+	} // namespace
+
+	void CpuProfiler::Scope::begin(const char* scopeName) {
+		name = scopeName;
+		getLocalBuffer().depth++;
+		start = now();
+	}
+
+	void CpuProfiler::Scope::end() {
+		const int64_t endTime = now();
+		ThreadBuffer& buffer = getLocalBuffer();
+		buffer.depth--;
+
+		// Single producer, so only the collecting thread can race with this, and only if it falls a whole buffer behind.
+		const uint64_t slot = buffer.written.load(std::memory_order_relaxed);
+		buffer.events[slot % EVENT_CAPACITY] = {name, start, endTime, buffer.depth, buffer.index};
+		buffer.written.store(slot + 1, std::memory_order_release);
+	}
+
+	int64_t CpuProfiler::now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	const char* CpuProfiler::intern(const std::string& name) {
+		std::lock_guard<std::mutex> lock{registryMutex};
+		return internedNames.insert(name).first->c_str();
+	}
+
+	void CpuProfiler::setThreadName(const std::string& name) {
+		ThreadBuffer& buffer = getLocalBuffer();
+		std::lock_guard<std::mutex> lock{registryMutex};
+		buffer.name = name;
+	}
+
+	std::vector<std::string> CpuProfiler::getThreadNames() {
+		std::lock_guard<std::mutex> lock{registryMutex};
+		std::vector<std::string> names;
+		names.reserve(threadBuffers.size());
+		for (const auto& buffer : threadBuffers) {
+			names.push_back(buffer->name);
+		}
+		return names;
+	}
+
+	void CpuProfiler::endFrame() {
+		const int64_t frameEnd = now();
+		lastFrame.start = lastFrame.end;
+		lastFrame.end = frameEnd;
+		lastFrame.events.clear();
+
+		{
+			std::lock_guard<std::mutex> lock{registryMutex}; // Only for the list of buffers, their events are lock free.
+			for (auto& buffer : threadBuffers) {
+				const uint64_t written = buffer->written.load(std::memory_order_acquire);
+				const uint64_t first = std::max(buffer->collected, written > EVENT_CAPACITY ? written - EVENT_CAPACITY : 0);
+				for (uint64_t i = first; i < written; i++) {
+					lastFrame.events.push_back(buffer->events[i % EVENT_CAPACITY]);
+				}
+				buffer->collected = written;
+			}
+		}
+
+		if (captureFramesLeft > 0) {
+			capturedEvents.insert(capturedEvents.end(), lastFrame.events.begin(), lastFrame.events.end());
+			if (--captureFramesLeft == 0) {
+				writeTrace(capturePath, capturedEvents);
+				capturedEvents.clear();
+				capturedEvents.shrink_to_fit();
+			}
+		}
+	}
+
+	const CpuProfiler::Frame& CpuProfiler::getLastFrame() {
+		return lastFrame;
+	}
+
+	void CpuProfiler::startCapture(uint32_t frameCount, const std::string& filePath) {
+		captureFramesLeft = frameCount;
+		capturePath = filePath;
+		capturedEvents.clear();
+	}
+
+	bool CpuProfiler::isCapturing() {
+		return captureFramesLeft > 0;
+	}
+} // namespace Aspen
\ No newline at end of file
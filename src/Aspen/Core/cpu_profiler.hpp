@@ -0,0 +1,94 @@
+#pragma once
+#include "pch.h"
+
+#include <atomic>
+
+// Records how long the enclosing scope takes on the calling thread. The name must outlive the profiler, use a string
+// literal or CpuProfiler::intern(). Define ASPEN_DISABLE_PROFILING to compile every scope out.
+#ifndef ASPEN_DISABLE_PROFILING
+#define ASPEN_PROFILE_CONCAT_INNER(a, b) a##b
+#define ASPEN_PROFILE_CONCAT(a, b) ASPEN_PROFILE_CONCAT_INNER(a, b)
+#define ASPEN_PROFILE_SCOPE(name) ::Aspen::CpuProfiler::Scope ASPEN_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define ASPEN_PROFILE_SCOPE(name)
+#endif
+
+namespace Aspen {
+	// Low overhead CPU instrumentation for the frame loop and startup.
+	//
+	// Every thread writes the scopes it ends into its own ring buffer without locking. endFrame(), called once a frame on
+	// the main thread, collects what every thread wrote since the last call. The last frame is kept for the timeline in the
+	// metrics window, and a capture writes the frames it covers as a Chrome trace for chrome://tracing or Perfetto. The
+	// first collection also holds everything recorded during startup.
+	// While profiling is disabled a scope costs one relaxed atomic load.
+	class CpuProfiler {
+	public:
+		static constexpr uint32_t EVENT_CAPACITY = 1 << 14; // Per thread, the oldest events are lost if not collected in time.
+		static constexpr const char* TRACE_PATH = "cpu_trace.json";
+
+		struct Event {
+			const char* name;
+			int64_t start; // Nanoseconds since the profiler started.
+			int64_t end;
+			uint32_t depth;  // Scopes it is nested in on its thread.
+			uint32_t thread; // Index into getThreadNames().
+		};
+
+		struct Frame {
+			int64_t start = 0;
+			int64_t end = 0;
+			std::vector<Event> events; // Ended during the frame, in no particular order.
+		};
+
+		class Scope {
+		public:
+			explicit Scope(const char* name) {
+				if (isEnabled()) {
+					begin(name);
+				}
+			}
+			~Scope() {
+				if (name != nullptr) {
+					end();
+				}
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			Scope(Scope&&) = delete;            // Move Constructor
+			Scope& operator=(Scope&&) = delete; // Move Assignment Operator
+
+		private:
+			void begin(const char* scopeName);
+			void end();
+
+			const char* name = nullptr;
+			int64_t start = 0;
+		};
+
+		static bool isEnabled() {
+			return enabled.load(std::memory_order_relaxed);
+		}
+		static void setEnabled(bool value) {
+			enabled.store(value, std::memory_order_relaxed);
+		}
+
+		static int64_t now();
+		// Returns a copy of the name that lives as long as the profiler, for scopes whose name is built at runtime.
+		static const char* intern(const std::string& name);
+		// Shown for the calling thread in the timeline and the trace.
+		static void setThreadName(const std::string& name);
+		static std::vector<std::string> getThreadNames();
+
+		// Main thread only.
+		static void endFrame();
+		static const Frame& getLastFrame();
+
+		// Writes the next frameCount frames to a Chrome trace JSON file once they are collected.
+		static void startCapture(uint32_t frameCount, const std::string& filePath);
+		static bool isCapturing();
+
+	private:
+		static inline std::atomic<bool> enabled{true};
+	};
+} // namespace Aspen
\ No newline at end of file
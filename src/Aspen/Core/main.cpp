@@ -1,7 +1,20 @@
 #include "Aspen/Core/application.hpp"
+#include "Aspen/Core/cpu_profiler.hpp"
 
-int main() {
-	Aspen::Application app{};
+int main(int argc, char** argv) {
+	// --cpu-trace <frames> captures startup and the first frames to a Chrome trace.
+	// --spawn-benchmark <count> times creating count entities one by one against creating them in bulk during startup.
+	uint32_t spawnBenchmarkCount = 0;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (std::string(argv[i]) == "--cpu-trace") {
+			Aspen::CpuProfiler::startCapture(static_cast<uint32_t>(std::max(1, std::atoi(argv[i + 1]))), Aspen::CpuProfiler::TRACE_PATH);
+		} else if (std::string(argv[i]) == "--spawn-benchmark") {
+			spawnBenchmarkCount = static_cast<uint32_t>(std::max(0, std::atoi(argv[i + 1])));
+		}
+	}
+
+	// e.g. --stress 10000 --distribution clusters --lights 8 --animated 0.25 --seed 42
+	Aspen::Application app{Aspen::StressSceneSettings::fromCommandLine(argc, argv), spawnBenchmarkCount};
 
 	try {
 		app.run();
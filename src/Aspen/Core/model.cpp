@@ -17,9 +17,12 @@ namespace std {
 } // namespace std
 
 namespace Aspen {
-	void Model::makeBuffer(Device& device, MeshComponent& mesh) {
+	void Model::makeBuffer(Device& device, MeshComponent::Geometry& mesh) {
 		createVertexBuffers(device, mesh.vertices, mesh.vertexBuffer);
 		createIndexBuffers(device, mesh.indices, mesh.indexBuffer);
+
+		// Keep a CPU side acceleration structure around for ray queries (e.g. mouse picking).
+		buildBVH(mesh);
 	}
 
 	void Model::createVertexBuffers(Device& device, const std::vector<MeshComponent::Vertex>& vertices, std::unique_ptr<Buffer>& vertexBuffer) {
@@ -107,7 +110,15 @@ namespace Aspen {
 		device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
 	}
 
-	void Model::createModelFromFile(Device& device, MeshComponent& mesh, const std::string& filePath) {
+	void Model::createModelFromFile(Device& device, MeshComponent::Geometry& mesh, const std::string& filePath) {
+		loadModelFromFile(mesh, filePath);
+
+		// Allocate GPU local buffers and move the vertex and index data over to it.
+		makeBuffer(device, mesh);
+	}
+
+	// Reads the model into the geometry's CPU side vertex and index arrays.
+	void Model::loadModelFromFile(MeshComponent::Geometry& mesh, const std::string& filePath) {
 		tinyobj::attrib_t attribute;          // Store position, color, normal, and texture coordinates.
 		std::vector<tinyobj::shape_t> shapes; // Contains index values for each face.
 		std::vector<tinyobj::material_t> materials;
@@ -179,8 +190,40 @@ namespace Aspen {
 			}
 		}
 
-		// Allocate GPU local buffers and move the vertex and index data over to it.
-		makeBuffer(device, mesh);
+		mesh.assetPath = filePath;
+		mesh.assetHash = hashFile(filePath);
+	}
+
+	// Builds an object space BVH over the triangles of the mesh.
+	void Model::buildBVH(MeshComponent::Geometry& mesh) {
+		const size_t triangleCount = mesh.indices.size() / 3;
+
+		std::vector<Math::AABB> triangleBounds(triangleCount);
+		for (size_t i = 0; i < triangleCount; ++i) {
+			triangleBounds[i].grow(mesh.vertices[mesh.indices[3 * i + 0]].position);
+			triangleBounds[i].grow(mesh.vertices[mesh.indices[3 * i + 1]].position);
+			triangleBounds[i].grow(mesh.vertices[mesh.indices[3 * i + 2]].position);
+		}
+
+		mesh.bvh.build(triangleBounds);
+	}
+
+	// Finds the closest triangle hit by an object space ray. tMax is shrunk to the hit distance.
+	bool Model::intersect(const MeshComponent::Geometry& mesh, const Math::Ray& ray, float& tMax, uint32_t& triangleIndex) {
+		return mesh.bvh.traverse(ray, tMax, [&](uint32_t triangle, float& closestHit) {
+			float t;
+			const glm::vec3& v0 = mesh.vertices[mesh.indices[3 * triangle + 0]].position;
+			const glm::vec3& v1 = mesh.vertices[mesh.indices[3 * triangle + 1]].position;
+			const glm::vec3& v2 = mesh.vertices[mesh.indices[3 * triangle + 2]].position;
+
+			if (!Math::intersectRayTriangle(ray, v0, v1, v2, closestHit, t)) {
+				return false;
+			}
+
+			closestHit = t;
+			triangleIndex = triangle;
+			return true;
+		});
 	}
 
 	void Model::bind(VkCommandBuffer commandBuffer, std::unique_ptr<Buffer>& vertexBuffer, std::unique_ptr<Buffer>& indexBuffer) {
@@ -205,6 +248,11 @@ namespace Aspen {
 		vkCmdDrawIndexed(commandBuffer, count, 1, 0, 0, 0);
 	}
 
+	void Model::drawInstanced(VkCommandBuffer commandBuffer, const uint32_t count, const uint32_t instanceCount, const uint32_t firstInstance) {
+		// Instances [firstInstance, firstInstance + instanceCount) are read from the instance buffer through gl_InstanceIndex.
+		vkCmdDrawIndexed(commandBuffer, count, instanceCount, 0, 0, firstInstance);
+	}
+
 	// Defines how the vertex buffer is structured.
 	std::vector<VkVertexInputBindingDescription> Model::getBindingDescriptions() {
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
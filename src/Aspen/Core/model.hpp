@@ -20,13 +20,18 @@ namespace Aspen {
 		Model(const Model&&) = delete;
 		Model& operator=(const Model&&) = delete;
 
-		static void makeBuffer(Device& device, MeshComponent& mesh);
+		static void makeBuffer(Device& device, MeshComponent::Geometry& mesh);
 		static void createVertexBuffers(Device& device, const std::vector<MeshComponent::Vertex>& vertices, std::unique_ptr<Buffer>& vertexBuffer);
 		static void createIndexBuffers(Device& device, const std::vector<uint32_t>& indices, std::unique_ptr<Buffer>& indexBuffer);
-		static void createModelFromFile(Device& device, MeshComponent& mesh, const std::string& filePath);
+		static void createModelFromFile(Device& device, MeshComponent::Geometry& mesh, const std::string& filePath);
+		static void loadModelFromFile(MeshComponent::Geometry& mesh, const std::string& filePath);
+
+		static void buildBVH(MeshComponent::Geometry& mesh);
+		static bool intersect(const MeshComponent::Geometry& mesh, const Math::Ray& ray, float& tMax, uint32_t& triangleIndex);
 
 		static void bind(VkCommandBuffer commandBuffer, std::unique_ptr<Buffer>& vertexBuffer, std::unique_ptr<Buffer>& indexBuffer);
 		static void draw(VkCommandBuffer commandBuffer, const uint32_t count);
+		static void drawInstanced(VkCommandBuffer commandBuffer, const uint32_t count, const uint32_t instanceCount, const uint32_t firstInstance);
 
 		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
@@ -0,0 +1,44 @@
+#include "Aspen/Core/startup_timeline.hpp"
+
+#include <iomanip>
+
+namespace Aspen {
+	void StartupTimeline::record(const std::string& name, uint32_t thread, double start, double end) {
+		std::lock_guard<std::mutex> lock{mutex};
+		phases.push_back({name, thread, start, end});
+	}
+
+	void StartupTimeline::print(std::ostream& stream) {
+		constexpr int BAR_WIDTH = 40;
+
+		std::lock_guard<std::mutex> lock{mutex};
+		std::stable_sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.start < b.start; });
+
+		double total = 0.0;
+		for (const auto& phase : phases) {
+			total = std::max(total, phase.end);
+		}
+		if (total <= 0.0) {
+			return;
+		}
+
+		// Leave the stream's formatting as we found it.
+		std::ios_base::fmtflags flags = stream.flags();
+		std::streamsize precision = stream.precision();
+
+		stream << "Startup timeline (" << std::fixed << std::setprecision(1) << total << " ms):\n";
+		for (const auto& phase : phases) {
+			int first = std::clamp(static_cast<int>(phase.start / total * BAR_WIDTH), 0, BAR_WIDTH - 1);
+			int last = std::clamp(static_cast<int>(phase.end / total * BAR_WIDTH), first, BAR_WIDTH - 1);
+			std::string bar(BAR_WIDTH, '.');
+			std::fill(bar.begin() + first, bar.begin() + last + 1, '#');
+
+			std::string thread = phase.thread == MAIN_THREAD ? "main" : "worker " + std::to_string(phase.thread);
+			stream << "  |" << bar << "| " << std::setw(8) << phase.start << " - " << std::setw(8) << phase.end
+			       << " ms  " << std::left << std::setw(10) << thread << std::right << phase.name << "\n";
+		}
+		stream.flags(flags);
+		stream.precision(precision);
+		stream << std::flush;
+	}
+} // namespace Aspen
\ No newline at end of file
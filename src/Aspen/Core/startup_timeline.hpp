@@ -0,0 +1,63 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Core/cpu_profiler.hpp"
+
+#include <mutex>
+
+namespace Aspen {
+	// Records when the phases of startup ran and on which thread, to see what overlaps and what the first frame waits for.
+	// Times are milliseconds since the timeline was created, which should be as early as possible.
+	// Uses std::chrono rather than Timer, as it starts before GLFW is initialised.
+	class StartupTimeline {
+	public:
+		static constexpr uint32_t MAIN_THREAD = UINT32_MAX;
+
+		struct Phase {
+			std::string name;
+			uint32_t thread; // Worker index, or MAIN_THREAD.
+			double start;
+			double end;
+		};
+
+		// Records the phase from its construction to its destruction, in the CPU profiler too.
+		class Scope {
+		public:
+			Scope(StartupTimeline& timeline, std::string name, uint32_t thread = MAIN_THREAD)
+			    : timeline(timeline), name(std::move(name)), thread(thread), start(timeline.now()), profileScope(CpuProfiler::intern(this->name)) {}
+			~Scope() {
+				timeline.record(name, thread, start, timeline.now());
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			Scope(Scope&&) = delete;            // Move Constructor
+			Scope& operator=(Scope&&) = delete; // Move Assignment Operator
+
+		private:
+			StartupTimeline& timeline;
+			std::string name;
+			uint32_t thread;
+			double start;
+			CpuProfiler::Scope profileScope;
+		};
+
+		StartupTimeline()
+		    : startTime(std::chrono::steady_clock::now()) {}
+
+		double now() const {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		}
+
+		// Thread safe, jobs record their own phases.
+		void record(const std::string& name, uint32_t thread, double start, double end);
+
+		// Prints every phase in order of its start, with a bar showing where it falls between startup and the last phase's end.
+		void print(std::ostream& stream);
+
+	private:
+		std::chrono::steady_clock::time_point startTime;
+		std::mutex mutex;
+		std::vector<Phase> phases;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "Aspen/Core/thread_pool.hpp"
+
+#include "Aspen/Core/cpu_profiler.hpp"
+
+namespace Aspen {
+	ThreadPool::ThreadPool(uint32_t threadCount) {
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i) {
+			workers.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+
+		// Workers finish the queued jobs before they exit.
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	std::future<void> ThreadPool::submit(std::function<void(uint32_t threadIndex)> job) {
+		std::packaged_task<void(uint32_t)> task(std::move(job));
+		std::future<void> result = task.get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push(std::move(task));
+		}
+		condition.notify_one();
+		return result;
+	}
+
+	void ThreadPool::workerLoop(uint32_t threadIndex) {
+		CpuProfiler::setThreadName("Worker " + std::to_string(threadIndex));
+		while (true) {
+			std::packaged_task<void(uint32_t)> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (jobs.empty()) {
+					return;
+				}
+				task = std::move(jobs.front());
+				jobs.pop();
+			}
+
+			// Exceptions are stored in the job's future.
+			task(threadIndex);
+		}
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include "pch.h"
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace Aspen {
+	// A fixed set of worker threads running submitted jobs in FIFO order.
+	// Jobs are told the index of the worker running them, so per-thread resources can be used without locking.
+	class ThreadPool {
+	public:
+		ThreadPool(uint32_t threadCount = defaultThreadCount());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;            // Move Constructor
+		ThreadPool& operator=(ThreadPool&&) = delete; // Move Assignment Operator
+
+		std::future<void> submit(std::function<void(uint32_t threadIndex)> job);
+
+		uint32_t getThreadCount() const {
+			return static_cast<uint32_t>(workers.size());
+		}
+
+		// One worker per hardware thread, leaving one for the main thread. hardware_concurrency() is 0 when it is unknown.
+		static uint32_t defaultThreadCount() {
+			return std::max(2u, std::thread::hardware_concurrency()) - 1;
+		}
+
+	private:
+		void workerLoop(uint32_t threadIndex);
+
+		std::vector<std::thread> workers;
+		std::queue<std::packaged_task<void(uint32_t)>> jobs;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping = false;
+	};
+} // namespace Aspen
\ No newline at end of file
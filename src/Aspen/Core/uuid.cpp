@@ -19,4 +19,10 @@ namespace Aspen {
 	UUID::UUID(uint64_t uuid)
 	    : m_UUID(uuid) {
 	}
+
+	void UUID::generate(std::span<uint64_t> uuids) {
+		for (auto& uuid : uuids) {
+			uuid = s_UniformDistribution(s_Engine);
+		}
+	}
 } // namespace Aspen
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "pch.h"
 
+#include <span>
+
 // Ideally the UUID would be a 128 bit number as that is traditionally how they are defined, but for the purposes of a game engine this is fine.
 // Adapted from: https://www.youtube.com/watch?v=O_0nUE4S8T8
 namespace Aspen {
@@ -11,6 +13,9 @@ namespace Aspen {
 		UUID(uint64_t uuid);
 		UUID(const UUID&) = default;
 
+		// Fills the range with new UUID values in one go.
+		static void generate(std::span<uint64_t> uuids);
+
 		operator uint64_t() const {
 			return m_UUID;
 		}
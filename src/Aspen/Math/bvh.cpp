@@ -0,0 +1,220 @@
+#include "pch.h"
+
+#include "bvh.hpp"
+
+namespace Aspen::Math {
+	AABB AABB::transformed(const glm::mat4& transform) const {
+		// Arvo's method: project each axis of the matrix onto the box extents instead of transforming all 8 corners.
+		AABB result;
+		result.min = glm::vec3(transform[3]);
+		result.max = glm::vec3(transform[3]);
+
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				float a = transform[j][i] * min[j];
+				float b = transform[j][i] * max[j];
+				result.min[i] += glm::min(a, b);
+				result.max[i] += glm::max(a, b);
+			}
+		}
+
+		return result;
+	}
+
+	bool intersectRayAABB(const Ray& ray, const AABB& box, float tMax, float& tNear) {
+		glm::vec3 t1 = (box.min - ray.origin) * ray.invDirection;
+		glm::vec3 t2 = (box.max - ray.origin) * ray.invDirection;
+
+		glm::vec3 tMinAxis = glm::min(t1, t2);
+		glm::vec3 tMaxAxis = glm::max(t1, t2);
+
+		tNear = glm::max(glm::max(tMinAxis.x, tMinAxis.y), tMinAxis.z);
+		float tFar = glm::min(glm::min(tMaxAxis.x, tMaxAxis.y), tMaxAxis.z);
+
+		return tFar >= tNear && tFar > 0.0f && tNear < tMax;
+	}
+
+	bool intersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float tMax, float& t) {
+		const float EPSILON = 1e-7f;
+
+		glm::vec3 edge1 = v1 - v0;
+		glm::vec3 edge2 = v2 - v0;
+		glm::vec3 h = glm::cross(ray.direction, edge2);
+		float a = glm::dot(edge1, h);
+
+		// Ray is parallel to the triangle. Both windings are accepted so back faces can still be picked.
+		if (a > -EPSILON && a < EPSILON) {
+			return false;
+		}
+
+		float f = 1.0f / a;
+		glm::vec3 s = ray.origin - v0;
+		float u = f * glm::dot(s, h);
+		if (u < 0.0f || u > 1.0f) {
+			return false;
+		}
+
+		glm::vec3 q = glm::cross(s, edge1);
+		float v = f * glm::dot(ray.direction, q);
+		if (v < 0.0f || u + v > 1.0f) {
+			return false;
+		}
+
+		float distance = f * glm::dot(edge2, q);
+		if (distance <= EPSILON || distance >= tMax) {
+			return false;
+		}
+
+		t = distance;
+		return true;
+	}
+
+	void BVH::build(const std::vector<AABB>& primitiveBounds) {
+		clear();
+
+		const auto primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+		if (primitiveCount == 0) {
+			return;
+		}
+
+		primitiveIndices.resize(primitiveCount);
+		std::vector<glm::vec3> centroids(primitiveCount);
+		for (uint32_t i = 0; i < primitiveCount; ++i) {
+			primitiveIndices[i] = i;
+			centroids[i] = primitiveBounds[i].center();
+		}
+
+		// A binary tree with N leaves has at most 2N - 1 nodes.
+		nodes.reserve(2 * primitiveCount - 1);
+
+		Node& root = nodes.emplace_back();
+		root.leftFirst = 0;
+		root.count = primitiveCount;
+		updateNodeBounds(0, primitiveBounds);
+		subdivide(0, primitiveBounds, centroids, 0);
+
+		nodes.shrink_to_fit();
+	}
+
+	void BVH::clear() {
+		nodes.clear();
+		primitiveIndices.clear();
+	}
+
+	void BVH::updateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds) {
+		Node& node = nodes[nodeIndex];
+		node.bounds = AABB{};
+		for (uint32_t i = 0; i < node.count; ++i) {
+			node.bounds.grow(primitiveBounds[primitiveIndices[node.leftFirst + i]]);
+		}
+	}
+
+	void BVH::subdivide(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds, const std::vector<glm::vec3>& centroids, uint32_t depth) {
+		if (nodes[nodeIndex].count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH) {
+			return;
+		}
+
+		int axis = -1;
+		float splitPosition = 0.0f;
+		float splitCost = findBestSplit(nodes[nodeIndex], primitiveBounds, centroids, axis, splitPosition);
+
+		// Stop if splitting is not cheaper than intersecting every primitive in this node.
+		float leafCost = static_cast<float>(nodes[nodeIndex].count) * nodes[nodeIndex].bounds.halfArea();
+		if (axis == -1 || splitCost >= leafCost) {
+			return;
+		}
+
+		// Partition the primitive indices in place around the split plane.
+		uint32_t first = nodes[nodeIndex].leftFirst;
+		uint32_t last = first + nodes[nodeIndex].count;
+		auto middle = std::partition(primitiveIndices.begin() + first, primitiveIndices.begin() + last, [&](uint32_t index) {
+			return centroids[index][axis] < splitPosition;
+		});
+
+		uint32_t leftCount = static_cast<uint32_t>(middle - primitiveIndices.begin()) - first;
+		if (leftCount == 0 || leftCount == nodes[nodeIndex].count) {
+			return;
+		}
+
+		// Children are always allocated next to each other, so only the left index needs to be stored.
+		uint32_t leftChildIndex = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+		nodes.emplace_back();
+
+		nodes[leftChildIndex].leftFirst = first;
+		nodes[leftChildIndex].count = leftCount;
+		nodes[leftChildIndex + 1].leftFirst = first + leftCount;
+		nodes[leftChildIndex + 1].count = nodes[nodeIndex].count - leftCount;
+
+		nodes[nodeIndex].leftFirst = leftChildIndex;
+		nodes[nodeIndex].count = 0;
+
+		updateNodeBounds(leftChildIndex, primitiveBounds);
+		updateNodeBounds(leftChildIndex + 1, primitiveBounds);
+
+		subdivide(leftChildIndex, primitiveBounds, centroids, depth + 1);
+		subdivide(leftChildIndex + 1, primitiveBounds, centroids, depth + 1);
+	}
+
+	float BVH::findBestSplit(const Node& node, const std::vector<AABB>& primitiveBounds, const std::vector<glm::vec3>& centroids, int& axis, float& splitPosition) const {
+		struct Bin {
+			AABB bounds;
+			uint32_t count = 0;
+		};
+
+		float bestCost = std::numeric_limits<float>::max();
+
+		for (int a = 0; a < 3; ++a) {
+			// Bin on the centroid bounds rather than the node bounds so that no bins are wasted on empty space.
+			float boundsMin = std::numeric_limits<float>::max();
+			float boundsMax = std::numeric_limits<float>::lowest();
+			for (uint32_t i = 0; i < node.count; ++i) {
+				const glm::vec3& centroid = centroids[primitiveIndices[node.leftFirst + i]];
+				boundsMin = glm::min(boundsMin, centroid[a]);
+				boundsMax = glm::max(boundsMax, centroid[a]);
+			}
+
+			if (boundsMin == boundsMax) {
+				continue;
+			}
+
+			std::array<Bin, SAH_BIN_COUNT> bins{};
+			float scale = static_cast<float>(SAH_BIN_COUNT) / (boundsMax - boundsMin);
+			for (uint32_t i = 0; i < node.count; ++i) {
+				uint32_t primitiveIndex = primitiveIndices[node.leftFirst + i];
+				uint32_t binIndex = std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>((centroids[primitiveIndex][a] - boundsMin) * scale));
+				bins[binIndex].count++;
+				bins[binIndex].bounds.grow(primitiveBounds[primitiveIndex]);
+			}
+
+			// Sweep from both sides to get the area and count on either side of every bin boundary.
+			std::array<float, SAH_BIN_COUNT - 1> leftArea{}, rightArea{};
+			std::array<uint32_t, SAH_BIN_COUNT - 1> leftCount{}, rightCount{};
+			AABB leftBox, rightBox;
+			uint32_t leftSum = 0, rightSum = 0;
+			for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; ++i) {
+				leftSum += bins[i].count;
+				leftCount[i] = leftSum;
+				leftBox.grow(bins[i].bounds);
+				leftArea[i] = leftBox.halfArea();
+
+				rightSum += bins[SAH_BIN_COUNT - 1 - i].count;
+				rightCount[SAH_BIN_COUNT - 2 - i] = rightSum;
+				rightBox.grow(bins[SAH_BIN_COUNT - 1 - i].bounds);
+				rightArea[SAH_BIN_COUNT - 2 - i] = rightBox.halfArea();
+			}
+
+			float binWidth = (boundsMax - boundsMin) / static_cast<float>(SAH_BIN_COUNT);
+			for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; ++i) {
+				float cost = static_cast<float>(leftCount[i]) * leftArea[i] + static_cast<float>(rightCount[i]) * rightArea[i];
+				if (cost < bestCost) {
+					bestCost = cost;
+					axis = a;
+					splitPosition = boundsMin + binWidth * static_cast<float>(i + 1);
+				}
+			}
+		}
+
+		return bestCost;
+	}
+} // namespace Aspen::Math
\ No newline at end of file
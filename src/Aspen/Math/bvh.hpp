@@ -0,0 +1,153 @@
+#pragma once
+#include "pch.h"
+
+#include <glm/glm.hpp>
+
+namespace Aspen::Math {
+	struct Ray {
+		Ray() = default;
+		Ray(const glm::vec3& origin, const glm::vec3& direction)
+		    : origin(origin), direction(direction), invDirection(1.0f / direction){};
+
+		glm::vec3 origin{0.0f};
+		glm::vec3 direction{0.0f, 0.0f, 1.0f};
+		glm::vec3 invDirection{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), 1.0f};
+	};
+
+	struct AABB {
+		glm::vec3 min{std::numeric_limits<float>::max()};
+		glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+		void grow(const glm::vec3& point) {
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void grow(const AABB& other) {
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		glm::vec3 center() const {
+			return (min + max) * 0.5f;
+		}
+
+		bool isValid() const {
+			return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+		}
+
+		// Half of the surface area, which is all the SAH cares about.
+		float halfArea() const {
+			if (!isValid()) {
+				return 0.0f;
+			}
+
+			glm::vec3 extent = max - min;
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+
+		// Returns the bounds of this box after being transformed by the given affine matrix.
+		AABB transformed(const glm::mat4& transform) const;
+	};
+
+	// Slab test. Returns the entry distance in tNear if the ray hits the box before tMax.
+	bool intersectRayAABB(const Ray& ray, const AABB& box, float tMax, float& tNear);
+
+	// Moller-Trumbore ray/triangle intersection. Returns the hit distance in t if it is closer than tMax.
+	bool intersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float tMax, float& t);
+
+	// A bounding volume hierarchy built with a binned surface area heuristic.
+	// The BVH only stores primitive indices, what a primitive is (triangle, instance, etc.) is up to the caller.
+	// Adapted From: https://jacco.ompf2.com/2022/04/18/how-to-build-a-bvh-part-2-faster-rays/
+	class BVH {
+	public:
+		struct Node {
+			AABB bounds;
+			uint32_t leftFirst = 0; // Index of the left child if this is an interior node, otherwise the first primitive index.
+			uint32_t count = 0;     // Number of primitives if this is a leaf, 0 for interior nodes.
+
+			bool isLeaf() const {
+				return count > 0;
+			}
+		};
+
+		void build(const std::vector<AABB>& primitiveBounds);
+		void clear();
+
+		bool empty() const {
+			return nodes.empty();
+		}
+
+		const AABB& getBounds() const {
+			return nodes[0].bounds;
+		}
+
+		const std::vector<Node>& getNodes() const {
+			return nodes;
+		}
+
+		// Visits the primitives of every leaf the ray passes through, nearest child first.
+		// intersectPrimitive(primitiveIndex, tMax) must return true and shrink tMax if the primitive was hit closer than tMax.
+		template <typename Fn>
+		bool traverse(const Ray& ray, float& tMax, Fn&& intersectPrimitive) const {
+			if (nodes.empty()) {
+				return false;
+			}
+
+			bool hit = false;
+			float tNear;
+			if (!intersectRayAABB(ray, nodes[0].bounds, tMax, tNear)) {
+				return false;
+			}
+
+			std::array<uint32_t, 64> stack;
+			uint32_t stackSize = 0;
+			stack[stackSize++] = 0;
+
+			while (stackSize > 0) {
+				const Node& node = nodes[stack[--stackSize]];
+
+				if (node.isLeaf()) {
+					for (uint32_t i = 0; i < node.count; ++i) {
+						hit |= intersectPrimitive(primitiveIndices[node.leftFirst + i], tMax);
+					}
+					continue;
+				}
+
+				uint32_t nearChild = node.leftFirst;
+				uint32_t farChild = node.leftFirst + 1;
+				float tNearChild, tFarChild;
+				bool hitNear = intersectRayAABB(ray, nodes[nearChild].bounds, tMax, tNearChild);
+				bool hitFar = intersectRayAABB(ray, nodes[farChild].bounds, tMax, tFarChild);
+
+				if (hitNear && hitFar && tFarChild < tNearChild) {
+					std::swap(nearChild, farChild);
+				}
+
+				// Push the far child first so the near child is popped (and can shrink tMax) first.
+				if (hitFar && hitNear) {
+					stack[stackSize++] = farChild;
+					stack[stackSize++] = nearChild;
+				} else if (hitNear) {
+					stack[stackSize++] = nearChild;
+				} else if (hitFar) {
+					stack[stackSize++] = farChild;
+				}
+			}
+
+			return hit;
+		}
+
+	private:
+		static constexpr uint32_t SAH_BIN_COUNT = 12;
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+		static constexpr uint32_t MAX_DEPTH = 32; // Keeps the traversal stack bounded.
+
+		void updateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds);
+		void subdivide(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds, const std::vector<glm::vec3>& centroids, uint32_t depth);
+		float findBestSplit(const Node& node, const std::vector<AABB>& primitiveBounds, const std::vector<glm::vec3>& centroids, int& axis, float& splitPosition) const;
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> primitiveIndices;
+	};
+} // namespace Aspen::Math
\ No newline at end of file
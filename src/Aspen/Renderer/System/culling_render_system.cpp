@@ -0,0 +1,470 @@
+#include "Aspen/Renderer/System/culling_render_system.hpp"
+
+#include "Aspen/Core/cpu_profiler.hpp"
+
+namespace Aspen {
+	namespace {
+		struct CullPushConstantData {
+			glm::mat4 viewProjection;
+			glm::vec2 pyramidSize; // Size of the part of the depth pyramid's first level the render extent covers.
+			uint32_t pyramidLevels;
+			uint32_t count; // Instances for the cull shader, batches for the compact shader.
+			uint32_t flags; // CULL_* bits.
+			uint32_t previousVisibilityCount;
+		};
+
+		// Phase of occlusion culling, neither for frustum culling alone.
+		constexpr uint32_t CULL_EARLY = 1 << 0;
+		constexpr uint32_t CULL_LATE = 1 << 1;
+	} // namespace
+
+	CullingRenderSystem::CullingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle depthImage, RenderGraph::ResourceHandle depthPyramid)
+	    : device(device), renderer(renderer), renderGraph(renderGraph), depthImage(depthImage), depthPyramid(depthPyramid), instanceDescriptorSetLayout(globalDescriptorSetLayout[1]), frames(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; ++i) {
+			for (uint32_t output = 0; output < OUTPUT_COUNT; ++output) {
+				reserveBuffers(i, static_cast<OutputIndex>(output), 10, 10);
+			}
+			reserveVisibility(i, 10);
+
+			frames[i].stats = std::make_unique<Buffer>(
+			    device,
+			    sizeof(CullStats),
+			    1,
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			frames[i].stats->map();
+		}
+
+		createSampler();
+
+		createDescriptorPool();
+		createDescriptorSetLayouts();
+		createDescriptorSets();
+
+		createPipelineLayouts();
+	}
+
+	CullingRenderSystem::~CullingRenderSystem() {
+		vkDestroySampler(device.device(), sampler, nullptr);
+	}
+
+	// Point sampling, every shader reading through it uses texelFetch.
+	void CullingRenderSystem::createSampler() {
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create depth pyramid sampler!");
+		}
+	}
+
+	// Per frame the input set and an instance and output set per Output. The pyramid sets are added as the swap chain grows,
+	// a pyramid has at most one level per bit of the largest image dimension.
+	void CullingRenderSystem::createDescriptorPool() {
+		const uint32_t frameSets = SwapChain::MAX_FRAMES_IN_FLIGHT * (1 + 2 * OUTPUT_COUNT);
+		const uint32_t maxPyramidLevels = static_cast<uint32_t>(std::bit_width(device.properties.limits.maxImageDimension2D));
+
+		descriptorPool = DescriptorPool::Builder(device)
+		                     .setMaxSets(frameSets + maxPyramidLevels)
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * (5 + 4 * OUTPUT_COUNT))
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT + maxPyramidLevels)
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxPyramidLevels)
+		                     .build();
+	}
+
+	void CullingRenderSystem::createDescriptorSetLayouts() {
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+		                          .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)         // Binding 0: Instances written by the CPU.
+		                          .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)         // Binding 1: Indirect commands written by the CPU.
+		                          .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)         // Binding 2: Last frame's visibility.
+		                          .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)         // Binding 3: This frame's visibility.
+		                          .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)         // Binding 4: Statistics.
+		                          .addBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // Binding 5: Depth pyramid.
+		                          .build();
+
+		outputDescriptorSetLayout = DescriptorSetLayout::Builder(device)
+		                                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // Binding 0: Surviving instances.
+		                                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // Binding 1: Draw count and per batch instance counts.
+		                                .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // Binding 2: Compacted indirect commands.
+		                                .build();
+
+		pyramidDescriptorSetLayout = DescriptorSetLayout::Builder(device)
+		                                 .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // Binding 0: Level above, or the scene depth.
+		                                 .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)          // Binding 1: Level written.
+		                                 .build();
+	}
+
+	// The input descriptor sets are rewritten every frame in prepare(), as their inputs are owned by GlobalRenderSystem and may be reallocated.
+	// Until then the inputs point at this system's own buffers.
+	void CullingRenderSystem::createDescriptorSets() {
+		const RenderGraph::Image& pyramid = renderGraph.getImage(depthPyramid);
+		VkDescriptorImageInfo pyramidInfo{sampler, pyramid.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+		for (auto& frame : frames) {
+			for (auto& output : frame.outputs) {
+				auto instanceBufferInfo = output.instances->descriptorInfo();
+				auto counterBufferInfo = output.counters->descriptorInfo();
+				auto commandBufferInfo = output.commands->descriptorInfo();
+				if (!DescriptorWriter(*instanceDescriptorSetLayout, *descriptorPool)
+				         .writeBuffer(0, &instanceBufferInfo)
+				         .build(output.instanceDescriptorSet)) {
+					throw std::runtime_error("Failed to allocate culled instance descriptor set!");
+				}
+				if (!DescriptorWriter(*outputDescriptorSetLayout, *descriptorPool)
+				         .writeBuffer(0, &instanceBufferInfo)
+				         .writeBuffer(1, &counterBufferInfo)
+				         .writeBuffer(2, &commandBufferInfo)
+				         .build(output.descriptorSet)) {
+					throw std::runtime_error("Failed to allocate culling output descriptor set!");
+				}
+			}
+
+			auto instanceBufferInfo = frame.outputs[VISIBLE_OUTPUT].instances->descriptorInfo();
+			auto commandBufferInfo = frame.outputs[VISIBLE_OUTPUT].commands->descriptorInfo();
+			auto visibilityBufferInfo = frame.visibility->descriptorInfo();
+			auto statsBufferInfo = frame.stats->descriptorInfo();
+			if (!DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+			         .writeBuffer(0, &instanceBufferInfo)
+			         .writeBuffer(1, &commandBufferInfo)
+			         .writeBuffer(2, &visibilityBufferInfo)
+			         .writeBuffer(3, &visibilityBufferInfo)
+			         .writeBuffer(4, &statsBufferInfo)
+			         .writeImage(5, &pyramidInfo)
+			         .build(frame.descriptorSet)) {
+				throw std::runtime_error("Failed to allocate culling descriptor set!");
+			}
+		}
+
+		writePyramidDescriptorSets();
+	}
+
+	// Every level reads the one above it, the first reads the depth aspect of the scene depth. Sets are only added when a larger swap chain needs more levels.
+	void CullingRenderSystem::writePyramidDescriptorSets() {
+		const RenderGraph::Image& depth = renderGraph.getImage(depthImage);
+		const RenderGraph::Image& pyramid = renderGraph.getImage(depthPyramid);
+
+		for (uint32_t level = 0; level < pyramid.mipViews.size(); ++level) {
+			VkDescriptorImageInfo sourceInfo{sampler, depth.depthView != VK_NULL_HANDLE ? depth.depthView : depth.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+			if (level > 0) {
+				sourceInfo = {sampler, pyramid.mipViews[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+			}
+			VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, pyramid.mipViews[level], VK_IMAGE_LAYOUT_GENERAL};
+
+			DescriptorWriter writer(*pyramidDescriptorSetLayout, *descriptorPool);
+			writer.writeImage(0, &sourceInfo).writeImage(1, &destinationInfo);
+			if (level < pyramidDescriptorSets.size()) {
+				writer.overwrite(pyramidDescriptorSets[level]);
+			} else if (!writer.build(pyramidDescriptorSets.emplace_back())) {
+				throw std::runtime_error("Failed to allocate depth pyramid descriptor set!");
+			}
+		}
+	}
+
+	// Both culling pipelines share one layout, so the sets bound for the cull stay valid for the compaction.
+	void CullingRenderSystem::createPipelineLayouts() {
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstantData);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+		    descriptorSetLayout->getDescriptorSetLayout(),
+		    outputDescriptorSetLayout->getDescriptorSetLayout(),
+		    outputDescriptorSetLayout->getDescriptorSetLayout()};
+		cullPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+		compactPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+
+		std::vector<VkDescriptorSetLayout> pyramidDescriptorSetLayouts{pyramidDescriptorSetLayout->getDescriptorSetLayout()};
+		pyramidPipeline.createPipelineLayout(pyramidDescriptorSetLayouts);
+	}
+
+	void CullingRenderSystem::createPipelines() {
+		cullPipeline.createShaderModule("assets/shaders/cull_instances.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		cullPipeline.createComputePipeline(cullPipeline.getPipeline());
+
+		compactPipeline.createShaderModule("assets/shaders/compact_draws.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		compactPipeline.createComputePipeline(compactPipeline.getPipeline());
+
+		pyramidPipeline.createShaderModule("assets/shaders/depth_pyramid.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		pyramidPipeline.createComputePipeline(pyramidPipeline.getPipeline());
+	}
+
+	// Grows an output of the frame. Only the current frame's buffers are replaced, the GPU is done with them once the frame has begun.
+	void CullingRenderSystem::reserveBuffers(int frameIndex, OutputIndex outputIndex, uint32_t instanceCount, uint32_t drawCount) {
+		auto& output = frames[frameIndex].outputs[outputIndex];
+		bool grown = false;
+
+		if (!output.instances || instanceCount > output.instances->getInstanceCount()) {
+			output.instances = std::make_unique<Buffer>(
+			    device,
+			    sizeof(GlobalRenderSystem::InstanceData),
+			    output.instances ? std::max(instanceCount, output.instances->getInstanceCount() * 2) : instanceCount,
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			grown = true;
+
+			if (output.instanceDescriptorSet != VK_NULL_HANDLE) {
+				auto instanceBufferInfo = output.instances->descriptorInfo();
+				DescriptorWriter(*instanceDescriptorSetLayout, *descriptorPool)
+				    .writeBuffer(0, &instanceBufferInfo)
+				    .overwrite(output.instanceDescriptorSet);
+			}
+		}
+
+		if (!output.commands || drawCount > output.commands->getInstanceCount()) {
+			const uint32_t capacity = output.commands ? std::max(drawCount, output.commands->getInstanceCount() * 2) : drawCount;
+
+			output.commands = std::make_unique<Buffer>(
+			    device,
+			    sizeof(VkDrawIndexedIndirectCommand),
+			    capacity,
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			output.counters = std::make_unique<Buffer>(
+			    device,
+			    sizeof(uint32_t),
+			    capacity + 1,
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			grown = true;
+		}
+
+		if (grown && output.descriptorSet != VK_NULL_HANDLE) {
+			auto instanceBufferInfo = output.instances->descriptorInfo();
+			auto counterBufferInfo = output.counters->descriptorInfo();
+			auto commandBufferInfo = output.commands->descriptorInfo();
+			DescriptorWriter(*outputDescriptorSetLayout, *descriptorPool)
+			    .writeBuffer(0, &instanceBufferInfo)
+			    .writeBuffer(1, &counterBufferInfo)
+			    .writeBuffer(2, &commandBufferInfo)
+			    .overwrite(output.descriptorSet);
+		}
+	}
+
+	// The next frame reads this frame's visibility, which may still be running when this frame index comes around again.
+	// A replaced buffer is therefore kept until then. prepare() points the input set at the new one.
+	void CullingRenderSystem::reserveVisibility(int frameIndex, uint32_t entityCount) {
+		auto& frame = frames[frameIndex];
+		auto& visibility = frame.visibility;
+		frame.retiredVisibility.reset();
+		if (!visibility || entityCount > visibility->getInstanceCount()) {
+			frame.retiredVisibility = std::move(visibility);
+			visibility = std::make_unique<Buffer>(
+			    device,
+			    sizeof(uint32_t),
+			    frame.retiredVisibility ? std::max(entityCount, frame.retiredVisibility->getInstanceCount() * 2) : entityCount,
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void CullingRenderSystem::readStats(FrameInfo& frameInfo) {
+		auto& frame = frames[frameInfo.frameIndex];
+		// Nothing was culled, or the render graph culled the late phase, as nothing consumed its output.
+		if (frame.testedInstances == 0 || (frame.occlusionCulling && frame.visibilityCount == 0)) {
+			return;
+		}
+
+		frame.stats->invalidate();
+		const auto* counts = static_cast<const CullStats*>(frame.stats->getMappedMemory());
+		auto& appState = frameInfo.appState;
+		appState.culledInstancesTested = static_cast<int>(frame.testedInstances);
+		appState.frustumCulledInstances = static_cast<int>(frame.testedInstances - counts->inFrustum);
+		appState.occlusionCulledInstances = frame.occlusionCulling ? static_cast<int>(counts->inFrustum - counts->visible) : 0;
+		appState.lateInstances = frame.occlusionCulling ? static_cast<int>(counts->late) : 0;
+		frame.testedInstances = 0;
+	}
+
+	void CullingRenderSystem::prepare(FrameInfo& frameInfo, DrawList& drawList, Buffer& instanceBuffer, bool occlusionCulling) {
+		ASPEN_PROFILE_SCOPE("CullingRenderSystem::prepare");
+		readStats(frameInfo);
+
+		const int frameIndex = frameInfo.frameIndex;
+		auto& frame = frames[frameIndex];
+		frame.visibilityCount = 0;
+		frame.occlusionCulling = occlusionCulling;
+		if (drawList.indirectDrawCount == 0) {
+			return;
+		}
+
+		reserveBuffers(frameIndex, VISIBLE_OUTPUT, drawList.instanceCount, drawList.indirectDrawCount);
+		if (occlusionCulling) {
+			reserveBuffers(frameIndex, EARLY_OUTPUT, drawList.instanceCount, drawList.indirectDrawCount);
+			reserveBuffers(frameIndex, LATE_OUTPUT, drawList.instanceCount, drawList.indirectDrawCount);
+		}
+		reserveVisibility(frameIndex, static_cast<uint32_t>(drawList.instanceSlots.size()));
+
+		// Loose batches are copied without being tested, they are left out of the statistics.
+		frame.testedInstances = drawList.instanceCount;
+		for (uint32_t batchIndex : drawList.looseBatches) {
+			frame.testedInstances -= drawList.batches[batchIndex].instanceCount;
+		}
+
+		// Rewrite the inputs, any of them may have grown since the last time this frame index was recorded.
+		{
+			const auto& previousFrame = frames[renderer.getPreviousFrameIndex()];
+			auto instanceBufferInfo = instanceBuffer.descriptorInfo();
+			auto commandBufferInfo = drawList.indirectCommandBuffer->descriptorInfo();
+			auto previousVisibilityBufferInfo = previousFrame.visibility->descriptorInfo();
+			auto visibilityBufferInfo = frame.visibility->descriptorInfo();
+			auto statsBufferInfo = frame.stats->descriptorInfo();
+			VkDescriptorImageInfo pyramidInfo{sampler, renderGraph.getImage(depthPyramid).view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+			DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+			    .writeBuffer(0, &instanceBufferInfo)
+			    .writeBuffer(1, &commandBufferInfo)
+			    .writeBuffer(2, &previousVisibilityBufferInfo)
+			    .writeBuffer(3, &visibilityBufferInfo)
+			    .writeBuffer(4, &statsBufferInfo)
+			    .writeImage(5, &pyramidInfo)
+			    .overwrite(frame.descriptorSet);
+		}
+
+		auto culledDraws = [&](OutputIndex outputIndex) {
+			const auto& output = frame.outputs[outputIndex];
+			return DrawList::CulledDraws{output.commands.get(), output.counters.get(), output.instanceDescriptorSet};
+		};
+		drawList.culled = true;
+		drawList.visible = culledDraws(VISIBLE_OUTPUT);
+		drawList.early = occlusionCulling ? culledDraws(EARLY_OUTPUT) : DrawList::CulledDraws{};
+		drawList.late = occlusionCulling ? culledDraws(LATE_OUTPUT) : DrawList::CulledDraws{};
+	}
+
+	void CullingRenderSystem::cull(FrameInfo& frameInfo, const DrawList& drawList, uint32_t flags, OutputIndex output, OutputIndex lateOutput) {
+		const int frameIndex = frameInfo.frameIndex;
+		const auto& previousFrame = frames[renderer.getPreviousFrameIndex()];
+		const RenderGraph::Image& pyramid = renderGraph.getImage(depthPyramid);
+
+		CullPushConstantData push{};
+		push.viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		// The scene depth is only rendered in the top left render extent, the texels beyond it hold older depth. Those a
+		// lookup reaches at the border only make the farthest depth farther, so the test stays conservative.
+		const VkExtent2D renderExtent = renderer.getRenderExtent();
+		const VkExtent2D targetExtent = renderer.getTargetExtent();
+		const glm::vec2 renderScale = glm::vec2(renderExtent.width, renderExtent.height) / glm::vec2(targetExtent.width, targetExtent.height);
+		push.pyramidSize = glm::vec2(static_cast<float>(pyramid.extent.width), static_cast<float>(pyramid.extent.height)) * renderScale;
+		push.pyramidLevels = pyramid.subresourceRange.levelCount;
+		push.count = drawList.instanceCount;
+		push.flags = flags;
+		push.previousVisibilityCount = previousFrame.visibilityCount;
+
+		const auto& outputs = frames[frameIndex].outputs;
+		cullPipeline.bind(frameInfo.commandBuffer, cullPipeline.getPipeline());
+		cullPipeline.bindDescriptorSets(frameInfo.commandBuffer, 0, {frames[frameIndex].descriptorSet, outputs[output].descriptorSet, outputs[lateOutput].descriptorSet});
+		vkCmdPushConstants(frameInfo.commandBuffer, cullPipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+		vkCmdDispatch(frameInfo.commandBuffer, (push.count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	}
+
+	// Expects the cull's writes to be visible and its input set to still be bound.
+	void CullingRenderSystem::compact(FrameInfo& frameInfo, const DrawList& drawList, OutputIndex output) {
+		CullPushConstantData push{};
+		push.count = drawList.indirectDrawCount;
+		compactPipeline.bind(frameInfo.commandBuffer, compactPipeline.getPipeline());
+		compactPipeline.bindDescriptorSets(frameInfo.commandBuffer, 1, {frames[frameInfo.frameIndex].outputs[output].descriptorSet});
+		vkCmdPushConstants(frameInfo.commandBuffer, compactPipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+		vkCmdDispatch(frameInfo.commandBuffer, (push.count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	}
+
+	void CullingRenderSystem::render(FrameInfo& frameInfo, const DrawList& drawList) {
+		ASPEN_PROFILE_SCOPE("CullingRenderSystem::render");
+		if (drawList.indirectDrawCount == 0) {
+			return;
+		}
+
+		const int frameIndex = frameInfo.frameIndex;
+		auto& frame = frames[frameIndex];
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+		// Reset the draw counts and the per batch instance counts of every output the frame uses, and the statistics.
+		const size_t outputCount = frame.occlusionCulling ? OUTPUT_COUNT : 1;
+		for (size_t output = 0; output < outputCount; ++output) {
+			vkCmdFillBuffer(commandBuffer, frame.outputs[output].counters->getBuffer(), 0, sizeof(uint32_t) * (drawList.indirectDrawCount + 1), 0);
+		}
+		vkCmdFillBuffer(commandBuffer, frame.stats->getBuffer(), 0, sizeof(CullStats), 0);
+
+		// Also waits for last frame's late phase to finish writing the visibility the first phase reads.
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// Cull every instance, appending the survivors to their batch's range. The first phase has no late output, any set will do for it.
+		const OutputIndex output = frame.occlusionCulling ? EARLY_OUTPUT : VISIBLE_OUTPUT;
+		cull(frameInfo, drawList, frame.occlusionCulling ? CULL_EARLY : 0, output, output);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// Compact the batches that still have instances into the indirect commands.
+		compact(frameInfo, drawList, output);
+
+		// The statistics are read on the host once the frame's fence has been waited on. With occlusion culling renderLate() adds to them.
+		if (!frame.occlusionCulling) {
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+	}
+
+	// Reduces the depth pre-pass' depth to a pyramid of farthest depths, one dispatch per level. The render graph leaves
+	// the scene depth readable and the pyramid in the GENERAL layout, between levels only the writes need to be waited on.
+	void CullingRenderSystem::buildDepthPyramid(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("CullingRenderSystem::buildDepthPyramid");
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		const RenderGraph::Image& pyramid = renderGraph.getImage(depthPyramid);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		pyramidPipeline.bind(commandBuffer, pyramidPipeline.getPipeline());
+		for (uint32_t level = 0; level < pyramid.subresourceRange.levelCount; ++level) {
+			if (level > 0) {
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			const uint32_t width = std::max(pyramid.extent.width >> level, 1u);
+			const uint32_t height = std::max(pyramid.extent.height >> level, 1u);
+			pyramidPipeline.bindDescriptorSets(commandBuffer, 0, {pyramidDescriptorSets[level]});
+			vkCmdDispatch(commandBuffer, (width + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE, (height + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE, 1);
+		}
+	}
+
+	void CullingRenderSystem::renderLate(FrameInfo& frameInfo, const DrawList& drawList) {
+		ASPEN_PROFILE_SCOPE("CullingRenderSystem::renderLate");
+		if (drawList.indirectDrawCount == 0) {
+			return;
+		}
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+		// Test every instance against the depth pyramid. Everything visible goes to the visible output, what the first phase missed also to the late output.
+		cull(frameInfo, drawList, CULL_LATE, VISIBLE_OUTPUT, LATE_OUTPUT);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// The two outputs do not share any memory, so both compactions can run at once.
+		compact(frameInfo, drawList, VISIBLE_OUTPUT);
+		compact(frameInfo, drawList, LATE_OUTPUT);
+
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		frames[frameInfo.frameIndex].visibilityCount = static_cast<uint32_t>(drawList.instanceSlots.size());
+	}
+
+	void CullingRenderSystem::onResize() {
+		writePyramidDescriptorSets();
+	}
+} // namespace Aspen
\ No newline at end of file
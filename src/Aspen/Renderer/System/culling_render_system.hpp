@@ -0,0 +1,117 @@
+#pragma once
+#include "Aspen/Renderer/System/global_render_system.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
+
+namespace Aspen {
+	// Culls the frame's instances in compute passes and compacts the survivors into indirect draw commands.
+	// The depth pre-pass and the passes after it draw from its output with vkCmdDrawIndexedIndirectCount.
+	//
+	// Without occlusion culling render() only tests the camera frustum. With it culling runs in two phases around the depth
+	// pre-pass: render() keeps the instances that were visible last frame, which the depth pre-pass draws, then
+	// buildDepthPyramid() reduces that depth to a Hi-Z pyramid and renderLate() tests every instance against it. The
+	// instances found visible are what the later passes draw and next frame's first phase starts from, the ones the first
+	// phase missed are also drawn by the late depth pre-pass so the depth is complete.
+	class CullingRenderSystem {
+	public:
+		static constexpr uint32_t WORKGROUP_SIZE = 64;
+		static constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;
+
+		// The render graph passes recording render(), buildDepthPyramid() and renderLate(). The GPU profiler times them by these names.
+		static constexpr const char* CULLING_PASS = "Culling";
+		static constexpr const char* DEPTH_PYRAMID_PASS = "Depth Pyramid";
+		static constexpr const char* OCCLUSION_CULLING_PASS = "Occlusion Culling";
+
+		CullingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle depthImage, RenderGraph::ResourceHandle depthPyramid);
+		~CullingRenderSystem();
+
+		CullingRenderSystem(const CullingRenderSystem&) = delete;
+		CullingRenderSystem& operator=(const CullingRenderSystem&) = delete;
+
+		CullingRenderSystem(CullingRenderSystem&&) = delete;            // Move Constructor
+		CullingRenderSystem& operator=(CullingRenderSystem&&) = delete; // Move Assignment Operator
+
+		void createPipelines();
+
+		// Points the draw list at the culling passes' outputs, before the passes drawing from them are recorded.
+		// Must be called after GlobalRenderSystem::updateUBOs() has filled the frame's instance and indirect command buffers.
+		// Also reports the statistics of the last time this frame index was rendered, the GPU is done with them by now.
+		void prepare(FrameInfo& frameInfo, DrawList& drawList, Buffer& instanceBuffer, bool occlusionCulling);
+		// Record the culling passes, outside of a render pass. The render graph makes their output visible to the draws.
+		void render(FrameInfo& frameInfo, const DrawList& drawList);
+		void buildDepthPyramid(FrameInfo& frameInfo);
+		void renderLate(FrameInfo& frameInfo, const DrawList& drawList);
+		void onResize();
+
+	private:
+		// The culled draws of one phase, see DrawList::CulledDraws.
+		enum OutputIndex : uint32_t {
+			VISIBLE_OUTPUT,
+			EARLY_OUTPUT,
+			LATE_OUTPUT,
+			OUTPUT_COUNT
+		};
+
+		struct Output {
+			std::unique_ptr<Buffer> instances;
+			std::unique_ptr<Buffer> commands;
+			std::unique_ptr<Buffer> counters;              // Draw count followed by the surviving instance count of every batch.
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE; // Written by the cull and compact shaders.
+			VkDescriptorSet instanceDescriptorSet = VK_NULL_HANDLE;
+		};
+
+		// Counted by the cull shader, read back once the frame index comes around again.
+		struct CullStats {
+			uint32_t inFrustum;
+			uint32_t early;
+			uint32_t late;
+			uint32_t visible;
+		};
+
+		struct FrameResources {
+			std::array<Output, OUTPUT_COUNT> outputs;
+			std::unique_ptr<Buffer> visibility;        // Whether every entity passed the late phase, indexed by entity index.
+			std::unique_ptr<Buffer> retiredVisibility; // Replaced by the last growth, kept until the next frame is done reading it.
+			std::unique_ptr<Buffer> stats;             // CullStats.
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+			// What the frame recorded, for reading back its statistics.
+			uint32_t visibilityCount = 0; // Entities the late phase wrote a visibility for, 0 if it did not run.
+			uint32_t testedInstances = 0;
+			bool occlusionCulling = false;
+		};
+
+		void createDescriptorPool();
+		void createDescriptorSetLayouts();
+		void createDescriptorSets();
+		void writePyramidDescriptorSets();
+		void createPipelineLayouts();
+		void createSampler();
+		void reserveBuffers(int frameIndex, OutputIndex output, uint32_t instanceCount, uint32_t drawCount);
+		void reserveVisibility(int frameIndex, uint32_t entityCount);
+		void readStats(FrameInfo& frameInfo);
+
+		void cull(FrameInfo& frameInfo, const DrawList& drawList, uint32_t flags, OutputIndex output, OutputIndex lateOutput);
+		void compact(FrameInfo& frameInfo, const DrawList& drawList, OutputIndex output);
+
+		Device& device;
+		Renderer& renderer;
+		RenderGraph& renderGraph;
+		RenderGraph::ResourceHandle depthImage;
+		RenderGraph::ResourceHandle depthPyramid;
+		std::unique_ptr<DescriptorSetLayout>& instanceDescriptorSetLayout;
+
+		Pipeline cullPipeline{device};
+		Pipeline compactPipeline{device};
+		Pipeline pyramidPipeline{device};
+
+		// Sized for every frame's sets and one pyramid set per level of the largest pyramid the device can create.
+		std::unique_ptr<DescriptorPool> descriptorPool{};
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout{};       // Inputs of the cull shader.
+		std::unique_ptr<DescriptorSetLayout> outputDescriptorSetLayout{}; // One Output.
+		std::unique_ptr<DescriptorSetLayout> pyramidDescriptorSetLayout{};
+		std::vector<VkDescriptorSet> pyramidDescriptorSets; // One per level of the depth pyramid.
+		VkSampler sampler = VK_NULL_HANDLE;
+
+		std::vector<FrameResources> frames;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -1,34 +1,47 @@
 #include "Aspen/Renderer/System/depth_prepass_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 	struct SimplePushConstantData {
 		glm::mat4 projectionViewMatrix{1.0f};
-		glm::mat4 modelMatrix{1.0f};
 	};
 
-	DepthPrePassRenderSystem::DepthPrePassRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout)
-	    : device(device), renderer(renderer), resources(std::make_unique<Framebuffer>(device)) {
+	DepthPrePassRenderSystem::DepthPrePassRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle depthImage)
+	    : device(device), renderer(renderer), renderGraph(renderGraph), depthImage(depthImage), resources(std::make_unique<Framebuffer>(device)), lateResources(std::make_unique<Framebuffer>(device)) {
 
 		createResources();
-		createPipelineLayout(globalDescriptorSetLayout[0]); // We only care about the normal UBO for this render system.
-		createPipelines();
+		createPipelineLayout(globalDescriptorSetLayout);
 	}
 
+	// The depth buffer belongs to the render graph, the later passes load it through this framebuffer's attachment.
+	// The late pass draws on top of the depth the first one left, through a second framebuffer with a compatible render pass.
 	void DepthPrePassRenderSystem::createResources() {
-		AttachmentCreateInfo attachmentCreateInfo{};
-		VulkanTools::getSupportedDepthFormat(device.physicalDevice(), &attachmentCreateInfo.format);
-		attachmentCreateInfo.width = renderer.getSwapChainExtent().width;
-		attachmentCreateInfo.height = renderer.getSwapChainExtent().height;
-		attachmentCreateInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
-		attachmentCreateInfo.layerCount = 1;
-		attachmentCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		attachmentCreateInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		attachmentCreateInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		attachmentCreateInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		attachmentCreateInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-		resources->createAttachment(attachmentCreateInfo);
+		const RenderGraph::Image& depth = renderGraph.getImage(depthImage);
+
+		AttachmentAddInfo attachmentAddInfo{};
+		attachmentAddInfo.format = depth.format;
+		attachmentAddInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
+		attachmentAddInfo.view = depth.view;
+		attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentAddInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		attachmentAddInfo.layerCount = 1;
+		attachmentAddInfo.width = depth.extent.width;
+		attachmentAddInfo.height = depth.extent.height;
+		attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachmentAddInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+		resources->addLoadAttachment(attachmentAddInfo);
 		resources->createRenderPass();
+
+		attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+		lateResources->addLoadAttachment(attachmentAddInfo);
+		lateResources->createRenderPass();
 	}
 
 	// Create a Descriptor Set Layout for a Uniform Buffer Object (UBO) & Textures.
@@ -43,22 +56,18 @@ namespace Aspen {
 	void DepthPrePassRenderSystem::createDescriptorSet() {
 		// auto bufferInfo = uboBuffer->descriptorInfo();
 		// auto depthPrePass = renderer.getDepthPrePass();
-		DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-		    // .writeBuffer(0, &bufferInfo)
-		    // .writeImage(0, &depthPrePass.descriptor)
-		    .build(descriptorSet);
+		if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+		         // .writeBuffer(0, &bufferInfo)
+		         // .writeImage(0, &depthPrePass.descriptor)
+		         .build(descriptorSet)) {
+			throw std::runtime_error("Failed to allocate depth pre-pass descriptor set!");
+		}
 	}
 
-	// Create a pipeline layout.
-	void DepthPrePassRenderSystem::createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                              // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout->getDescriptorSetLayout()};
-		depthPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
-		stencilPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	// Create a pipeline layout. Both pipelines only use the shared sets.
+	void DepthPrePassRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
+		GlobalRenderSystem::createRasterPipelineLayout(depthPipeline, globalDescriptorSetLayout);
+		GlobalRenderSystem::createRasterPipelineLayout(stencilPipeline, globalDescriptorSetLayout);
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -95,10 +104,10 @@ namespace Aspen {
 		stencilPipeline.createGraphicsPipeline(pipelineConfig, stencilPipeline.getPipeline());
 	}
 
-	RenderInfo DepthPrePassRenderSystem::prepareRenderInfo() {
+	RenderInfo DepthPrePassRenderSystem::prepareRenderInfo(bool late) {
 		RenderInfo renderInfo{};
-		renderInfo.renderPass = resources->renderPass;
-		renderInfo.framebuffer = resources->framebuffer;
+		renderInfo.renderPass = late ? lateResources->renderPass : resources->renderPass;
+		renderInfo.framebuffer = late ? lateResources->framebuffer : resources->framebuffer;
 
 		std::vector<VkClearValue> clearValues{1};
 		clearValues[0].depthStencil = {1.0f, 0};
@@ -107,32 +116,33 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getSwapChainExtent()};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getRenderExtent()};
 
 		return renderInfo;
 	}
 
 	void DepthPrePassRenderSystem::render(FrameInfo& frameInfo, entt::entity selectedEntity) {
+		ASPEN_PROFILE_SCOPE("DepthPrePassRenderSystem::render");
+		SimplePushConstantData push{};
+		// Projection, View matrix.
+		push.projectionViewMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+
 		// First, write the selected entity to the stencil buffer.
 		{
 			if (selectedEntity != entt::null) {
 				stencilPipeline.bind(frameInfo.commandBuffer, stencilPipeline.getPipeline());
-				auto [transform, mesh] = frameInfo.scene->getRenderComponents().get<TransformComponent, MeshComponent>(selectedEntity);
-
-				SimplePushConstantData push{};
-				// Projection, View, Model Transformation matrix.
-				push.projectionViewMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView();
-				push.modelMatrix = transform.transform();
-				vkCmdPushConstants(frameInfo.commandBuffer, stencilPipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SimplePushConstantData), &push);
+				// The unculled instances bound with the frame sets are still bound, the selected entity may have been culled.
+				vkCmdPushConstants(frameInfo.commandBuffer, stencilPipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
 
-				Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-				Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+				auto& mesh = frameInfo.scene->getRenderComponents().get<MeshComponent>(selectedEntity);
+				frameInfo.bindState.bindGeometry(frameInfo.commandBuffer, mesh.geometry->vertexBuffer->getBuffer(), mesh.geometry->indexBuffer->getBuffer());
+				Aspen::Model::drawInstanced(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.geometry->indices.size()), 1, frameInfo.drawList.getInstanceSlot(selectedEntity));
 			}
 		}
 
@@ -140,25 +150,34 @@ namespace Aspen {
 		{
 			// Bind the graphics pipieline.
 			depthPipeline.bind(frameInfo.commandBuffer, depthPipeline.getPipeline());
-			auto group = frameInfo.scene->getRenderComponents();
-			for (auto& entity : group) {
-				auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
-
-				SimplePushConstantData push{};
-				// Projection, View, Model Transformation matrix.
-				push.projectionViewMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView();
-				push.modelMatrix = transform.transform();
-				vkCmdPushConstants(frameInfo.commandBuffer, depthPipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SimplePushConstantData), &push);
-
-				Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-				Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+			VkDescriptorSet instanceDescriptorSet = frameInfo.drawList.getInstanceDescriptorSet(frameInfo.descriptorSet[1], DrawList::Instances::EARLY);
+			if (instanceDescriptorSet != frameInfo.descriptorSet[1]) {
+				depthPipeline.bindDescriptorSets(frameInfo.commandBuffer, GlobalRenderSystem::INSTANCE_SET, {instanceDescriptorSet});
 			}
+			vkCmdPushConstants(frameInfo.commandBuffer, depthPipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
+
+			frameInfo.drawList.draw(frameInfo.commandBuffer, frameInfo.bindState, frameInfo.appState.useIndirectDraw, DrawList::Instances::EARLY);
 		}
 	}
 
+	// Adds the instances occlusion culling found visible that were hidden last frame, so the passes after it test against a complete depth buffer.
+	void DepthPrePassRenderSystem::renderLate(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("DepthPrePassRenderSystem::renderLate");
+		SimplePushConstantData push{};
+		push.projectionViewMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+
+		depthPipeline.bind(frameInfo.commandBuffer, depthPipeline.getPipeline());
+		depthPipeline.bindDescriptorSets(frameInfo.commandBuffer, GlobalRenderSystem::INSTANCE_SET, {frameInfo.drawList.getInstanceDescriptorSet(frameInfo.descriptorSet[1], DrawList::Instances::LATE)});
+		vkCmdPushConstants(frameInfo.commandBuffer, depthPipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
+
+		frameInfo.drawList.draw(frameInfo.commandBuffer, frameInfo.bindState, frameInfo.appState.useIndirectDraw, DrawList::Instances::LATE);
+	}
+
+	// The render graph recreated the depth buffer, both render passes stay.
 	void DepthPrePassRenderSystem::onResize() {
-		resources->clearFramebuffer();
-		createResources();
+		const RenderGraph::Image& depth = renderGraph.getImage(depthImage);
+		resources->recreateFramebuffer(depth.extent.width, depth.extent.height, {depth.view});
+		lateResources->recreateFramebuffer(depth.extent.width, depth.extent.height, {depth.view});
 		// for (int i = 0; i < offscreenDescriptorSets.size(); ++i) {
 		// 	auto bufferInfo = uboBuffers[i]->descriptorInfo();
 		// 	DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
@@ -1,10 +1,11 @@
 #pragma once
 #include "Aspen/Renderer/System/global_render_system.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
 
 namespace Aspen {
 	class DepthPrePassRenderSystem {
 	public:
-		DepthPrePassRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
+		DepthPrePassRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle depthImage);
 		~DepthPrePassRenderSystem() = default;
 
 		DepthPrePassRenderSystem(const DepthPrePassRenderSystem&) = delete;
@@ -13,9 +14,11 @@ namespace Aspen {
 		DepthPrePassRenderSystem(DepthPrePassRenderSystem&&) = delete;            // Move Constructor
 		DepthPrePassRenderSystem& operator=(DepthPrePassRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo, entt::entity selectedEntity);
+		void renderLate(FrameInfo& frameInfo);
 		void createResources();
-		RenderInfo prepareRenderInfo();
+		RenderInfo prepareRenderInfo(bool late = false);
 		void onResize();
 
 		std::shared_ptr<Framebuffer> getResources() {
@@ -29,12 +32,14 @@ namespace Aspen {
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
-		void createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout);
+		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
 
 		Device& device;
 		Renderer& renderer;
+		RenderGraph& renderGraph;
+		RenderGraph::ResourceHandle depthImage;
 		std::shared_ptr<Framebuffer> resources;
+		std::shared_ptr<Framebuffer> lateResources; // Loads the depth instead of clearing it, for renderLate().
 		Pipeline depthPipeline{device};
 		Pipeline stencilPipeline{device};
 
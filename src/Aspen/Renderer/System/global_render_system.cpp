@@ -1,8 +1,12 @@
 #include "Aspen/Renderer/System/global_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
+#include <numeric>
+
 namespace Aspen {
 	GlobalRenderSystem::GlobalRenderSystem(Device& device, Renderer& renderer)
-	    : device(device), renderer(renderer), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), dynamicUboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), uboDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), dynamicUboDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+	    : device(device), renderer(renderer), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), instanceBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), indirectCommandBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), lightBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), clusterBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), lightIndexBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), uboDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), instanceDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), framePipeline(device) {
 		for (int i = 0; i < uboBuffers.size(); ++i) {
 			// Create a UBO buffer. This will just be one instance per frame.
 			uboBuffers[i] = std::make_unique<Buffer>(
@@ -16,34 +20,53 @@ namespace Aspen {
 			// Map the buffer's memory so we can begin writing to it.
 			uboBuffers[i]->map();
 
-			// Create a UBO buffer. This will just be one instance per frame.
-			dynamicUboBuffers[i] = std::make_unique<Buffer>(
+			// Create the instance buffer. It grows with the number of render entities, see reserveInstances().
+			instanceBuffers[i] = std::make_unique<Buffer>(
 			    device,
-			    sizeof(ModelUboDynamic),
+			    sizeof(InstanceData),
 			    10,
-			    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, // We could make it device local but the performance gains could be cancelled out from writing to the UBO every frame.
-			    device.properties.limits.minUniformBufferOffsetAlignment);
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT); // Rewritten every frame, so keep it host visible.
 
 			// Map the buffer's memory so we can begin writing to it.
-			dynamicUboBuffers[i]->map();
+			instanceBuffers[i]->map();
+
+			// Create the indirect draw command buffer. One command per unique geometry, see reserveIndirectCommands().
+			indirectCommandBuffers[i] = std::make_unique<Buffer>(
+			    device,
+			    sizeof(VkDrawIndexedIndirectCommand),
+			    10,
+			    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // Also read by the culling pass.
+			    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			indirectCommandBuffers[i]->map();
+
+			// Create the light buffers. They grow with the lights and the light grid, see reserveLights().
+			lightBuffers[i] = std::make_unique<Buffer>(device, sizeof(PointLight), 16, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			lightBuffers[i]->map();
+			clusterBuffers[i] = std::make_unique<Buffer>(device, sizeof(glm::uvec2), 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			clusterBuffers[i]->map();
+			lightIndexBuffers[i] = std::make_unique<Buffer>(device, sizeof(uint32_t), 1024, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			lightIndexBuffers[i]->map();
 		}
 
 		createDescriptorSetLayout();
 		createDescriptorSet();
+		createRasterPipelineLayout(framePipeline, descriptorSetLayouts);
 	}
 
 	// Create a Descriptor Set Layout for a Uniform Buffer Object (UBO) & Textures.
 	void GlobalRenderSystem::createDescriptorSetLayout() {
 		// Standard UBO
 		descriptorSetLayouts.push_back(DescriptorSetLayout::Builder(device)
-		                                   .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR) // Binding 0: Vertex shader uniform buffer
-		                                                                                                                                                                                 //   .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)                      // Binding 2: Fragment shader image sampler
+		                                   .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR) // Binding 0: Vertex shader uniform buffer
+		                                   .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR)                                                                  // Binding 1: Point lights
+		                                   .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)                                                                                                        // Binding 2: Light grid clusters
+		                                   .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)                                                                                                        // Binding 3: Light grid light indices
 		                                   .build());
 
-		// Dynamic UBO
+		// Instance SSBO
 		descriptorSetLayouts.push_back(DescriptorSetLayout::Builder(device)
-		                                   .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT) // Binding 0: Vertex shader dynamic uniform buffer
+		                                   .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT) // Binding 0: Vertex shader per instance storage buffer
 		                                   .build());
 	}
 
@@ -52,22 +75,89 @@ namespace Aspen {
 		// Create descriptor sets for normal UBO.
 		for (int i = 0; i < uboDescriptorSets.size(); ++i) {
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			DescriptorWriter(*descriptorSetLayouts[0], device.getDescriptorPool())
-			    .writeBuffer(0, &bufferInfo)
-			    .build(uboDescriptorSets[i]);
+			auto lightBufferInfo = lightBuffers[i]->descriptorInfo();
+			auto clusterBufferInfo = clusterBuffers[i]->descriptorInfo();
+			auto lightIndexBufferInfo = lightIndexBuffers[i]->descriptorInfo();
+			if (!DescriptorWriter(*descriptorSetLayouts[0], device.getDescriptorPool())
+			         .writeBuffer(0, &bufferInfo)
+			         .writeBuffer(1, &lightBufferInfo)
+			         .writeBuffer(2, &clusterBufferInfo)
+			         .writeBuffer(3, &lightIndexBufferInfo)
+			         .build(uboDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate global uniform buffer descriptor set!");
+			}
 		}
 
-		// Create descriptor sets for dynamic UBO.
-		for (int i = 0; i < dynamicUboDescriptorSets.size(); ++i) {
-			auto dynamicBufferInfo = dynamicUboBuffers[i]->descriptorInfo(dynamicUboBuffers[i]->getAlignmentSize());
-			DescriptorWriter(*descriptorSetLayouts[1], device.getDescriptorPool())
-			    .writeBuffer(0, &dynamicBufferInfo)
-			    .build(dynamicUboDescriptorSets[i]);
+		// Create descriptor sets for the instance buffers.
+		for (int i = 0; i < instanceDescriptorSets.size(); ++i) {
+			auto instanceBufferInfo = instanceBuffers[i]->descriptorInfo();
+			if (!DescriptorWriter(*descriptorSetLayouts[1], device.getDescriptorPool())
+			         .writeBuffer(0, &instanceBufferInfo)
+			         .build(instanceDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate instance descriptor set!");
+			}
 		}
 	}
 
+	void GlobalRenderSystem::createRasterPipelineLayout(Pipeline& pipeline, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, const std::vector<VkDescriptorSetLayout>& passDescriptorSetLayouts) {
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = PUSH_CONSTANT_SIZE;
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayouts[FRAME_SET]->getDescriptorSetLayout(), globalDescriptorSetLayouts[INSTANCE_SET]->getDescriptorSetLayout()};
+		descriptorSetLayouts.insert(descriptorSetLayouts.end(), passDescriptorSetLayouts.begin(), passDescriptorSetLayouts.end());
+		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	}
+
+	void GlobalRenderSystem::bindFrameDescriptorSets(FrameInfo& frameInfo) {
+		framePipeline.bindDescriptorSets(frameInfo.commandBuffer, FRAME_SET, {frameInfo.descriptorSet[FRAME_SET], frameInfo.descriptorSet[INSTANCE_SET]});
+	}
+
 	// Update the global UBO.
-	void GlobalRenderSystem::updateUBOs(FrameInfo& frameInfo) {
+	void GlobalRenderSystem::updateUBOs(FrameInfo& frameInfo, const std::vector<entt::entity>& shadowedLights) {
+		ASPEN_PROFILE_SCOPE("GlobalRenderSystem::updateUBOs");
+		// Update the lights and the light grid. Every light is shaded, each fragment only loops over the lights whose
+		// radius of influence reaches its cluster.
+		auto pointLightGroup = frameInfo.scene->getPointLights();
+		const auto lightCount = static_cast<uint32_t>(pointLightGroup.size());
+		{
+			lightSpheres.clear();
+			for (const auto& entity : pointLightGroup) {
+				auto [transform, pointLight] = pointLightGroup.get<TransformComponent, PointLightComponent>(entity);
+				lightSpheres.emplace_back(transform.translation, pointLight.influenceRadius());
+			}
+			lightGrid.build(frameInfo.camera, renderer.getRenderExtent(), lightSpheres); // Tiles of gl_FragCoord, so of the render extent.
+
+			const auto& clusters = lightGrid.getClusters();
+			const auto& lightIndices = lightGrid.getLightIndices();
+			reserveLights(frameInfo.frameIndex, lightCount, static_cast<uint32_t>(clusters.size()), static_cast<uint32_t>(lightIndices.size()));
+
+			auto* lights = static_cast<PointLight*>(lightBuffers[frameInfo.frameIndex]->getMappedMemory());
+			uint32_t lightIndex = 0;
+			for (const auto& entity : pointLightGroup) {
+				auto& pointLight = pointLightGroup.get<PointLightComponent>(entity);
+				lights[lightIndex].position = lightSpheres[lightIndex];
+				lights[lightIndex].color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+				// Only a handful of lights have a shadow, so a linear search is cheaper than a lookup table.
+				auto shadow = std::find(shadowedLights.begin(), shadowedLights.end(), entity);
+				lights[lightIndex].shadowIndex = shadow == shadowedLights.end() ? -1 : static_cast<int32_t>(shadow - shadowedLights.begin());
+				++lightIndex;
+			}
+			std::memcpy(clusterBuffers[frameInfo.frameIndex]->getMappedMemory(), clusters.data(), clusters.size() * sizeof(glm::uvec2));
+			std::memcpy(lightIndexBuffers[frameInfo.frameIndex]->getMappedMemory(), lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
+			lightBuffers[frameInfo.frameIndex]->flush();
+			clusterBuffers[frameInfo.frameIndex]->flush();
+			lightIndexBuffers[frameInfo.frameIndex]->flush();
+
+			const LightGrid::Stats& stats = lightGrid.getStats();
+			frameInfo.appState.clusteredLights = lightCount;
+			frameInfo.appState.occupiedClusters = stats.occupiedClusters;
+			frameInfo.appState.clusterCount = stats.clusterCount;
+			frameInfo.appState.maxClusterLights = stats.maxClusterLights;
+		}
+
 		// Update Global UBO
 		{
 			GlobalUbo globalUbo{};
@@ -75,58 +165,234 @@ namespace Aspen {
 			globalUbo.viewMatrix = frameInfo.camera.getView();
 			globalUbo.inverseProjectionMatrix = frameInfo.camera.getInverseProjection();
 			globalUbo.inverseViewMatrix = frameInfo.camera.getInverseView();
+			globalUbo.lightCount = lightCount;
+			globalUbo.clusterGrid = lightGrid.getGridSize();
+			globalUbo.clusterDepth = lightGrid.getDepthParams();
+
+			uboBuffers[frameInfo.frameIndex]->writeToBuffer(&globalUbo); // Write info to the UBO.
+			uboBuffers[frameInfo.frameIndex]->flush();
+		}
+
+		// Update Instances
+		// Render entities are bucketed by geometry and written to the instance buffer bucket by bucket,
+		// so every bucket is a contiguous range which can be drawn with a single instanced draw call.
+		{
+			auto group = frameInfo.scene->getRenderComponents();
+			const SceneData& sceneData = frameInfo.scene->getSceneData();
+			const auto instanceCount = static_cast<uint32_t>(group.size());
+			reserveInstances(frameInfo.frameIndex, instanceCount);
 
-			int lightIndex = 0;
+			drawList.batches.clear();
+			drawList.culled = false;
+			batchLookup.clear();
+			batchDistances.clear();
+			instanceDistances.resize(instanceCount);
 
-			auto group = frameInfo.scene->getPointLights();
+			// Count the instances of every geometry, and find how close each batch comes to the camera.
+			const glm::vec3 cameraPosition = glm::vec3(frameInfo.camera.getInverseView()[3]);
+			const bool sortFrontToBack = frameInfo.appState.sortFrontToBack;
+			float maxDistance = 0.0f;
+			uint32_t maxEntityId = 0;
+			uint32_t position = 0;
 			for (const auto& entity : group) {
-				assert(lightIndex < MAX_LIGHTS && "Point lights exceeded maximum specified!");
+				auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
+
+				auto [it, inserted] = batchLookup.try_emplace(mesh.geometry.get(), static_cast<uint32_t>(drawList.batches.size()));
+				if (inserted) {
+					drawList.batches.push_back({mesh.geometry.get(), 0, 0, DrawBatch::INVALID_GEOMETRY, DrawBatch::LOOSE_BATCH});
+					batchDistances.push_back(std::numeric_limits<float>::max());
+				}
+				++drawList.batches[it->second].instanceCount;
+				maxEntityId = std::max(maxEntityId, static_cast<uint32_t>(entt::to_entity(entity)));
+
+				if (sortFrontToBack) {
+					const float distance = glm::distance(cameraPosition, transform.translation);
+					instanceDistances[position] = distance;
+					batchDistances[it->second] = std::min(batchDistances[it->second], distance);
+					maxDistance = std::max(maxDistance, distance);
+				}
+				++position;
+			}
+
+			// Draw the batch with the closest instance first, it is the most likely to occlude the others.
+			if (sortFrontToBack && drawList.batches.size() > 1) {
+				batchOrder.resize(drawList.batches.size());
+				std::iota(batchOrder.begin(), batchOrder.end(), 0u);
+				std::sort(batchOrder.begin(), batchOrder.end(), [this](uint32_t a, uint32_t b) { return batchDistances[a] < batchDistances[b]; });
+
+				sortedBatches.clear();
+				for (uint32_t index : batchOrder) {
+					batchLookup[drawList.batches[index].geometry] = static_cast<uint32_t>(sortedBatches.size());
+					sortedBatches.push_back(drawList.batches[index]);
+				}
+				drawList.batches.swap(sortedBatches);
+			}
+
+			// Geometry packed into the scene buffers is drawn from one indirect command per batch, anything added later is drawn on its own.
+			reserveIndirectCommands(frameInfo.frameIndex, static_cast<uint32_t>(drawList.batches.size()));
 
-				auto [transform, pointLight] = group.get<TransformComponent, PointLightComponent>(entity);
-				// auto rotateLights = glm::rotate(glm::mat4(1.0f), static_cast<float>(frameInfo.frameTime), {0.0f, -1.0f, 0.0f});
+			drawList.sceneVertexBuffer = sceneData.vertexBuffer.get();
+			drawList.sceneIndexBuffer = sceneData.indexBuffer.get();
+			drawList.indirectCommandBuffer = indirectCommandBuffers[frameInfo.frameIndex].get();
+			drawList.indirectDrawCount = 0;
+			drawList.looseBatches.clear();
 
-				// Update light position
-				// 1) Translate the light to the center
-				// 2) Make the rotation
-				// 3) Translate the object back to its original location
-				// auto transformTemp = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 2.5f));
-				// auto translationTemp = (transformTemp * rotateLights * glm::inverse(transformTemp)) * glm::vec4(transform.translation, 1.0f);
+			// Prefix sum the counts to find where each bucket starts.
+			auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(indirectCommandBuffers[frameInfo.frameIndex]->getMappedMemory());
+			uint32_t firstInstance = 0;
+			for (uint32_t i = 0; i < drawList.batches.size(); ++i) {
+				auto& batch = drawList.batches[i];
+				batch.firstInstance = firstInstance;
+				firstInstance += batch.instanceCount;
 
-				// copy light to ubo
-				// ubo.lights[lightIndex].position = translationTemp;
-				globalUbo.lights[lightIndex].position = glm::vec4(transform.translation, 1.0f);
-				globalUbo.lights[lightIndex].color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+				auto it = sceneData.geometryIndices.find(batch.geometry);
+				if (it == sceneData.geometryIndices.end() || !drawList.sceneVertexBuffer) {
+					drawList.looseBatches.push_back(i);
+				} else {
+					batch.geometryIndex = it->second;
+					batch.commandIndex = drawList.indirectDrawCount++;
 
-				if (++lightIndex == MAX_LIGHTS) {
-					break;
+					VkDrawIndexedIndirectCommand& command = commands[batch.commandIndex];
+					command.indexCount = static_cast<uint32_t>(batch.geometry->indices.size());
+					command.instanceCount = batch.instanceCount;
+					command.firstIndex = sceneData.geometryOffsets[batch.geometryIndex].x;
+					command.vertexOffset = static_cast<int32_t>(sceneData.geometryOffsets[batch.geometryIndex].y);
+					command.firstInstance = batch.firstInstance;
 				}
+
+				// Local bounding sphere of the geometry, used for culling. Geometry without a BVH is never culled.
+				if (batch.geometry->bvh.empty()) {
+					batch.boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, std::numeric_limits<float>::max());
+				} else {
+					const Math::AABB& bounds = batch.geometry->bvh.getBounds();
+					batch.boundingSphere = glm::vec4(bounds.center(), 0.5f * glm::length(bounds.max - bounds.min));
+				}
+
+				batch.instanceCount = 0;
 			}
-			// ubo.numLights = lightIndex;
 
-			uboBuffers[frameInfo.frameIndex]->writeToBuffer(&globalUbo); // Write info to the UBO.
-			uboBuffers[frameInfo.frameIndex]->flush();
-		}
+			drawList.instanceSlots.resize(maxEntityId + 1);
 
-		// Update Dynamic UBO
-		{
-			int index = 0;
-			auto group = frameInfo.scene->getRenderComponents();
+			// Order the instances by batch and then by distance. The packet index is the entity's position in the group.
+			renderQueue.clear();
+			renderQueue.reserve(instanceCount);
+			position = 0;
 			for (const auto& entity : group) {
-				auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
+				if (sortFrontToBack) {
+					const uint32_t batchIndex = batchLookup[group.get<MeshComponent>(entity).geometry.get()];
+					renderQueue.push(SortKey::make(batchIndex, SortKey::quantizeDepth(instanceDistances[position], maxDistance)), position);
+				} else {
+					renderQueue.push(0, position);
+				}
+				++position;
+			}
+			renderQueue.sort();
 
-				ModelUboDynamic dynamicUbo{};
+			auto* instances = static_cast<InstanceData*>(instanceBuffers[frameInfo.frameIndex]->getMappedMemory());
+			for (const auto& packet : renderQueue.getPackets()) {
+				const entt::entity entity = group[packet.index];
+				auto [transform, mesh, material] = group.get<TransformComponent, MeshComponent, MaterialComponent>(entity);
 
-				// Aligned offset
-				// glm::mat4* modelMat = (glm::mat4*)(((uint64_t)dynamicUbo.modelMatrix + (index * uboBuffers[frameInfo.frameIndex]->getAlignmentSize())));
+				auto& batch = drawList.batches[batchLookup[mesh.geometry.get()]];
+				const uint32_t slot = batch.firstInstance + batch.instanceCount++;
 
-				dynamicUbo.modelMatrix = transform.transform();
-				dynamicUbo.normalMatrix = transform.computeNormalMatrix();
+				InstanceData& instance = instances[slot];
+				instance.modelMatrix = transform.transform();
+				instance.normalMatrix = transform.computeNormalMatrix();
+				instance.textureIndex = material.diffuseTextureId;
+				instance.materialIndex = NO_MATERIAL;
+				if (auto materialIndex = sceneData.materialIndices.find(entity); materialIndex != sceneData.materialIndices.end()) {
+					assert(materialIndex->second < sceneData.materialBuffer->getInstanceCount() && "The material indices and the material buffer are out of sync.");
+					instance.materialIndex = materialIndex->second;
+				}
+				instance.batchIndex = batch.commandIndex;
+				instance.entityId = static_cast<uint32_t>(entity);
+				instance.entityIndex = static_cast<uint32_t>(entt::to_entity(entity));
+				instance.flags = frameInfo.scene->isDynamic(entity) ? INSTANCE_DYNAMIC : 0;
 
-				dynamicUboBuffers[frameInfo.frameIndex]->writeToBuffer(&dynamicUbo, sizeof(dynamicUbo), index * dynamicUboBuffers[frameInfo.frameIndex]->getAlignmentSize()); // Write info to the UBO.
-				++index;
+				// Move the bounding sphere to world space, scaling the radius by the largest axis scale.
+				const float maxScale = glm::max(glm::length(glm::vec3(instance.modelMatrix[0])), glm::max(glm::length(glm::vec3(instance.modelMatrix[1])), glm::length(glm::vec3(instance.modelMatrix[2]))));
+				instance.boundingSphere = glm::vec4(glm::vec3(instance.modelMatrix * glm::vec4(glm::vec3(batch.boundingSphere), 1.0f)), batch.boundingSphere.w * maxScale);
+
+				drawList.instanceSlots[entt::to_entity(entity)] = slot;
+			}
+
+			drawList.instanceCount = firstInstance;
+
+			instanceBuffers[frameInfo.frameIndex]->flush();
+			indirectCommandBuffers[frameInfo.frameIndex]->flush();
+		}
+	}
+
+	// Grows the frame's instance buffer so it holds one slot per render entity.
+	// Only the current frame's buffer is replaced, the GPU is done with it once the frame has begun.
+	void GlobalRenderSystem::reserveInstances(int frameIndex, uint32_t instanceCount) {
+		auto& buffer = instanceBuffers[frameIndex];
+		if (instanceCount <= buffer->getInstanceCount()) {
+			return;
+		}
+
+		buffer = std::make_unique<Buffer>(
+		    device,
+		    sizeof(InstanceData),
+		    std::max(instanceCount, buffer->getInstanceCount() * 2),
+		    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+
+		auto instanceBufferInfo = buffer->descriptorInfo();
+		DescriptorWriter(*descriptorSetLayouts[1], device.getDescriptorPool())
+		    .writeBuffer(0, &instanceBufferInfo)
+		    .overwrite(instanceDescriptorSets[frameIndex]);
+	}
+
+	// Grows the frame's indirect command buffer so it holds one command per batch.
+	void GlobalRenderSystem::reserveIndirectCommands(int frameIndex, uint32_t drawCount) {
+		auto& buffer = indirectCommandBuffers[frameIndex];
+		if (drawCount <= buffer->getInstanceCount()) {
+			return;
+		}
+
+		buffer = std::make_unique<Buffer>(
+		    device,
+		    sizeof(VkDrawIndexedIndirectCommand),
+		    std::max(drawCount, buffer->getInstanceCount() * 2),
+		    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+	}
+
+	// Grows the frame's light buffers so they hold every light and the whole light grid.
+	void GlobalRenderSystem::reserveLights(int frameIndex, uint32_t lightCount, uint32_t clusterCount, uint32_t lightIndexCount) {
+		bool grown = false;
+		auto reserve = [&](std::unique_ptr<Buffer>& buffer, VkDeviceSize elementSize, uint32_t count) {
+			if (count <= buffer->getInstanceCount()) {
+				return;
 			}
 
-			dynamicUboBuffers[frameInfo.frameIndex]->flush();
+			buffer = std::make_unique<Buffer>(
+			    device,
+			    elementSize,
+			    std::max(count, buffer->getInstanceCount() * 2),
+			    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			buffer->map();
+			grown = true;
+		};
+		reserve(lightBuffers[frameIndex], sizeof(PointLight), lightCount);
+		reserve(clusterBuffers[frameIndex], sizeof(glm::uvec2), clusterCount);
+		reserve(lightIndexBuffers[frameIndex], sizeof(uint32_t), lightIndexCount);
+		if (!grown) {
+			return;
 		}
+
+		auto lightBufferInfo = lightBuffers[frameIndex]->descriptorInfo();
+		auto clusterBufferInfo = clusterBuffers[frameIndex]->descriptorInfo();
+		auto lightIndexBufferInfo = lightIndexBuffers[frameIndex]->descriptorInfo();
+		DescriptorWriter(*descriptorSetLayouts[0], device.getDescriptorPool())
+		    .writeBuffer(1, &lightBufferInfo)
+		    .writeBuffer(2, &clusterBufferInfo)
+		    .writeBuffer(3, &lightIndexBufferInfo)
+		    .overwrite(uboDescriptorSets[frameIndex]);
 	}
 } // namespace Aspen
\ No newline at end of file
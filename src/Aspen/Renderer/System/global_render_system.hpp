@@ -2,6 +2,7 @@
 #include "Aspen/Renderer/pipeline.hpp"
 #include "Aspen/Renderer/renderer.hpp"
 #include "Aspen/Renderer/framebuffer.hpp"
+#include "Aspen/Renderer/light_grid.hpp"
 
 namespace Aspen {
 	class RenderSystem {
@@ -19,28 +20,61 @@ namespace Aspen {
 		virtual RenderInfo prepareRenderInfo() = 0;
 	};
 
-	static const int MAX_LIGHTS = 10;
+	static const int MAX_SHADOWED_LIGHTS = 10;
 
 	class GlobalRenderSystem {
 	public:
+		// Every point light of the scene, in the light storage buffer. Laid out to match std430.
 		struct PointLight {
-			glm::vec4 position{};
-			glm::vec4 color{}; // w is intensity
+			glm::vec4 position{};     // w is the radius of influence, see PointLightComponent::influenceRadius().
+			glm::vec4 color{};        // w is intensity
+			int32_t shadowIndex = -1; // Index into ShadowRenderSystem::ShadowUbo::lights, or -1 if the light has no shadow.
+			uint32_t padding[3];
 		};
+		static_assert(sizeof(PointLight) % 16 == 0);
 
 		struct GlobalUbo {
 			glm::mat4 projectionMatrix{1.0f};
 			glm::mat4 viewMatrix{1.0f};
 			glm::mat4 inverseProjectionMatrix{1.0f};
 			glm::mat4 inverseViewMatrix{1.0f};
-			PointLight lights[MAX_LIGHTS];
 			alignas(16) glm::vec3 ambientLightColor{0.1f};
-			// alignas(4) int numLights;
+			uint32_t lightCount = 0;
+			glm::uvec4 clusterGrid{0};    // LightGrid::getGridSize()
+			glm::vec4 clusterDepth{0.0f}; // LightGrid::getDepthParams()
 		};
 
-		struct ModelUboDynamic {
+		// Per instance data, read by the vertex shaders through gl_InstanceIndex. Laid out to match std430.
+		struct InstanceData {
 			glm::mat4 modelMatrix;
 			glm::mat4 normalMatrix;
+			glm::vec4 boundingSphere; // World space centre (xyz) and radius (w).
+			int32_t textureIndex;     // -1 if the instance is not textured.
+			uint32_t materialIndex;   // Index into the scene's material buffer, NO_MATERIAL if the entity was added after it was built.
+			uint32_t batchIndex;      // Indirect command of the instance's batch, or DrawBatch::LOOSE_BATCH.
+			uint32_t entityId;        // Written out by the mouse picking pass.
+			uint32_t flags;           // INSTANCE_* bits.
+			uint32_t entityIndex;     // Entity id without its version, keys the occlusion culling visibility from one frame to the next.
+			uint32_t padding[2];      // std430 rounds the array stride up to the alignment of the matrices.
+		};
+		static_assert(sizeof(InstanceData) % 16 == 0);
+
+		static constexpr uint32_t INSTANCE_DYNAMIC = 1 << 0; // Animated every update, so passes caching static results skip it.
+		static constexpr uint32_t NO_MATERIAL = std::numeric_limits<uint32_t>::max();
+
+		// Every raster pipeline layout is ordered by update frequency:
+		//   set 0      - per frame (global UBO), bound once by bindFrameDescriptorSets().
+		//   set 1      - per pass (instance buffer, culled or not).
+		//   set 2, ... - per pass/material resources owned by the render system (shadow maps, light UBOs, textures).
+		//   per draw   - push constants and the instance data.
+		// The layouts also share one push constant range, so they stay compatible and the lower sets survive pipeline changes.
+		static constexpr VkShaderStageFlags PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		static constexpr uint32_t PUSH_CONSTANT_SIZE = 128; // Guaranteed minimum of maxPushConstantsSize.
+
+		enum DescriptorSetIndex : uint32_t {
+			FRAME_SET = 0,
+			INSTANCE_SET = 1,
+			PASS_SET = 2,
 		};
 
 		GlobalRenderSystem(Device& device, Renderer& renderer);
@@ -54,7 +88,15 @@ namespace Aspen {
 
 		// void render(FrameInfo& frameInfo) override;
 		// void onResize() override;
-		void updateUBOs(FrameInfo& frameInfo);
+		// Writes the frame's UBO, lights, light grid and instances. shadowedLights are the lights with a shadow, in the
+		// order of their shadows, see ShadowRenderSystem::getShadowedLights().
+		void updateUBOs(FrameInfo& frameInfo, const std::vector<entt::entity>& shadowedLights);
+
+		// Creates a raster pipeline layout from the shared sets followed by the render system's own sets.
+		static void createRasterPipelineLayout(Pipeline& pipeline, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, const std::vector<VkDescriptorSetLayout>& passDescriptorSetLayouts = {});
+
+		// Binds the per frame set and the unculled instances. Call once per frame before recording the raster passes.
+		void bindFrameDescriptorSets(FrameInfo& frameInfo);
 
 		std::vector<std::unique_ptr<DescriptorSetLayout>>& getDescriptorSetLayout() {
 			return descriptorSetLayouts;
@@ -64,30 +106,59 @@ namespace Aspen {
 			return uboDescriptorSets;
 		}
 
-		std::vector<VkDescriptorSet>& getDynamicUboDescriptorSets() {
-			return dynamicUboDescriptorSets;
+		std::vector<VkDescriptorSet>& getInstanceDescriptorSets() {
+			return instanceDescriptorSets;
+		}
+
+		DrawList& getDrawList() {
+			return drawList;
+		}
+
+		const LightGrid& getLightGrid() const {
+			return lightGrid;
 		}
 
 		std::vector<std::unique_ptr<Buffer>>& getUboBuffers() {
 			return uboBuffers;
 		}
 
-		std::vector<std::unique_ptr<Buffer>>& getDynamicUboBuffers() {
-			return dynamicUboBuffers;
+		std::vector<std::unique_ptr<Buffer>>& getInstanceBuffers() {
+			return instanceBuffers;
 		}
 
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
+		void reserveInstances(int frameIndex, uint32_t instanceCount);
+		void reserveIndirectCommands(int frameIndex, uint32_t drawCount);
+		void reserveLights(int frameIndex, uint32_t lightCount, uint32_t clusterCount, uint32_t lightIndexCount);
 
 		Device& device;
 		Renderer& renderer;
 
 		std::vector<std::unique_ptr<DescriptorSetLayout>> descriptorSetLayouts{};
 		std::vector<VkDescriptorSet> uboDescriptorSets;
-		std::vector<VkDescriptorSet> dynamicUboDescriptorSets;
+		std::vector<VkDescriptorSet> instanceDescriptorSets;
 
 		std::vector<std::unique_ptr<Buffer>> uboBuffers;
-		std::vector<std::unique_ptr<Buffer>> dynamicUboBuffers;
+		std::vector<std::unique_ptr<Buffer>> instanceBuffers;
+		std::vector<std::unique_ptr<Buffer>> indirectCommandBuffers;
+		std::vector<std::unique_ptr<Buffer>> lightBuffers;      // A PointLight per light.
+		std::vector<std::unique_ptr<Buffer>> clusterBuffers;    // LightGrid::getClusters()
+		std::vector<std::unique_ptr<Buffer>> lightIndexBuffers; // LightGrid::getLightIndices()
+
+		Pipeline framePipeline; // Only owns the shared raster layout, used to bind the per frame sets.
+
+		DrawList drawList{};
+		RenderQueue renderQueue{};
+		LightGrid lightGrid{};
+
+		// Kept around so the buckets and sort scratch do not reallocate every frame.
+		std::unordered_map<MeshComponent::Geometry*, uint32_t> batchLookup;
+		std::vector<float> batchDistances;
+		std::vector<float> instanceDistances;
+		std::vector<uint32_t> batchOrder;
+		std::vector<DrawBatch> sortedBatches;
+		std::vector<glm::vec4> lightSpheres;
 	};
 } // namespace Aspen
\ No newline at end of file
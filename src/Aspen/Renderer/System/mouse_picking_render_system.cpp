@@ -1,16 +1,14 @@
 #include "Aspen/Renderer/System/mouse_picking_render_system.hpp"
 
-namespace Aspen {
-	struct SimplePushConstantData {
-		glm::mat4 modelMatrix{1.0f};
-		alignas(16) uint64_t objectId;
-	};
+#include "Aspen/Core/cpu_profiler.hpp"
 
+namespace Aspen {
 	MousePickingRenderSystem::MousePickingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, std::shared_ptr<Framebuffer> resources)
-	    : device(device), renderer(renderer), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resources), globalDescriptorSetLayout(*globalDescriptorSetLayout[0]) {
-		// Create a UBO buffer. This will just be one instance per frame.
-		{
-			storageBuffer = std::make_unique<Buffer>(
+	    : device(device), renderer(renderer), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resources), globalDescriptorSetLayout(globalDescriptorSetLayout) {
+		// One readback slot per frame in flight, so a pick can be read back while later frames are rendered.
+		slots.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& slot : slots) {
+			slot.storageBuffer = std::make_unique<Buffer>(
 			    device,
 			    sizeof(MousePickingStorageBuffer),
 			    1,
@@ -19,16 +17,15 @@ namespace Aspen {
 			    device.properties.limits.minUniformBufferOffsetAlignment);
 
 			// Map the buffer's memory so we can begin writing to it.
-			storageBuffer->map();
+			slot.storageBuffer->map();
 		}
 
 		loadAttachment();
 
 		createDescriptorSetLayout();
-		createDescriptorSet();
+		createDescriptorSets();
 
 		createPipelineLayout();
-		createPipelines();
 	}
 
 	void MousePickingRenderSystem::loadAttachment() {
@@ -41,8 +38,8 @@ namespace Aspen {
 		attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 		attachmentAddInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 		attachmentAddInfo.layerCount = 1;
-		attachmentAddInfo.width = renderer.getSwapChainExtent().width;
-		attachmentAddInfo.height = renderer.getSwapChainExtent().height;
+		attachmentAddInfo.width = renderer.getTargetExtent().width;
+		attachmentAddInfo.height = renderer.getTargetExtent().height;
 		attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 		attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
@@ -62,24 +59,20 @@ namespace Aspen {
 	}
 
 	// Create Descriptor Sets.
-	void MousePickingRenderSystem::createDescriptorSet() {
-		auto bufferInfo = storageBuffer->descriptorInfo();
-		// auto depthPrePass = renderer.getDepthPrePass();
-		DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-		    .writeBuffer(0, &bufferInfo)
-		    // .writeImage(1, &depthPrePass.descriptor)
-		    .build(descriptorSet);
+	void MousePickingRenderSystem::createDescriptorSets() {
+		for (auto& slot : slots) {
+			auto bufferInfo = slot.storageBuffer->descriptorInfo();
+			if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+			         .writeBuffer(0, &bufferInfo)
+			         .build(slot.descriptorSet)) {
+				throw std::runtime_error("Failed to allocate mouse picking descriptor set!");
+			}
+		}
 	}
 
 	// Create a pipeline layout.
 	void MousePickingRenderSystem::createPipelineLayout() {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                              // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout.getDescriptorSetLayout(), descriptorSetLayout->getDescriptorSetLayout()};
-		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+		GlobalRenderSystem::createRasterPipelineLayout(pipeline, globalDescriptorSetLayout, {descriptorSetLayout->getDescriptorSetLayout()});
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -100,7 +93,9 @@ namespace Aspen {
 		pipeline.createGraphicsPipeline(pipelineConfig, pipeline.getPipeline());
 	}
 
-	RenderInfo MousePickingRenderSystem::prepareRenderInfo() {
+	RenderInfo MousePickingRenderSystem::prepareRenderInfo(int frameIndex) {
+		assert(slots[frameIndex].request && "Cannot prepare the picking pass without a pick in the frame's slot!");
+
 		RenderInfo renderInfo{};
 		renderInfo.renderPass = resources->renderPass;
 		renderInfo.framebuffer = resources->framebuffer;
@@ -112,40 +107,89 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{static_cast<int32_t>(Input::GetMouseX() > 0 ? Input::GetMouseX() : 0), static_cast<int32_t>(Input::GetMouseY() > 0 ? Input::GetMouseY() : 0)}, {1, 1}};
+		// The cursor as it was when the pick was requested, it may have moved since. The depth pre-pass covers the render
+		// extent, which the viewport shows stretched over the whole swap chain extent.
+		const VkExtent2D renderExtent = renderer.getRenderExtent();
+		const VkExtent2D swapChainExtent = renderer.getSwapChainExtent();
+		const glm::vec2 renderScale = glm::vec2(renderExtent.width, renderExtent.height) / glm::vec2(swapChainExtent.width, swapChainExtent.height);
+		const glm::ivec2 position = glm::clamp(glm::ivec2(slots[frameIndex].request->position * renderScale), glm::ivec2(0), glm::ivec2(renderExtent.width, renderExtent.height) - 1);
+		renderInfo.scissorDimensions = VkRect2D{{position.x, position.y}, {1, 1}};
 
 		return renderInfo;
 	}
 
 	void MousePickingRenderSystem::render(FrameInfo& frameInfo) { // Flush changes to update on the GPU side.
+		ASPEN_PROFILE_SCOPE("MousePickingRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, 2, std::array<VkDescriptorSet, 2>{frameInfo.descriptorSet[0], descriptorSet}.data(), 0, nullptr);
 
-		auto group = frameInfo.scene->getRenderComponents();
-		for (auto& entity : group) {
-			auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
+		// Entity ids come from the instance buffer, so the whole scene is drawn like the other passes.
+		pipeline.bindDescriptorSets(frameInfo.commandBuffer, GlobalRenderSystem::INSTANCE_SET, {frameInfo.drawList.getInstanceDescriptorSet(frameInfo.descriptorSet[1], DrawList::Instances::VISIBLE), slots[frameInfo.frameIndex].descriptorSet});
 
-			SimplePushConstantData push{};
-			// Projection, View, Model Transformation matrix.
-			push.modelMatrix = transform.transform();
-			push.objectId = static_cast<int64_t>(entity);
+		frameInfo.drawList.draw(frameInfo.commandBuffer, frameInfo.bindState, frameInfo.appState.useIndirectDraw, DrawList::Instances::VISIBLE);
+	}
+
+	uint64_t MousePickingRenderSystem::requestPick(glm::vec2 position) {
+		queuedRequests.push_back({nextRequestId, position});
+		return nextRequestId++;
+	}
 
-			vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SimplePushConstantData), &push);
-			Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-			Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+	std::optional<MousePickingRenderSystem::PickResult> MousePickingRenderSystem::resolve(int frameIndex) {
+		frameCount++;
+
+		auto& slot = slots[frameIndex];
+		if (!slot.request) {
+			return std::nullopt;
 		}
+
+		// The frame's fence has signaled, so the fragment shader's write is done and only needs to be made visible.
+		MousePickingStorageBuffer ssbo{};
+		slot.storageBuffer->invalidate();
+		slot.storageBuffer->readFromBuffer(&ssbo);
+
+		PickResult result{slot.request->id, ssbo.objectId, frameCount - slot.recordedFrame};
+		slot.request.reset();
+		return result;
+	}
+
+	void MousePickingRenderSystem::beginPick(int frameIndex) {
+		assert(!queuedRequests.empty() && "Cannot begin a pick without a queued request!");
+
+		auto& slot = slots[frameIndex];
+		assert(!slot.request && "The frame's readback slot has not been resolved!");
+		slot.request = queuedRequests.front();
+		slot.recordedFrame = frameCount;
+		queuedRequests.pop_front();
+
+		// Reset the SSBO, the pass only writes to it if something covers the pixel.
+		MousePickingStorageBuffer ssbo{};
+		ssbo.objectId = -1;
+		slot.storageBuffer->writeToBuffer(&ssbo); // Write data to the SSBO.
+		slot.storageBuffer->flush();              // Make buffer data visible to device.
 	}
 
+	void MousePickingRenderSystem::requeueUnusedSlots(int framesInFlight) {
+		for (size_t i = static_cast<size_t>(framesInFlight); i < slots.size(); ++i) {
+			auto& slot = slots[i];
+			if (slot.request) {
+				queuedRequests.push_back(*slot.request);
+				slot.request.reset();
+			}
+		}
+		// Request ids grow, so this keeps the queue oldest first.
+		std::sort(queuedRequests.begin(), queuedRequests.end(), [](const PickRequest& a, const PickRequest& b) { return a.id < b.id; });
+	}
+
+	// The depth pre-pass loads the recreated depth buffer first, the render pass stays.
 	void MousePickingRenderSystem::onResize() {
-		resources->clearFramebuffer();
-		loadAttachment();
+		const VkExtent2D targetExtent = renderer.getTargetExtent();
+		resources->recreateFramebuffer(targetExtent.width, targetExtent.height, {resourcesDepthPrePass.lock()->attachments[0].view});
 
 		// for (int i = 0; i < offscreenDescriptorSets.size(); ++i) {
 		// 	auto bufferInfo = uboBuffers[i]->descriptorInfo();
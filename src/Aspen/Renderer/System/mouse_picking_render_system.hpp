@@ -2,12 +2,22 @@
 #include "Aspen/Renderer/System/global_render_system.hpp"
 
 namespace Aspen {
+	// Finds the entity under the cursor by drawing the scene's ids into a one pixel scissor, depth tested against the depth
+	// pre-pass. Picks never stall the render loop: a request is queued with an id, recorded into the readback slot of the
+	// frame index that renders it and resolved once that frame index comes around again, after its fence has signaled.
 	class MousePickingRenderSystem {
 	public:
 		struct MousePickingStorageBuffer {
 			alignas(16) int64_t objectId;
 		};
 
+		// A resolved pick, objectId is -1 if nothing was under the cursor.
+		struct PickResult {
+			uint64_t requestId;
+			int64_t objectId;
+			uint64_t latency; // Frames between recording the pick and reading it back.
+		};
+
 		MousePickingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, std::shared_ptr<Framebuffer> resources);
 		~MousePickingRenderSystem() = default;
 
@@ -17,27 +27,49 @@ namespace Aspen {
 		MousePickingRenderSystem(MousePickingRenderSystem&&) = delete;            // Move Constructor
 		MousePickingRenderSystem& operator=(MousePickingRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo);
 		void loadAttachment();
-		RenderInfo prepareRenderInfo();
+		RenderInfo prepareRenderInfo(int frameIndex);
 		void onResize();
 
-		VkDescriptorSet getDescriptorSet() {
-			return descriptorSet;
+		// Queue a pick at a cursor position in window coordinates, returns the id its result will carry.
+		uint64_t requestPick(glm::vec2 position);
+		bool hasQueuedRequest() const {
+			return !queuedRequests.empty();
 		}
+		uint64_t getLatestRequestId() const {
+			return nextRequestId - 1;
+		}
+
+		// Read back the pick recorded the last time this frame index was rendered. Call after Renderer::beginFrame(), which
+		// has waited for that frame's fence, and before the frame records a new pick into the slot.
+		std::optional<PickResult> resolve(int frameIndex);
+		// Move the oldest queued request into the frame's readback slot, before the picking pass is recorded.
+		void beginPick(int frameIndex);
+		// Queue the picks of the slots past framesInFlight again, after Renderer::setFramesInFlight() stopped rendering them.
+		void requeueUnusedSlots(int framesInFlight);
 
 		Framebuffer& getResources() {
 			return *resources;
 		}
 
-		std::unique_ptr<Buffer>& getStorageBuffer() {
-			return storageBuffer;
-		}
-
 	private:
+		struct PickRequest {
+			uint64_t id;
+			glm::vec2 position;
+		};
+
+		// Where one frame index's pick is written to and read back from.
+		struct ReadbackSlot {
+			std::unique_ptr<Buffer> storageBuffer;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			std::optional<PickRequest> request; // The pick in flight in this slot, if any.
+			uint64_t recordedFrame = 0;
+		};
+
 		void createDescriptorSetLayout();
-		void createDescriptorSet();
-		void createPipelines();
+		void createDescriptorSets();
 		void createPipelineLayout();
 
 		Device& device;
@@ -46,10 +78,12 @@ namespace Aspen {
 		std::weak_ptr<Framebuffer> resourcesDepthPrePass;
 		Pipeline pipeline{device};
 
-		DescriptorSetLayout& globalDescriptorSetLayout;
+		std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout;
 		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout{};
-		VkDescriptorSet descriptorSet;
 
-		std::unique_ptr<Buffer> storageBuffer;
+		std::vector<ReadbackSlot> slots;
+		std::deque<PickRequest> queuedRequests;
+		uint64_t nextRequestId = 1;
+		uint64_t frameCount = 0; // Frames that have resolved their slot, for the latency of a pick.
 	};
 } // namespace Aspen
\ No newline at end of file
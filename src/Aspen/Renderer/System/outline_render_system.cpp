@@ -1,5 +1,7 @@
 #include "Aspen/Renderer/System/outline_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 	struct SimplePushConstantData {
 		glm::mat4 MVPMatrix{1.0f};
@@ -10,8 +12,7 @@ namespace Aspen {
 	    : device(device), renderer(renderer), resourcesSimpleRender(resources) {
 
 		// createResources();
-		createPipelineLayout(globalDescriptorSetLayout[0]);
-		createPipelines();
+		createPipelineLayout(globalDescriptorSetLayout);
 	}
 
 	// void OutlineRenderSystem::createResources() {
@@ -43,21 +44,17 @@ namespace Aspen {
 	void OutlineRenderSystem::createDescriptorSet() {
 		// auto bufferInfo = uboBuffer->descriptorInfo();
 		// auto depthPrePass = renderer.getDepthPrePass();
-		DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-		    // .writeBuffer(0, &bufferInfo)
-		    // .writeImage(0, &depthPrePass.descriptor)
-		    .build(descriptorSet);
+		if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+		         // .writeBuffer(0, &bufferInfo)
+		         // .writeImage(0, &depthPrePass.descriptor)
+		         .build(descriptorSet)) {
+			throw std::runtime_error("Failed to allocate outline descriptor set!");
+		}
 	}
 
-	// Create a pipeline layout.
-	void OutlineRenderSystem::createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                              // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout->getDescriptorSetLayout()};
-		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	// Create a pipeline layout. Everything this pass needs comes from push constants.
+	void OutlineRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
+		GlobalRenderSystem::createRasterPipelineLayout(pipeline, globalDescriptorSetLayout);
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -103,18 +100,19 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getSwapChainExtent()};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getRenderExtent()};
 
 		return renderInfo;
 	}
 
 	void OutlineRenderSystem::render(FrameInfo& frameInfo, entt::entity selectedEntity) {
+		ASPEN_PROFILE_SCOPE("OutlineRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
 
@@ -123,15 +121,15 @@ namespace Aspen {
 
 		SimplePushConstantData push{};
 		// Projection, View, Model Transformation matrix.
-		auto oldScale = transform.scale;
-		transform.scale *= glm::vec3(1.02f);
-		push.MVPMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView() * transform.transform();
+		// Scale a copy, other passes may be reading the transform while this one is recorded.
+		TransformComponent outlineTransform = transform;
+		outlineTransform.scale *= glm::vec3(1.02f);
+		push.MVPMatrix = frameInfo.camera.getProjection() * frameInfo.camera.getView() * outlineTransform.transform();
 		push.outlineWidth = 0.01f;
-		transform.scale = oldScale;
 
-		vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SimplePushConstantData), &push);
-		Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-		Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+		vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
+		frameInfo.bindState.bindGeometry(frameInfo.commandBuffer, mesh.geometry->vertexBuffer->getBuffer(), mesh.geometry->indexBuffer->getBuffer());
+		Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.geometry->indices.size()));
 	}
 
 	void OutlineRenderSystem::onResize() {
@@ -13,6 +13,7 @@ namespace Aspen {
 		OutlineRenderSystem(OutlineRenderSystem&&) = delete;            // Move Constructor
 		OutlineRenderSystem& operator=(OutlineRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo, entt::entity selectedEntity);
 		RenderInfo prepareRenderInfo();
 		void onResize();
@@ -24,8 +25,7 @@ namespace Aspen {
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
-		void createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout);
+		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
 
 		Device& device;
 		Renderer& renderer;
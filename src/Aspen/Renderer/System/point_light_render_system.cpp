@@ -1,5 +1,7 @@
 #include "Aspen/Renderer/System/point_light_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 	struct SimplePushConstantData {
 		glm::vec4 color{1.0f};
@@ -10,8 +12,7 @@ namespace Aspen {
 	PointLightRenderSystem::PointLightRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& descriptorSetLayout, std::shared_ptr<Framebuffer> resources)
 	    : device(device), renderer(renderer), resourcesSimpleRender(resources), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), descriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
 
-		createPipelineLayout(descriptorSetLayout[0]);
-		createPipelines();
+		createPipelineLayout(descriptorSetLayout);
 	}
 
 	// Create a Descriptor Set Layout for a Uniform Buffer Object (UBO) & Textures.
@@ -25,21 +26,17 @@ namespace Aspen {
 	void PointLightRenderSystem::createDescriptorSet() {
 		for (int i = 0; i < descriptorSets.size(); ++i) {
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-			    .writeBuffer(0, &bufferInfo)
-			    .build(descriptorSets[i]);
+			if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+			         .writeBuffer(0, &bufferInfo)
+			         .build(descriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate point light descriptor set!");
+			}
 		}
 	}
 
-	// Create a pipeline layout.
-	void PointLightRenderSystem::createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& descriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                                                             // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{descriptorSetLayout->getDescriptorSetLayout()};
-		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	// Create a pipeline layout. Only the global UBO is read, the rest comes from push constants.
+	void PointLightRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
+		GlobalRenderSystem::createRasterPipelineLayout(pipeline, globalDescriptorSetLayout);
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -81,21 +78,21 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getSwapChainExtent()};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getRenderExtent()};
 
 		return renderInfo;
 	}
 
 	void PointLightRenderSystem::render(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("PointLightRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, 1, &frameInfo.descriptorSet[0], 0, nullptr);
 
 		auto group = frameInfo.scene->getPointLights();
 		for (auto& entity : group) {
@@ -106,7 +103,7 @@ namespace Aspen {
 			push.color = glm::vec4(pointLight.color, pointLight.lightIntensity);
 			push.radius = 0.04f;
 
-			vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+			vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
 			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
 		}
 	}
@@ -13,6 +13,7 @@ namespace Aspen {
 		PointLightRenderSystem(PointLightRenderSystem&&) = delete;            // Move Constructor
 		PointLightRenderSystem& operator=(PointLightRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo);
 		RenderInfo prepareRenderInfo();
 		void onResize();
@@ -24,8 +25,7 @@ namespace Aspen {
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
-		void createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& descriptorSetLayout);
+		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
 
 		Device& device;
 		Renderer& renderer;
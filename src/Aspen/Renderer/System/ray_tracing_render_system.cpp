@@ -1,16 +1,14 @@
 #include "Aspen/Renderer/System/ray_tracing_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
-	RayTracingRenderSystem::RayTracingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, std::shared_ptr<Framebuffer> resourcesDepthPrePass)
-	    : device(device), deviceProcedures(device.deviceProcedures()), renderer(renderer), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resourcesDepthPrePass), globalDescriptorSetLayouts(globalDescriptorSetLayouts), textureDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+	RayTracingRenderSystem::RayTracingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, RenderGraph& renderGraph, RenderGraph::ResourceHandle outputImage, RenderGraph::ResourceHandle colorImage, std::shared_ptr<Framebuffer> resourcesDepthPrePass)
+	    : device(device), deviceProcedures(device.deviceProcedures()), renderer(renderer), renderGraph(renderGraph), outputImage(outputImage), colorImage(colorImage), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resourcesDepthPrePass), globalDescriptorSetLayouts(globalDescriptorSetLayouts), textureDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
 		createResources();
 	}
 
 	RayTracingRenderSystem::~RayTracingRenderSystem() {
-		vkDestroyImageView(device.device(), storage_image.view, nullptr);
-		vkDestroyImage(device.device(), storage_image.image, nullptr);
-		vkFreeMemory(device.device(), storage_image.memory, nullptr);
-
 		rtSBTBuffer.reset();
 
 		for (auto& blas : m_BLAS) {
@@ -22,70 +20,26 @@ namespace Aspen {
 		deviceProcedures.vkDestroyAccelerationStructureKHR(device.device(), m_TLAS.handle, nullptr);
 	}
 
+	// The storage image and the color attachment belong to the render graph, which also transitions them between the passes.
 	void RayTracingRenderSystem::createResources() {
-
-		storage_image.width = renderer.getSwapChainExtent().width;
-		storage_image.height = renderer.getSwapChainExtent().height;
-		storage_image.format = renderer.getSwapChainImageFormat(); // TODO: This Image needs to be copied to a SRGB image before displaying.
-
-		VkImageCreateInfo imageInfo{};
-		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
-		imageInfo.format = storage_image.format;
-		imageInfo.extent.width = storage_image.width;
-		imageInfo.extent.height = storage_image.height;
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
-		imageInfo.arrayLayers = 1;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		// VK_IMAGE_USAGE_TRANSFER_SRC_BIT - So image is used as a source of a copy function.
-		// VK_IMAGE_USAGE_STORAGE_BIT - So the shaders can read and write to the image.
-		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, storage_image.image, storage_image.memory);
-
-		VkImageViewCreateInfo viewCreateInfo{};
-		viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewCreateInfo.format = VK_FORMAT_B8G8R8A8_UNORM;
-		viewCreateInfo.subresourceRange = {};
-		viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		viewCreateInfo.subresourceRange.baseMipLevel = 0;
-		viewCreateInfo.subresourceRange.levelCount = 1;
-		viewCreateInfo.subresourceRange.baseArrayLayer = 0;
-		viewCreateInfo.subresourceRange.layerCount = 1;
-		viewCreateInfo.image = storage_image.image;
-		VK_CHECK(vkCreateImageView(device.device(), &viewCreateInfo, nullptr, &storage_image.view));
-
-		VkCommandBuffer commandBuffer = device.beginSingleTimeCommandBuffers();
-
-		VulkanTools::setImageLayout(
-		    commandBuffer,
-		    storage_image.image,
-		    VK_IMAGE_LAYOUT_UNDEFINED,
-		    VK_IMAGE_LAYOUT_GENERAL,
-		    viewCreateInfo.subresourceRange);
-
-		device.endSingleTimeCommandBuffers(commandBuffer);
-
 		// Color Attachment
 		{
-			AttachmentCreateInfo attachmentCreateInfo{};
-			attachmentCreateInfo.format = renderer.getSwapChainImageFormat();
-			attachmentCreateInfo.width = renderer.getSwapChainExtent().width;
-			attachmentCreateInfo.height = renderer.getSwapChainExtent().height;
-			attachmentCreateInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
-			attachmentCreateInfo.layerCount = 1;
-			attachmentCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			attachmentCreateInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-			attachmentCreateInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attachmentCreateInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attachmentCreateInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attachmentCreateInfo.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			resources->createAttachment(attachmentCreateInfo);
+			const RenderGraph::Image& color = renderGraph.getImage(colorImage);
+
+			AttachmentAddInfo attachmentAddInfo{};
+			attachmentAddInfo.format = color.format;
+			attachmentAddInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
+			attachmentAddInfo.view = color.view;
+			attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachmentAddInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			attachmentAddInfo.layerCount = 1;
+			attachmentAddInfo.width = color.extent.width;
+			attachmentAddInfo.height = color.extent.height;
+			attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachmentAddInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			resources->addLoadAttachment(attachmentAddInfo);
 		}
 
 		// Depth Attachment
@@ -99,8 +53,8 @@ namespace Aspen {
 			attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 			attachmentAddInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 			attachmentAddInfo.layerCount = 1;
-			attachmentAddInfo.width = renderer.getSwapChainExtent().width;
-			attachmentAddInfo.height = renderer.getSwapChainExtent().height;
+			attachmentAddInfo.width = renderer.getTargetExtent().width;
+			attachmentAddInfo.height = renderer.getTargetExtent().height;
 			attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 			attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 			attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
@@ -114,16 +68,12 @@ namespace Aspen {
 	}
 
 	void RayTracingRenderSystem::updateResources() {
-		// Recreate the storage image.
-		vkDestroyImageView(device.device(), storage_image.view, nullptr);
-		vkDestroyImage(device.device(), storage_image.image, nullptr);
-		vkFreeMemory(device.device(), storage_image.memory, nullptr);
-
-		createResources();
+		const RenderGraph::Image& color = renderGraph.getImage(colorImage);
+		resources->recreateFramebuffer(color.extent.width, color.extent.height, {color.view, resourcesDepthPrePass.lock()->attachments[0].view});
 
 		// Update the descriptor set binding.
 		VkDescriptorImageInfo image_descriptor{};
-		image_descriptor.imageView = storage_image.view;
+		image_descriptor.imageView = renderGraph.getImage(outputImage).view;
 		image_descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		DescriptorWriter(*rtDescriptorSetLayout, device.getDescriptorPool())
@@ -132,33 +82,10 @@ namespace Aspen {
 	}
 
 	/*
-	    Copy ray tracing output to offscreen image
+	    Copy ray tracing output to offscreen image.
+	    The render graph has the output in TRANSFER_SRC_OPTIMAL and the destination in TRANSFER_DST_OPTIMAL.
 	*/
-	void RayTracingRenderSystem::copyToImage(VkCommandBuffer cmdBuffer, VkImage dstImage, VkImageLayout initialLayout, uint32_t width, uint32_t height) {
-		// Wait for destination image to finish transitioning.
-		VulkanTools::setImageLayout(
-		    cmdBuffer,
-		    dstImage,
-		    VK_IMAGE_LAYOUT_UNDEFINED,
-		    initialLayout,
-		    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-		// Prepare destination image as transfer destination
-		VulkanTools::setImageLayout(
-		    cmdBuffer,
-		    dstImage,
-		    initialLayout,
-		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-		// Prepare ray tracing output image as transfer source
-		VulkanTools::setImageLayout(
-		    cmdBuffer,
-		    storage_image.image,
-		    VK_IMAGE_LAYOUT_GENERAL,
-		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
+	void RayTracingRenderSystem::copyToImage(VkCommandBuffer cmdBuffer, VkImage dstImage, uint32_t width, uint32_t height) {
 		VkImageCopy copy_region{};
 		copy_region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
 		copy_region.srcOffset = {0, 0, 0};
@@ -166,31 +93,14 @@ namespace Aspen {
 		copy_region.dstOffset = {0, 0, 0};
 		copy_region.extent = {width, height, 1};
 		vkCmdCopyImage(cmdBuffer,
-		               storage_image.image,
+		               renderGraph.getImage(outputImage).image,
 		               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 		               dstImage,
 		               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		               1,
 		               &copy_region);
-
-		// Transition destination image back to original layout
-		VulkanTools::setImageLayout(
-		    cmdBuffer,
-		    dstImage,
-		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		    initialLayout,
-		    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-		// Transition ray tracing output image back to general layout
-		VulkanTools::setImageLayout(
-		    cmdBuffer,
-		    storage_image.image,
-		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		    VK_IMAGE_LAYOUT_GENERAL,
-		    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
 	}
 
-	// Created the Bottom and Top Level Acceleration Structures needed for ray tracing.
 	void RayTracingRenderSystem::createAccelerationStructures(std::shared_ptr<Scene>& scene) {
 		createBLAS(scene);
 		createTLAS(scene);
@@ -207,19 +117,14 @@ namespace Aspen {
 	// Creates the Bottom Level Acceleration Structures.
 	// Adapted From: https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
 	void RayTracingRenderSystem::createBLAS(std::shared_ptr<Scene>& scene) {
-		// BLAS - Storing each primitive in a geometry
+		// BLAS - Storing each primitive in a geometry. One BLAS per unique geometry, instances share them through the TLAS.
 		std::vector<BLASInput> BLASinputs;
 
-		uint32_t vertexOffset = 0;
-		uint32_t indexOffset = 0;
-
-		auto group = scene->getRenderComponents();
-		for (const auto& entity : group) {
-			auto& mesh = group.get<MeshComponent>(entity);
-			BLASinputs.push_back(objectToGeometry(scene, vertexOffset, indexOffset, mesh));
-
-			vertexOffset += static_cast<uint32_t>(mesh.vertices.size()) * sizeof(MeshComponent::Vertex);
-			indexOffset += static_cast<uint32_t>(mesh.indices.size()) * sizeof(uint32_t);
+		const SceneData& sceneData = scene->getSceneData();
+		for (size_t i = 0; i < sceneData.geometries.size(); ++i) {
+			uint32_t indexOffset = sceneData.geometryOffsets[i].x * sizeof(uint32_t);
+			uint32_t vertexOffset = sceneData.geometryOffsets[i].y * sizeof(MeshComponent::Vertex);
+			BLASinputs.push_back(objectToGeometry(scene, vertexOffset, indexOffset, *sceneData.geometries[i]));
 		}
 
 		uint32_t nbBlas = static_cast<uint32_t>(BLASinputs.size());
@@ -291,8 +196,11 @@ namespace Aspen {
 			// Over the limit or last BLAS element
 			if (batchSize >= batchLimit || idx == nbBlas - 1) {
 				VkCommandBuffer cmdBuffer = device.beginSingleTimeCommandBuffers();
+				renderer.getProfiler().beginImmediate(cmdBuffer);
 				cmdCreateBLAS(cmdBuffer, indices, buildAS, scratchAddress, queryPool);
+				renderer.getProfiler().endImmediate(cmdBuffer);
 				device.endSingleTimeCommandBuffers(cmdBuffer);
+				renderer.getProfiler().resolveImmediate("BLAS Build");
 
 				if (queryPool) {
 					VkCommandBuffer cmdBuffer = device.beginSingleTimeCommandBuffers();
@@ -323,7 +231,7 @@ namespace Aspen {
 	}
 
 	// Adapted From: https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
-	BLASInput RayTracingRenderSystem::objectToGeometry(std::shared_ptr<Scene>& scene, uint32_t vertexOffset, uint32_t indexOffset, MeshComponent& model) {
+	BLASInput RayTracingRenderSystem::objectToGeometry(std::shared_ptr<Scene>& scene, uint32_t vertexOffset, uint32_t indexOffset, MeshComponent::Geometry& model) {
 		// BLAS builder requires raw device addresses.
 		VkDeviceOrHostAddressConstKHR vertexAddress;
 		VkDeviceOrHostAddressConstKHR indexAddress;
@@ -477,6 +385,7 @@ namespace Aspen {
 	// Adapted From: https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
 	void RayTracingRenderSystem::createTLAS(std::shared_ptr<Scene>& scene) {
 		int index = 0;
+		const auto& instanceGeometryIndices = scene->getSceneData().instanceGeometryIndices;
 		auto group = scene->getRenderComponents();
 		for (const auto& entity : group) {
 			auto& transform = group.get<TransformComponent>(entity);
@@ -484,7 +393,7 @@ namespace Aspen {
 			VkAccelerationStructureInstanceKHR rayInst{};
 			rayInst.transform = VulkanTools::glmToTransformMatrixKHR(transform.transform()); // Position of the instance
 			rayInst.instanceCustomIndex = index;                                             // gl_InstanceCustomIndexEXT. Used for instancing.
-			rayInst.accelerationStructureReference = m_BLAS[index++].device_address;
+			rayInst.accelerationStructureReference = m_BLAS[instanceGeometryIndices[index++]].device_address;
 			rayInst.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
 			rayInst.mask = 0xFF;                                //  Only be hit if rayMask & instance.mask != 0
 			rayInst.instanceShaderBindingTableRecordOffset = 0; // We will use the same hit group for all objects
@@ -495,6 +404,7 @@ namespace Aspen {
 
 	// Updates the Top Level Acceleration Structure.
 	void RayTracingRenderSystem::updateTLAS(std::shared_ptr<Scene>& scene) {
+		ASPEN_PROFILE_SCOPE("RayTracingRenderSystem::updateTLAS");
 		bool updateRequired = false;
 		int index = 0;
 		auto group = scene->getRenderComponents();
@@ -507,7 +417,7 @@ namespace Aspen {
 			}
 			updateRequired = true;
 
-			m_TLASInstances[index].transform = VulkanTools::glmToTransformMatrixKHR(transform.transform()); // Position of the instance
+			m_TLASInstances[index++].transform = VulkanTools::glmToTransformMatrixKHR(transform.transform()); // Position of the instance
 			transform.isTransformUpdated = false;
 		}
 
@@ -523,6 +433,7 @@ namespace Aspen {
 
 		// Command buffer to create the TLAS
 		VkCommandBuffer cmdBuffer = device.beginSingleTimeCommandBuffers();
+		renderer.getProfiler().beginImmediate(cmdBuffer);
 
 		// Create a buffer holding the actual instance data (matrices++) for use by the AS builder
 		// Buffer of instances containing the matrices and BLAS ids
@@ -541,11 +452,12 @@ namespace Aspen {
 		VkDeviceAddress instanceBufferAddress = device.getBufferDeviceAddress(instancesBuffer->getBuffer());
 
 		// Make sure the copy of the instances buffer are copied before triggering the acceleration structure build
+		// An update rewrites the TLAS in place, so it also waits for the frames still in flight to stop tracing against it.
 		VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
 		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
 		vkCmdPipelineBarrier(cmdBuffer,
-		                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                     update ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
 		                     0,
 		                     1,
 		                     &barrier,
@@ -618,7 +530,9 @@ namespace Aspen {
 		// Build the TLAS
 		deviceProcedures.vkCmdBuildAccelerationStructuresKHR(cmdBuffer, 1, &buildInfo, &pBuildOffsetInfo);
 
+		renderer.getProfiler().endImmediate(cmdBuffer);
 		device.endSingleTimeCommandBuffers(cmdBuffer);
+		renderer.getProfiler().resolveImmediate(update ? "TLAS Update" : "TLAS Build");
 	}
 
 	/*
@@ -723,9 +637,11 @@ namespace Aspen {
 		}
 
 		for (int i = 0; i < textureDescriptorSets.size(); ++i) {
-			DescriptorWriter(*textureDescriptorSetLayout, device.getDescriptorPool())
-			    .writeImage(0, descriptorImageInfos.data(), scene.getSceneData().textureCount)
-			    .build(textureDescriptorSets[i]);
+			if (!DescriptorWriter(*textureDescriptorSetLayout, device.getDescriptorPool())
+			         .writeImage(0, descriptorImageInfos.data(), scene.getSceneData().textureCount)
+			         .build(textureDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate ray tracing texture descriptor set!");
+			}
 		}
 	}
 
@@ -754,7 +670,7 @@ namespace Aspen {
 		ASInfo.pNext = VK_NULL_HANDLE;
 
 		VkDescriptorImageInfo image_descriptor{};
-		image_descriptor.imageView = storage_image.view;
+		image_descriptor.imageView = renderGraph.getImage(outputImage).view;
 		image_descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 		auto vertexBufferInfo = scene->getSceneData().vertexBuffer->descriptorInfo();
@@ -762,14 +678,16 @@ namespace Aspen {
 		auto offsetBufferInfo = scene->getSceneData().offsetBuffer->descriptorInfo();
 		auto materialBufferInfo = scene->getSceneData().materialBuffer->descriptorInfo();
 
-		DescriptorWriter(*rtDescriptorSetLayout, device.getDescriptorPool())
-		    .writeAccelerationStructure(0, &ASInfo)
-		    .writeImage(1, &image_descriptor)
-		    .writeBuffer(2, &vertexBufferInfo)
-		    .writeBuffer(3, &indexBufferInfo)
-		    .writeBuffer(4, &offsetBufferInfo)
-		    .writeBuffer(5, &materialBufferInfo)
-		    .build(rtDescriptorSet);
+		if (!DescriptorWriter(*rtDescriptorSetLayout, device.getDescriptorPool())
+		         .writeAccelerationStructure(0, &ASInfo)
+		         .writeImage(1, &image_descriptor)
+		         .writeBuffer(2, &vertexBufferInfo)
+		         .writeBuffer(3, &indexBufferInfo)
+		         .writeBuffer(4, &offsetBufferInfo)
+		         .writeBuffer(5, &materialBufferInfo)
+		         .build(rtDescriptorSet)) {
+			throw std::runtime_error("Failed to allocate ray tracing descriptor set!");
+		}
 	}
 
 	// Create a pipeline layout.
@@ -870,32 +788,27 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getSwapChainExtent()};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getRenderExtent()};
 
 		return renderInfo;
 	}
 
 	void RayTracingRenderSystem::render(FrameInfo& frameInfo) { // Flush changes to update on the GPU side.
+		ASPEN_PROFILE_SCOPE("RayTracingRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
 
-		std::vector<VkDescriptorSet> descriptorSetsCombined{frameInfo.descriptorSet[0], rtDescriptorSet, textureDescriptorSets[frameInfo.frameIndex]};
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, pipeline.getPipelineLayout(), 0, 3, descriptorSetsCombined.data(), 0, nullptr);
+		pipeline.bindDescriptorSets(frameInfo.commandBuffer, 0, {frameInfo.descriptorSet[0], rtDescriptorSet, textureDescriptorSets[frameInfo.frameIndex]});
 
+		// The closest hit shader lights the hits with every point light in the global UBO.
 		PushConstantRay push{};
-
-		auto pointLightGroup = frameInfo.scene->getPointLights();
-		auto [pointLightProps, pointLightTransform] = pointLightGroup.get<PointLightComponent, TransformComponent>(pointLightGroup[0]);
-
 		push.clearColor = glm::vec4{0.02f, 0.02f, 0.02f, 1.0f};
-		push.lightPosition = pointLightTransform.translation;
-		push.lightIntensity = pointLightProps.lightIntensity;
 		push.textureMapping = frameInfo.appState.useTextureMapping;
 		push.shadows = frameInfo.appState.useShadows;
 		push.shadowBias = frameInfo.appState.rtShadowBias;
@@ -908,14 +821,16 @@ namespace Aspen {
 		vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR, 0, sizeof(PushConstantRay), &push);
 
 		// Trace Rays
-		deviceProcedures.vkCmdTraceRaysKHR(frameInfo.commandBuffer, &rgenRegion, &missRegion, &hitRegion, &callRegion, renderer.getSwapChainExtent().width, renderer.getSwapChainExtent().height, 1);
+		deviceProcedures.vkCmdTraceRaysKHR(frameInfo.commandBuffer, &rgenRegion, &missRegion, &hitRegion, &callRegion, renderer.getRenderExtent().width, renderer.getRenderExtent().height, 1);
+	}
 
-		// Copy ray traced output to render pass's attachment.
-		copyToImage(frameInfo.commandBuffer, resources->attachments[0].image, resources->attachments[0].description.finalLayout, resources->width, resources->height);
+	// Copy ray traced output to render pass's attachment. Only the render extent was traced.
+	void RayTracingRenderSystem::resolve(VkCommandBuffer commandBuffer) {
+		copyToImage(commandBuffer, renderGraph.getImage(colorImage).image, renderer.getRenderExtent().width, renderer.getRenderExtent().height);
 	}
 
+	// The render graph recreated the images, the render pass and sampler stay.
 	void RayTracingRenderSystem::onResize() {
-		resources->clearFramebuffer();
 		updateResources();
 	}
 } // namespace Aspen
\ No newline at end of file
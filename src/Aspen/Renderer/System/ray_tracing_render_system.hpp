@@ -1,16 +1,8 @@
 #pragma once
 #include "Aspen/Renderer/System/global_render_system.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
 
 namespace Aspen {
-	struct StorageImage {
-		VkDeviceMemory memory;
-		VkImage image = VK_NULL_HANDLE;
-		VkImageView view;
-		VkFormat format;
-		uint32_t width;
-		uint32_t height;
-	};
-
 	struct BLASInput {
 		std::vector<VkAccelerationStructureGeometryKHR> ASGeometry;
 		std::vector<VkAccelerationStructureBuildRangeInfoKHR> ASBuildOffsetInfo;
@@ -35,8 +27,6 @@ namespace Aspen {
 	// Push constant structure for the ray tracer
 	struct PushConstantRay {
 		glm::vec4 clearColor{};
-		glm::vec3 lightPosition{};
-		float lightIntensity;
 		int textureMapping;
 		int shadows;
 		float shadowBias;
@@ -49,7 +39,7 @@ namespace Aspen {
 
 	class RayTracingRenderSystem {
 	public:
-		RayTracingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, std::shared_ptr<Framebuffer> resourcesDepthPrePass);
+		RayTracingRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayouts, RenderGraph& renderGraph, RenderGraph::ResourceHandle outputImage, RenderGraph::ResourceHandle colorImage, std::shared_ptr<Framebuffer> resourcesDepthPrePass);
 		~RayTracingRenderSystem();
 
 		RayTracingRenderSystem(const RayTracingRenderSystem&) = delete;
@@ -58,11 +48,13 @@ namespace Aspen {
 		RayTracingRenderSystem(RayTracingRenderSystem&&) = delete;            // Move Constructor
 		RayTracingRenderSystem& operator=(RayTracingRenderSystem&&) = delete; // Move Assignment Operator
 
+		// Traces the scene into the storage image, which resolve() then copies into the color attachment for the overlays.
 		void render(FrameInfo& frameInfo);
+		void resolve(VkCommandBuffer commandBuffer);
 		void createResources();
 		void updateResources();
 		void createAccelerationStructures(std::shared_ptr<Scene>& scene);
-		void copyToImage(VkCommandBuffer cmdBuffer, VkImage dstImage, VkImageLayout initialLayout, uint32_t width, uint32_t height);
+		void copyToImage(VkCommandBuffer cmdBuffer, VkImage dstImage, uint32_t width, uint32_t height);
 		void assignTextures(Scene& scene);
 		RenderInfo prepareRenderInfo();
 		void onResize();
@@ -84,7 +76,7 @@ namespace Aspen {
 		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
 
 		void createBLAS(std::shared_ptr<Scene>& scene);
-		BLASInput objectToGeometry(std::shared_ptr<Scene>& scene, uint32_t vertexOffset, uint32_t indexOffset, MeshComponent& model);
+		BLASInput objectToGeometry(std::shared_ptr<Scene>& scene, uint32_t vertexOffset, uint32_t indexOffset, MeshComponent::Geometry& model);
 		void cmdCreateBLAS(VkCommandBuffer cmdBuffer, std::vector<uint32_t> indices, std::vector<BuildAccelerationStructure>& buildAS, VkDeviceAddress scratchAddress, VkQueryPool queryPool);
 		void cmdCompactBLAS(VkCommandBuffer cmdBuffer, std::vector<uint32_t> indices, std::vector<BuildAccelerationStructure>& buildAS, VkQueryPool queryPool);
 
@@ -97,6 +89,9 @@ namespace Aspen {
 		// Used for calling extension functions that were manually leaded in DeviceProcedures.
 		DeviceProcedures& deviceProcedures;
 		Renderer& renderer;
+		RenderGraph& renderGraph;
+		RenderGraph::ResourceHandle outputImage; // Storage image the rays are traced into.
+		RenderGraph::ResourceHandle colorImage;
 		std::shared_ptr<Framebuffer> resources;
 		std::weak_ptr<Framebuffer> resourcesDepthPrePass;
 
@@ -119,8 +114,6 @@ namespace Aspen {
 			int numLights;
 		} specializationData;
 
-		StorageImage storage_image;
-
 		// Acceleration Structures
 		std::vector<AccelerationStructure> m_BLAS;
 		AccelerationStructure m_TLAS;
@@ -1,14 +1,57 @@
 #include "Aspen/Renderer/System/shadow_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
+#include <bit>
+#include <bitset>
+
+#include "Aspen/Core/model.hpp"
+
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
 namespace Aspen {
 	struct SimplePushConstantData {
-		glm::vec4 lightPos{0.0f};
+		uint32_t shadowIndex = 0; // Light whose matrices and tiles are used, from the light UBO.
+		uint32_t face = 0;
+		uint32_t skipFlags = 0;   // GlobalRenderSystem::INSTANCE_* flags of the instances not to draw.
 	};
 
-	ShadowRenderSystem::ShadowRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout)
-	    : device(device), renderer(renderer), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), uboDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), resources(std::make_unique<Framebuffer>(device)) {
+	namespace {
+		// Direction and up vector of every cube face, in the order +X, -X, +Y, -Y, +Z, -Z.
+		const std::array<glm::vec3, ShadowRenderSystem::FACE_COUNT> FACE_DIRECTIONS{
+		    glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		    glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)};
+		const std::array<glm::vec3, ShadowRenderSystem::FACE_COUNT> FACE_UPS{
+		    glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		    glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+
+		// One of the coordinates interleaved in a Z-order (Morton) index, from its even bits.
+		uint32_t compactBits(uint32_t value) {
+			value &= 0x55555555;
+			value = (value | (value >> 1)) & 0x33333333;
+			value = (value | (value >> 2)) & 0x0f0f0f0f;
+			value = (value | (value >> 4)) & 0x00ff00ff;
+			value = (value | (value >> 8)) & 0x0000ffff;
+			return value;
+		}
+
+		// Spreads a coordinate over the even bits of a Z-order index, the inverse of compactBits().
+		uint32_t spreadBits(uint32_t value) {
+			value &= 0x0000ffff;
+			value = (value | (value << 8)) & 0x00ff00ff;
+			value = (value | (value << 4)) & 0x0f0f0f0f;
+			value = (value | (value << 2)) & 0x33333333;
+			value = (value | (value << 1)) & 0x55555555;
+			return value;
+		}
+
+		uint64_t tileTexels(uint32_t tileSize) {
+			return static_cast<uint64_t>(tileSize) * tileSize * ShadowRenderSystem::FACE_COUNT;
+		}
+	} // namespace
+
+	ShadowRenderSystem::ShadowRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle staticShadowMap, RenderGraph::ResourceHandle shadowMap)
+	    : device(device), renderer(renderer), renderGraph(renderGraph), staticShadowMap(staticShadowMap), shadowMap(shadowMap), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), uboDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), frameUboVersions(SwapChain::MAX_FRAMES_IN_FLIGHT, 0), resources(std::make_unique<Framebuffer>(device)) {
 		for (int i = 0; i < uboBuffers.size(); ++i) {
 			// Create a UBO buffer. This will just be one instance per frame.
 			uboBuffers[i] = std::make_unique<Buffer>(
@@ -27,27 +70,43 @@ namespace Aspen {
 		createDescriptorSetLayout();
 		createDescriptorSet();
 
-		createPipelineLayout(globalDescriptorSetLayout[1]); // We only care about the dynamic UBO for this render system.
-		createPipelines();
+		createPipelineLayout(globalDescriptorSetLayout);
 	}
 
+	// Both atlases belong to the render graph (see Application::createRenderGraph()) and keep their contents between frames.
+	// The passes draw one tile at a time through the viewport, so the tiles that did not change are never touched.
 	void ShadowRenderSystem::createResources() {
-		AttachmentCreateInfo attachmentCreateInfo{};
-		attachmentCreateInfo.format = VK_FORMAT_D32_SFLOAT;
-		attachmentCreateInfo.width = SHADOW_WIDTH;
-		attachmentCreateInfo.height = SHADOW_HEIGHT;
-		attachmentCreateInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
-		attachmentCreateInfo.layerCount = 6;
-		attachmentCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		attachmentCreateInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		attachmentCreateInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		attachmentCreateInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		attachmentCreateInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		attachmentCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-
-		resources->createAttachment(attachmentCreateInfo);
-		resources->createSampler(SHAODW_FILTER, SHAODW_FILTER, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER);
-		resources->createMultiViewRenderPass(attachmentCreateInfo.layerCount);
+		const RenderGraph::Image& cache = renderGraph.getImage(staticShadowMap);
+		const RenderGraph::Image& shadow = renderGraph.getImage(shadowMap);
+
+		AttachmentAddInfo attachmentAddInfo{};
+		attachmentAddInfo.format = shadow.format;
+		attachmentAddInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
+		attachmentAddInfo.view = shadow.view;
+		attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		attachmentAddInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		attachmentAddInfo.layerCount = 1;
+		attachmentAddInfo.width = shadow.extent.width;
+		attachmentAddInfo.height = shadow.extent.height;
+		attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachmentAddInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		// The whole atlas, as sampled by the scene.
+		resources->addLoadAttachment(attachmentAddInfo);
+		resources->createSampler(SHAODW_FILTER, SHAODW_FILTER, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
+		// Both start and end in the read only layout the scene samples the atlas in, the tiles are cleared one at a time.
+		attachmentAddInfo.view = cache.view;
+		staticFramebuffer = std::make_unique<Framebuffer>(device);
+		staticFramebuffer->addLoadAttachment(attachmentAddInfo);
+		staticFramebuffer->createRenderPass();
+
+		attachmentAddInfo.view = shadow.view;
+		dynamicFramebuffer = std::make_unique<Framebuffer>(device);
+		dynamicFramebuffer->addLoadAttachment(attachmentAddInfo);
+		dynamicFramebuffer->createRenderPass();
 	}
 
 	// Create a Descriptor Set Layout for a Uniform Buffer Object (UBO) & Textures.
@@ -62,22 +121,26 @@ namespace Aspen {
 		// Create descriptor sets for UBO.
 		for (int i = 0; i < uboDescriptorSets.size(); ++i) {
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-			    .writeBuffer(0, &bufferInfo)
-			    .build(uboDescriptorSets[i]);
+			if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+			         .writeBuffer(0, &bufferInfo)
+			         .build(uboDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate shadow uniform buffer descriptor set!");
+			}
 		}
 	}
 
-	// Create a pipeline layout.
-	void ShadowRenderSystem::createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                              // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
+	std::vector<VkDescriptorBufferInfo> ShadowRenderSystem::getUboDescriptorInfos() const {
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		for (const auto& uboBuffer : uboBuffers) {
+			bufferInfos.push_back(uboBuffer->descriptorInfo());
+		}
+		return bufferInfos;
+	}
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{descriptorSetLayout->getDescriptorSetLayout(), globalDescriptorSetLayout->getDescriptorSetLayout()};
-		// shadowMappingPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
-		omniShadowMappingPipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	// Create a pipeline layout. The light UBO follows the shared sets, this pass only reads the instance buffer from them.
+	void ShadowRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
+		static_assert(sizeof(SimplePushConstantData) <= GlobalRenderSystem::PUSH_CONSTANT_SIZE);
+		GlobalRenderSystem::createRasterPipelineLayout(omniShadowMappingPipeline, globalDescriptorSetLayout, {descriptorSetLayout->getDescriptorSetLayout()});
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -85,9 +148,10 @@ namespace Aspen {
 		// assert(shadowMappingPipeline.getPipelineLayout() != nullptr && "Cannot create depth pipeline before pipeline layout!");
 		assert(omniShadowMappingPipeline.getPipelineLayout() != nullptr && "Cannot create stencil pipeline before pipeline layout!");
 
+		// The render passes of both atlases are compatible, the pipeline is used with either.
 		PipelineConfigInfo pipelineConfig{};
 		Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = resources->renderPass;
+		pipelineConfig.renderPass = staticFramebuffer->renderPass;
 		pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 		// pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 		// pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_FRONT_BIT;
@@ -103,10 +167,11 @@ namespace Aspen {
 		omniShadowMappingPipeline.createGraphicsPipeline(pipelineConfig, omniShadowMappingPipeline.getPipeline());
 	}
 
-	RenderInfo ShadowRenderSystem::prepareRenderInfo() {
+	// The render pass covers the whole atlas, setTile() narrows it down to a tile.
+	RenderInfo ShadowRenderSystem::prepareRenderInfo(const Framebuffer& atlas) const {
 		RenderInfo renderInfo{};
-		renderInfo.renderPass = resources->renderPass;
-		renderInfo.framebuffer = resources->framebuffer;
+		renderInfo.renderPass = atlas.renderPass;
+		renderInfo.framebuffer = atlas.framebuffer;
 
 		std::vector<VkClearValue> clearValues{1};
 		// clearValues[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
@@ -116,99 +181,449 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = SHADOW_WIDTH;
-		viewport.height = SHADOW_HEIGHT;
+		viewport.width = ATLAS_SIZE;
+		viewport.height = ATLAS_SIZE;
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, {SHADOW_WIDTH, SHADOW_HEIGHT}};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, {ATLAS_SIZE, ATLAS_SIZE}};
 
 		return renderInfo;
 	}
 
+	// Points the viewport and the scissor at one of the light's tiles, which is returned.
+	VkRect2D ShadowRenderSystem::setTile(VkCommandBuffer commandBuffer, const ShadowedLight& light, uint32_t face) const {
+		const VkRect2D tile{{static_cast<int32_t>(light.tiles[face].x), static_cast<int32_t>(light.tiles[face].y)}, {light.tileSize, light.tileSize}};
+
+		VkViewport viewport{};
+		viewport.x = static_cast<float>(tile.offset.x);
+		viewport.y = static_cast<float>(tile.offset.y);
+		viewport.width = static_cast<float>(light.tileSize);
+		viewport.height = static_cast<float>(light.tileSize);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &tile);
+
+		return tile;
+	}
+
 	void ShadowRenderSystem::updateUBOs(FrameInfo& frameInfo) {
-		ShadowUbo shadowUbo{};
-
-		// Invert X and half Z.
-		const glm::mat4 clip(-1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 1.0f);
-
-		shadowUbo.projectionMatrix = clip * glm::perspective(static_cast<float>(glm::pi<float>() / 2.0f), 1.0f, 0.01f, 25.0f);
-
-		for (int i = 0; i < 6; ++i) {
-			glm::mat4 viewMatrix = glm::mat4(1.0f);
-			// glm::mat4 viewMatrix = glm::translate(glm::mat4(1.0f), glm::vec3{0.0f, -1.0f, 2.5f});
-			// glm::vec3 lightPos = glm::vec3{0.0f, -1.0f, 2.5f};
-			auto pointLightGroup = frameInfo.scene->getPointLights();
-			auto& pointLightTransform = pointLightGroup.get<TransformComponent>(pointLightGroup[0]);
-			glm::vec3 lightPos = pointLightTransform.translation;
-
-			switch (i) {
-				case 0: // POSITIVE_X
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 1: // NEGATIVE_X
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 2: // POSITIVE_Y
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 3: // NEGATIVE_Y
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 4: // POSITIVE_Z
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 5: // NEGATIVE_Z
-					viewMatrix = glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					// viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-					break;
-			}
-			shadowUbo.viewMatries[i] = viewMatrix;
-			// shadowUbo.viewMatries[i] = glm::inverse(viewMatrix);
-		}
-
-		uboBuffers[frameInfo.frameIndex]->writeToBuffer(&shadowUbo); // Write info to the UBO.
-		uboBuffers[frameInfo.frameIndex]->flush();
-	}
-
-	void ShadowRenderSystem::render(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("ShadowRenderSystem::updateUBOs");
+		shadowedLights.clear();
+		dynamicCasters.clear();
+		staticFaceCount = 0;
+		compositedFaceCount = 0;
+		dynamicFaceCount = 0;
+		frameInfo.appState.shadowStaticFaces = 0;
+		frameInfo.appState.shadowCompositedFaces = 0;
+		frameInfo.appState.shadowDynamicCasters = 0;
+
+		// Frustum planes from the view projection matrix (Gribb & Hartmann), as the culling pass builds them.
+		const glm::mat4 projection = frameInfo.camera.getProjection();
+		const glm::mat4 rows = glm::transpose(projection * frameInfo.camera.getView());
+		std::array<glm::vec4, 6> frustumPlanes{rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2]};
+		for (auto& plane : frustumPlanes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		const glm::vec3 cameraPos = glm::vec3(frameInfo.camera.getInverseView()[3]);
+		const float focalLength = glm::max(glm::abs(projection[0][0]), glm::abs(projection[1][1])); // One over the tangent of half the field of view.
+
+		int culledLights = 0;
+		auto pointLightGroup = frameInfo.scene->getPointLights();
+		for (const auto& entity : pointLightGroup) {
+			auto [transform, pointLight] = pointLightGroup.get<TransformComponent, PointLightComponent>(entity);
+
+			// Past its range the light is too faint for its shadow to show.
+			const float brightness = pointLight.lightIntensity * glm::max(pointLight.color.r, glm::max(pointLight.color.g, pointLight.color.b));
+			if (brightness <= 0.0f) {
+				continue;
+			}
+			const float range = glm::min(pointLight.influenceRadius(), SHADOW_FAR);
+
+			// A light whose range is outside the frustum only lights (and shadows) what cannot be seen.
+			const glm::vec3& position = transform.translation;
+			const bool visible = std::all_of(frustumPlanes.begin(), frustumPlanes.end(), [&](const glm::vec4& plane) {
+				return glm::dot(glm::vec3(plane), position) + plane.w >= -range;
+			});
+			if (!visible) {
+				++culledLights;
+				continue;
+			}
+
+			// Fraction of the screen the light's range spans, all of it once the camera is inside it.
+			const float distance = glm::distance(cameraPos, position);
+			const float coverage = distance <= range ? 1.0f : glm::min(range * focalLength / distance, 1.0f);
+			const float wantedSize = coverage * MAX_TILE_SIZE;
+
+			ShadowedLight light{};
+			light.entity = entity;
+			light.position = position;
+			light.range = range;
+			light.importance = coverage * brightness;
+			light.tileSize = std::clamp(std::bit_ceil(static_cast<uint32_t>(glm::ceil(wantedSize))), MIN_TILE_SIZE, MAX_TILE_SIZE);
+
+			auto allocation = tileAllocations.find(entity);
+			if (allocation != tileAllocations.end()) {
+				light.importance *= IMPORTANCE_HYSTERESIS;
+				if (light.tileSize < allocation->second.tileSize && wantedSize > allocation->second.tileSize * SHRINK_THRESHOLD) {
+					light.tileSize = allocation->second.tileSize;
+				}
+			}
+			shadowedLights.push_back(light);
+		}
+
+		const uint32_t droppedLights = allocateTiles();
+		shadowedEntities.clear();
+		for (const auto& light : shadowedLights) {
+			shadowedEntities.push_back(light.entity);
+		}
+
+		// A light without a shadow may lose its tiles to another light, so it starts over when it gets one again.
+		std::erase_if(cachedLights, [&](const auto& entry) {
+			return std::none_of(shadowedLights.begin(), shadowedLights.end(), [&](const ShadowedLight& light) { return light.entity == entry.first; });
+		});
+
+		// The UBO only changes when a light moves or its tiles do.
+		{
+			ShadowUbo ubo{};
+			for (uint32_t i = 0; i < shadowedLights.size(); ++i) {
+				const ShadowedLight& light = shadowedLights[i];
+				LightShadow& lightShadow = ubo.lights[i];
+				const glm::mat4 lightProjection = glm::perspective(glm::half_pi<float>(), 1.0f, SHADOW_NEAR, light.range);
+				for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+					lightShadow.viewProjection[face] = lightProjection * glm::lookAt(light.position, light.position + FACE_DIRECTIONS[face], FACE_UPS[face]);
+					lightShadow.faceRects[face] = glm::vec4(glm::vec2(light.tiles[face]), glm::vec2(static_cast<float>(light.tileSize))) / static_cast<float>(ATLAS_SIZE);
+				}
+				lightShadow.params.x = 1.0f;
+			}
+
+			if (uboVersion == 0 || std::memcmp(&ubo, &shadowUbo, sizeof(ShadowUbo)) != 0) {
+				shadowUbo = ubo;
+				++uboVersion;
+			}
+			if (frameUboVersions[frameInfo.frameIndex] != uboVersion) {
+				uboBuffers[frameInfo.frameIndex]->writeToBuffer(&shadowUbo); // Write info to the UBO.
+				uboBuffers[frameInfo.frameIndex]->flush();
+				frameUboVersions[frameInfo.frameIndex] = uboVersion;
+			}
+		}
+
+		// A light's cache is redrawn as a whole when the light, its tiles or anything static moved.
+		transformVersion = frameInfo.scene->getTransformVersion();
+		for (auto& light : shadowedLights) {
+			auto cached = cachedLights.find(light.entity);
+			if (transformVersion != cachedTransformVersion || cached == cachedLights.end() || cached->second.position != light.position ||
+			    cached->second.range != light.range || cached->second.tileSize != light.tileSize || cached->second.tiles != light.tiles) {
+				light.staticFaces = ALL_FACES;
+			}
+		}
+
+		// Bound the animated casters the same way GlobalRenderSystem bounds the instances.
+		auto renderGroup = frameInfo.scene->getRenderComponents();
+		for (const auto& entity : frameInfo.scene->getSpinningComponents()) {
+			if (!renderGroup.contains(entity)) {
+				continue;
+			}
+			auto [transform, mesh] = renderGroup.get<TransformComponent, MeshComponent>(entity);
+
+			glm::vec4 localSphere{0.0f, 0.0f, 0.0f, std::numeric_limits<float>::max()};
+			if (!mesh.geometry->bvh.empty()) {
+				const Math::AABB& bounds = mesh.geometry->bvh.getBounds();
+				localSphere = glm::vec4(bounds.center(), 0.5f * glm::length(bounds.max - bounds.min));
+			}
+			const glm::mat4& modelMatrix = transform.transform();
+			const float maxScale = glm::max(glm::length(glm::vec3(modelMatrix[0])), glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+			const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(localSphere), 1.0f));
+
+			for (uint32_t i = 0; i < shadowedLights.size(); ++i) {
+				ShadowedLight& light = shadowedLights[i];
+				const uint32_t faces = intersectFaces(center - light.position, localSphere.w * maxScale, light.range);
+				if (faces != 0) {
+					dynamicCasters.push_back({entity, i, faces});
+					light.dynamicFaces |= faces;
+				}
+			}
+		}
+
+		// A tile is rebuilt to draw the casters in it, or to erase the ones that were in it.
+		uint64_t atlasTexels = 0;
+		for (auto& light : shadowedLights) {
+			auto cached = cachedLights.find(light.entity);
+			const uint32_t facesWithDynamicCasters = cached != cachedLights.end() ? cached->second.facesWithDynamicCasters : 0;
+			light.compositedFaces = light.staticFaces | light.dynamicFaces | facesWithDynamicCasters;
+
+			staticFaceCount += std::popcount(light.staticFaces);
+			compositedFaceCount += std::popcount(light.compositedFaces);
+			dynamicFaceCount += std::popcount(light.dynamicFaces);
+			atlasTexels += tileTexels(light.tileSize);
+		}
+
+		frameInfo.appState.shadowedLights = static_cast<int>(shadowedLights.size());
+		frameInfo.appState.shadowCulledLights = culledLights;
+		frameInfo.appState.shadowDroppedLights = static_cast<int>(droppedLights);
+		frameInfo.appState.shadowAtlasUsage = static_cast<float>(atlasTexels) / static_cast<float>(static_cast<uint64_t>(ATLAS_SIZE) * ATLAS_SIZE);
+	}
+
+	// Hands out the atlas, returning how many lights lost their shadow to the budget. The least important lights are shrunk,
+	// and then dropped, until the tiles fit TEXEL_BUDGET. Lights that keep their tile size keep their tiles, the others are
+	// placed, largest first, in the first free spot along a Z-order curve. Every size is a power of two, so a tile only ever
+	// starts on a multiple of its own size. Should the free space be too fragmented for a tile, every tile is packed again
+	// from scratch. With nothing in the way and the largest tiles first, each tile goes right after the one before it and
+	// whatever fits the budget fits the atlas.
+	uint32_t ShadowRenderSystem::allocateTiles() {
+		std::sort(shadowedLights.begin(), shadowedLights.end(), [](const ShadowedLight& a, const ShadowedLight& b) { return a.importance > b.importance; });
+
+		// The shaders have room for MAX_SHADOWED_LIGHTS shadows, the least important lights go without.
+		uint32_t droppedLights = 0;
+		if (shadowedLights.size() > MAX_SHADOWED_LIGHTS) {
+			droppedLights = static_cast<uint32_t>(shadowedLights.size()) - MAX_SHADOWED_LIGHTS;
+			shadowedLights.resize(MAX_SHADOWED_LIGHTS);
+		}
+
+		uint64_t texels = 0;
+		for (const auto& light : shadowedLights) {
+			texels += tileTexels(light.tileSize);
+		}
+		for (size_t i = shadowedLights.size(); i > 0 && texels > TEXEL_BUDGET; --i) {
+			ShadowedLight& light = shadowedLights[i - 1];
+			while (texels > TEXEL_BUDGET && light.tileSize > MIN_TILE_SIZE) {
+				texels -= tileTexels(light.tileSize) - tileTexels(light.tileSize / 2);
+				light.tileSize /= 2;
+			}
+		}
+		while (texels > TEXEL_BUDGET) {
+			texels -= tileTexels(shadowedLights.back().tileSize);
+			shadowedLights.pop_back();
+			++droppedLights;
+		}
+
+		// The atlas in cells of the smallest tile size, in Z-order. A tile covers a run of cells starting on a multiple of its length.
+		constexpr uint32_t ATLAS_CELLS = (ATLAS_SIZE / MIN_TILE_SIZE) * (ATLAS_SIZE / MIN_TILE_SIZE);
+		std::bitset<ATLAS_CELLS> usedCells;
+		auto markTiles = [&](const ShadowedLight& light) {
+			const uint32_t tileCells = (light.tileSize / MIN_TILE_SIZE) * (light.tileSize / MIN_TILE_SIZE);
+			for (const glm::uvec2& tile : light.tiles) {
+				const uint32_t firstCell = spreadBits(tile.x / MIN_TILE_SIZE) | (spreadBits(tile.y / MIN_TILE_SIZE) << 1);
+				for (uint32_t cell = firstCell; cell < firstCell + tileCells; ++cell) {
+					usedCells.set(cell);
+				}
+			}
+		};
+		auto placeTiles = [&](ShadowedLight& light) {
+			const uint32_t tileCells = (light.tileSize / MIN_TILE_SIZE) * (light.tileSize / MIN_TILE_SIZE);
+			uint32_t firstCell = 0;
+			for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+				for (;; firstCell += tileCells) {
+					if (firstCell >= ATLAS_CELLS) {
+						return false;
+					}
+
+					bool isFree = true;
+					for (uint32_t cell = firstCell; cell < firstCell + tileCells && isFree; ++cell) {
+						isFree = !usedCells.test(cell);
+					}
+					if (isFree) {
+						break;
+					}
+				}
+
+				light.tiles[face] = glm::uvec2(compactBits(firstCell), compactBits(firstCell >> 1)) * MIN_TILE_SIZE;
+				for (uint32_t cell = firstCell; cell < firstCell + tileCells; ++cell) {
+					usedCells.set(cell);
+				}
+			}
+			return true;
+		};
+		auto bySize = [](const ShadowedLight* a, const ShadowedLight* b) { return a->tileSize > b->tileSize; };
+
+		std::vector<ShadowedLight*> unplacedLights;
+		for (auto& light : shadowedLights) {
+			auto allocation = tileAllocations.find(light.entity);
+			if (allocation != tileAllocations.end() && allocation->second.tileSize == light.tileSize) {
+				light.tiles = allocation->second.tiles;
+				markTiles(light);
+			} else {
+				unplacedLights.push_back(&light);
+			}
+		}
+		std::stable_sort(unplacedLights.begin(), unplacedLights.end(), bySize);
+
+		if (!std::all_of(unplacedLights.begin(), unplacedLights.end(), [&](ShadowedLight* light) { return placeTiles(*light); })) {
+			usedCells.reset();
+			unplacedLights.clear();
+			for (auto& light : shadowedLights) {
+				unplacedLights.push_back(&light);
+			}
+			std::stable_sort(unplacedLights.begin(), unplacedLights.end(), bySize);
+			for (ShadowedLight* light : unplacedLights) {
+				placeTiles(*light);
+			}
+		}
+
+		tileAllocations.clear();
+		for (const auto& light : shadowedLights) {
+			tileAllocations[light.entity] = {light.tileSize, light.tiles};
+		}
+
+		return droppedLights;
+	}
+
+	// Faces of the cube that a sphere, relative to the light, reaches into. Every face sees the 90 degree pyramid around its
+	// axis, bounded by the planes where the axis coordinate equals one of the other two coordinates.
+	uint32_t ShadowRenderSystem::intersectFaces(const glm::vec3& center, float radius, float range) {
+		const float margin = radius * glm::root_two<float>();
+
+		uint32_t faces = 0;
+		for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+			const int axis = static_cast<int>(face / 2);
+			const float depth = face % 2 == 0 ? center[axis] : -center[axis];
+			if (depth < -radius || depth > range + radius) {
+				continue;
+			}
+
+			if (std::abs(center[(axis + 1) % 3]) - depth <= margin && std::abs(center[(axis + 2) % 3]) - depth <= margin) {
+				faces |= 1u << face;
+			}
+		}
+		return faces;
+	}
+
+	void ShadowRenderSystem::bindPipeline(FrameInfo& frameInfo) {
 		// Bind the graphics pipieline.
 		omniShadowMappingPipeline.bind(frameInfo.commandBuffer, omniShadowMappingPipeline.getPipeline());
 
-		auto pointLightGroup = frameInfo.scene->getPointLights();
-		for (const auto& pointLightEntity : pointLightGroup) {
-			auto& pointLightTransform = pointLightGroup.get<TransformComponent>(pointLightEntity);
-			int index = 0;
-			auto renderGroup = frameInfo.scene->getRenderComponents();
-			for (const auto& entity : renderGroup) {
-				uint32_t dynamicOffset = index * frameInfo.dynamicOffset;
-				std::vector<VkDescriptorSet> descriptorSetsCombined{uboDescriptorSets[frameInfo.frameIndex], frameInfo.descriptorSet[1]};
-				vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, omniShadowMappingPipeline.getPipelineLayout(), 0, 2, descriptorSetsCombined.data(), 1, &dynamicOffset);
+		// The camera frustum says nothing about what casts shadows, so this pass always draws the unculled instances.
+		omniShadowMappingPipeline.bindDescriptorSets(frameInfo.commandBuffer, GlobalRenderSystem::INSTANCE_SET, {frameInfo.descriptorSet[1], uboDescriptorSets[frameInfo.frameIndex]});
+	}
 
-				auto [transform, mesh] = renderGroup.get<TransformComponent, MeshComponent>(entity);
+	// Draws the whole scene into the cache tiles, leaving the animated instances out.
+	void ShadowRenderSystem::renderStatic(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("ShadowRenderSystem::renderStatic");
+		bindPipeline(frameInfo);
+		renderer.beginRenderPass(frameInfo.commandBuffer, prepareRenderInfo(*staticFramebuffer));
 
-				SimplePushConstantData push{};
-				push.lightPos = glm::vec4(pointLightTransform.translation, 1.0f);
-				vkCmdPushConstants(frameInfo.commandBuffer, omniShadowMappingPipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SimplePushConstantData), &push);
+		SimplePushConstantData push{};
+		push.skipFlags = GlobalRenderSystem::INSTANCE_DYNAMIC;
 
-				Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-				Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+		VkClearAttachment clearAttachment{};
+		clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clearAttachment.clearValue.depthStencil = {1.0f, 0};
 
-				++index;
+		for (uint32_t i = 0; i < shadowedLights.size(); ++i) {
+			const ShadowedLight& light = shadowedLights[i];
+			if (light.staticFaces == 0) {
+				continue;
 			}
+
+			push.shadowIndex = i;
+			for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+				if ((light.staticFaces & (1u << face)) == 0) {
+					continue;
+				}
+
+				const VkClearRect clearRect{setTile(frameInfo.commandBuffer, light, face), 0, 1};
+				vkCmdClearAttachments(frameInfo.commandBuffer, 1, &clearAttachment, 1, &clearRect);
+
+				push.face = face;
+				vkCmdPushConstants(frameInfo.commandBuffer, omniShadowMappingPipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
+				frameInfo.drawList.draw(frameInfo.commandBuffer, frameInfo.bindState, frameInfo.appState.useIndirectDraw);
+			}
+
+			CachedLight& cached = cachedLights[light.entity];
+			cached.position = light.position;
+			cached.range = light.range;
+			cached.tileSize = light.tileSize;
+			cached.tiles = light.tiles;
 		}
+		renderer.endRenderPass(frameInfo.commandBuffer);
+
+		cachedTransformVersion = transformVersion;
+		frameInfo.appState.shadowStaticFaces = static_cast<int>(staticFaceCount);
+	}
+
+	// Resets the tiles being rebuilt to the static casters alone.
+	void ShadowRenderSystem::composite(FrameInfo& frameInfo) {
+		const RenderGraph::Image& cache = renderGraph.getImage(staticShadowMap);
+		const RenderGraph::Image& shadow = renderGraph.getImage(shadowMap);
+
+		std::vector<VkImageCopy> regions;
+		for (const auto& light : shadowedLights) {
+			if (light.compositedFaces == 0) {
+				continue;
+			}
+
+			for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+				if ((light.compositedFaces & (1u << face)) == 0) {
+					continue;
+				}
+
+				VkImageCopy region{};
+				region.srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+				region.srcOffset = {static_cast<int32_t>(light.tiles[face].x), static_cast<int32_t>(light.tiles[face].y), 0};
+				region.dstSubresource = region.srcSubresource;
+				region.dstOffset = region.srcOffset;
+				region.extent = {light.tileSize, light.tileSize, 1};
+				regions.push_back(region);
+			}
+
+			// Every tile that held a caster was rebuilt, so only the ones drawn this frame hold any now.
+			cachedLights[light.entity].facesWithDynamicCasters = light.dynamicFaces;
+		}
+		vkCmdCopyImage(frameInfo.commandBuffer, cache.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, shadow.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+		frameInfo.appState.shadowCompositedFaces = static_cast<int>(compositedFaceCount);
+	}
+
+	// Draws the animated casters over the copied tiles, each into the tiles its bounds reach.
+	void ShadowRenderSystem::renderDynamic(FrameInfo& frameInfo) {
+		ASPEN_PROFILE_SCOPE("ShadowRenderSystem::renderDynamic");
+		bindPipeline(frameInfo);
+		renderer.beginRenderPass(frameInfo.commandBuffer, prepareRenderInfo(*dynamicFramebuffer));
+
+		SimplePushConstantData push{};
+
+		auto renderGroup = frameInfo.scene->getRenderComponents();
+		for (uint32_t i = 0; i < shadowedLights.size(); ++i) {
+			const ShadowedLight& light = shadowedLights[i];
+			if (light.dynamicFaces == 0) {
+				continue;
+			}
+
+			push.shadowIndex = i;
+			for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+				if ((light.dynamicFaces & (1u << face)) == 0) {
+					continue;
+				}
+
+				setTile(frameInfo.commandBuffer, light, face);
+				push.face = face;
+				vkCmdPushConstants(frameInfo.commandBuffer, omniShadowMappingPipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
+
+				for (const auto& caster : dynamicCasters) {
+					if (caster.light != i || (caster.faces & (1u << face)) == 0) {
+						continue;
+					}
+					auto& mesh = renderGroup.get<MeshComponent>(caster.entity);
+					frameInfo.bindState.bindGeometry(frameInfo.commandBuffer, mesh.geometry->vertexBuffer->getBuffer(), mesh.geometry->indexBuffer->getBuffer());
+					Aspen::Model::drawInstanced(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.geometry->indices.size()), 1, frameInfo.drawList.getInstanceSlot(caster.entity));
+				}
+			}
+		}
+		renderer.endRenderPass(frameInfo.commandBuffer);
+
+		frameInfo.appState.shadowDynamicCasters = static_cast<int>(dynamicCasters.size());
 	}
 
+	// The atlases keep their size, but the render graph recreates every image it owns when it is baked again. The render
+	// passes and the sampler stay.
 	void ShadowRenderSystem::onResize() {
-		// resources->clearFramebuffer();
-		// createResources();
+		const RenderGraph::Image& cache = renderGraph.getImage(staticShadowMap);
+		const RenderGraph::Image& shadow = renderGraph.getImage(shadowMap);
+		resources->attachments[0].view = shadow.view; // Only holds the atlas and its sampler for the scene, it has no framebuffer.
+		staticFramebuffer->recreateFramebuffer(cache.extent.width, cache.extent.height, {cache.view});
+		dynamicFramebuffer->recreateFramebuffer(shadow.extent.width, shadow.extent.height, {shadow.view});
+		cachedLights.clear();
 	}
 } // namespace Aspen
\ No newline at end of file
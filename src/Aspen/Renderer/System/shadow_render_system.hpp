@@ -1,19 +1,50 @@
 #pragma once
 #include "Aspen/Renderer/System/global_render_system.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
 
 namespace Aspen {
+	// Omni-directional shadows of the most important point lights, packed into one shadow atlas and cached from one frame to the next.
+	//
+	// Every shadowed light gets six square tiles of the atlas, one per cube face. Lights whose range does not reach into the
+	// camera frustum get no shadow. The others are given a tile size from how much of the screen their range covers and
+	// ranked by that coverage and their brightness. Only the first MAX_SHADOWED_LIGHTS keep their shadow, and the least
+	// important of those give up resolution (and then their shadow) until the atlas texels handed out fit TEXEL_BUDGET.
+	// A light keeps its tiles for as long as it keeps its shadow and tile size, only new and resized lights are placed.
+	//
+	// Static casters are rendered into a persistent cache atlas, a light's tiles are only redrawn when it moves, its tiles
+	// move or the scene's transform version changes. The sampled atlas is rebuilt one tile at a time: the tile is copied from
+	// the cache and the animated casters are drawn on top of it. Only tiles an animated caster touches, or touched when the
+	// tile was last built, are rebuilt, so a scene where nothing moves records no shadow work at all.
 	class ShadowRenderSystem {
 	public:
-		static constexpr int SHADOW_WIDTH = 1024;
-		static constexpr int SHADOW_HEIGHT = 1024;
+		static constexpr uint32_t ATLAS_SIZE = 4096;
+		static constexpr uint32_t MIN_TILE_SIZE = 128;
+		static constexpr uint32_t MAX_TILE_SIZE = 1024;
+		static constexpr uint64_t TEXEL_BUDGET = 12 * 1024 * 1024; // Atlas texels handed out per frame, the rest is room for placing tiles around the ones that stay.
 		static constexpr VkFilter SHAODW_FILTER = VK_FILTER_LINEAR;
+		static constexpr float SHADOW_NEAR = 0.01f;
+		static constexpr float SHADOW_FAR = 25.0f;            // Longest range a light's shadow reaches, short of its PointLightComponent::influenceRadius().
+		static constexpr float SHRINK_THRESHOLD = 0.4f;       // A tile only shrinks once the light needs less than this much of it, so it does not flicker between two sizes.
+		static constexpr float IMPORTANCE_HYSTERESIS = 1.25f; // A light with a shadow is ranked this much more important, so lights of about the same importance do not trade shadows.
+		static constexpr uint32_t FACE_COUNT = 6;
+		static constexpr uint32_t ALL_FACES = (1u << FACE_COUNT) - 1;
+
+		// Tiles of power of two sizes, packed in order of decreasing size, fill the atlas without gaps. So whatever tiles fit the budget fit the atlas.
+		static_assert(TEXEL_BUDGET < static_cast<uint64_t>(ATLAS_SIZE) * ATLAS_SIZE, "The budget has to leave room in the atlas.");
+		static_assert(TEXEL_BUDGET >= static_cast<uint64_t>(MAX_TILE_SIZE) * MAX_TILE_SIZE * FACE_COUNT, "The budget has to fit a light with the largest tiles.");
+
+		// Read by the shadow pass and by the scene, indexed by GlobalRenderSystem::PointLight::shadowIndex.
+		struct LightShadow {
+			glm::mat4 viewProjection[FACE_COUNT];
+			glm::vec4 faceRects[FACE_COUNT]; // Every face's tile in atlas UVs, offset (xy) and size (zw).
+			glm::vec4 params{0.0f};          // x is 1 if the light has a shadow this frame.
+		};
 
 		struct ShadowUbo {
-			glm::mat4 projectionMatrix{1.0f};
-			glm::mat4 viewMatries[6];
+			LightShadow lights[MAX_SHADOWED_LIGHTS];
 		};
 
-		ShadowRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
+		ShadowRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle staticShadowMap, RenderGraph::ResourceHandle shadowMap);
 		~ShadowRenderSystem() = default;
 
 		ShadowRenderSystem(const ShadowRenderSystem&) = delete;
@@ -22,10 +53,30 @@ namespace Aspen {
 		ShadowRenderSystem(ShadowRenderSystem&&) = delete;            // Move Constructor
 		ShadowRenderSystem& operator=(ShadowRenderSystem&&) = delete; // Move Assignment Operator
 
-		void render(FrameInfo& frameInfo);
+		void createPipelines();
+
+		// Picks the lights to shadow and their tiles, writes their matrices if they changed and works out which tiles the
+		// passes below draw this frame.
 		void updateUBOs(FrameInfo& frameInfo);
+
+		// Tiles drawn by each pass this frame. A pass without tiles can be switched off.
+		uint32_t getStaticFaceCount() const {
+			return staticFaceCount;
+		}
+		uint32_t getCompositedFaceCount() const {
+			return compositedFaceCount;
+		}
+		uint32_t getDynamicFaceCount() const {
+			return dynamicFaceCount;
+		}
+
+		// Recorded straight into the frame's command buffer, in this order. Each one only runs while its pass is live,
+		// so the cache is only considered up to date once it has actually been drawn.
+		void renderStatic(FrameInfo& frameInfo);
+		void composite(FrameInfo& frameInfo);
+		void renderDynamic(FrameInfo& frameInfo);
+
 		void createResources();
-		RenderInfo prepareRenderInfo();
 		void onResize();
 
 		std::shared_ptr<Framebuffer> getResources() {
@@ -36,15 +87,67 @@ namespace Aspen {
 			return uboDescriptorSets;
 		}
 
+		// The light UBO of every frame, for the passes sampling the atlas.
+		std::vector<VkDescriptorBufferInfo> getUboDescriptorInfos() const;
+
+		// The lights with a shadow this frame, by their index into ShadowUbo::lights.
+		const std::vector<entt::entity>& getShadowedLights() const {
+			return shadowedEntities;
+		}
+
 	private:
+		// A point light given a shadow this frame.
+		struct ShadowedLight {
+			entt::entity entity;
+			glm::vec3 position;
+			float range;
+			float importance;
+			uint32_t tileSize;
+			std::array<glm::uvec2, FACE_COUNT> tiles; // Texel offset of every face's tile.
+			uint32_t staticFaces;                     // Faces (one bit each) drawn by each pass this frame.
+			uint32_t compositedFaces;
+			uint32_t dynamicFaces;
+		};
+
+		// What a light's tiles in the cache were last drawn with.
+		struct CachedLight {
+			glm::vec3 position{0.0f};
+			float range = 0.0f;
+			uint32_t tileSize = 0;
+			std::array<glm::uvec2, FACE_COUNT> tiles{};
+			uint32_t facesWithDynamicCasters = 0; // Faces whose animated casters have to be erased when they move on.
+		};
+
+		// Where a light's tiles are in the atlas, kept while it has a shadow.
+		struct TileAllocation {
+			uint32_t tileSize = 0;
+			std::array<glm::uvec2, FACE_COUNT> tiles{};
+		};
+
+		// An animated entity, the light whose faces its bounds reach into and those faces.
+		struct DynamicCaster {
+			entt::entity entity;
+			uint32_t light; // Index into shadowedLights.
+			uint32_t faces;
+		};
+
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
-		void createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& globalDescriptorSetLayout);
+		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
+		void bindPipeline(FrameInfo& frameInfo);
+		RenderInfo prepareRenderInfo(const Framebuffer& atlas) const;
+		VkRect2D setTile(VkCommandBuffer commandBuffer, const ShadowedLight& light, uint32_t face) const;
+		uint32_t allocateTiles();
+		static uint32_t intersectFaces(const glm::vec3& center, float radius, float range);
 
 		Device& device;
 		Renderer& renderer;
-		std::shared_ptr<Framebuffer> resources;
+		RenderGraph& renderGraph;
+		RenderGraph::ResourceHandle staticShadowMap;
+		RenderGraph::ResourceHandle shadowMap;
+		std::shared_ptr<Framebuffer> resources;          // The sampled atlas and its sampler.
+		std::unique_ptr<Framebuffer> staticFramebuffer;  // Draws into the cache.
+		std::unique_ptr<Framebuffer> dynamicFramebuffer; // Draws over the tiles copied from the cache.
 		Pipeline shadowMappingPipeline{device};
 		Pipeline omniShadowMappingPipeline{device};
 
@@ -52,5 +155,26 @@ namespace Aspen {
 		std::vector<VkDescriptorSet> uboDescriptorSets;
 
 		std::vector<std::unique_ptr<Buffer>> uboBuffers;
+
+		// The UBO only changes with the lights and their tiles, every frame's UBO is written once per change.
+		ShadowUbo shadowUbo{};
+		uint64_t uboVersion = 0;
+		std::vector<uint64_t> frameUboVersions;
+
+		// The tiles of every light with a shadow, by light.
+		std::unordered_map<entt::entity, TileAllocation> tileAllocations;
+
+		// The cache, by light. A light loses its entry when it loses its shadow, as its tiles may go to another light.
+		std::unordered_map<entt::entity, CachedLight> cachedLights;
+		uint64_t cachedTransformVersion = 0;
+
+		// This frame's work.
+		uint64_t transformVersion = 0;
+		std::vector<ShadowedLight> shadowedLights; // Ordered like ShadowUbo::lights.
+		std::vector<entt::entity> shadowedEntities;
+		std::vector<DynamicCaster> dynamicCasters;
+		uint32_t staticFaceCount = 0;
+		uint32_t compositedFaceCount = 0;
+		uint32_t dynamicFaceCount = 0;
 	};
 } // namespace Aspen
\ No newline at end of file
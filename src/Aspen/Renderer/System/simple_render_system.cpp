@@ -1,16 +1,17 @@
 #include "Aspen/Renderer/System/simple_render_system.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 	struct SimplePushConstantData {
-		int imageIndex;
 		bool textureMapping;
 		int shadows;
 		float shadowBias;
-		alignas(16) float shadowOpacity;
+		float shadowOpacity;
 	};
 
-	SimpleRenderSystem::SimpleRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, std::shared_ptr<Framebuffer> resourcesDepthPrePass, std::shared_ptr<Framebuffer> resourcesShadow)
-	    : device(device), renderer(renderer), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resourcesDepthPrePass), resourcesShadow(resourcesShadow), textureDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), shadowDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+	SimpleRenderSystem::SimpleRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle colorImage, std::shared_ptr<Framebuffer> resourcesDepthPrePass, std::shared_ptr<Framebuffer> resourcesShadow, std::vector<VkDescriptorBufferInfo> shadowUboInfos)
+	    : device(device), renderer(renderer), renderGraph(renderGraph), colorImage(colorImage), resources(std::make_unique<Framebuffer>(device)), resourcesDepthPrePass(resourcesDepthPrePass), resourcesShadow(resourcesShadow), shadowUboInfos(std::move(shadowUboInfos)), textureDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT), shadowDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
 
 		createResources();
 
@@ -18,24 +19,27 @@ namespace Aspen {
 		createDescriptorSet();
 
 		createPipelineLayout(globalDescriptorSetLayout);
-		createPipelines();
 	}
 
 	void SimpleRenderSystem::createResources() {
-		// Color Attachment
+		// Color Attachment, owned by the render graph.
 		{
-			AttachmentCreateInfo attachmentCreateInfo{};
-			attachmentCreateInfo.format = renderer.getSwapChainImageFormat();
-			attachmentCreateInfo.width = renderer.getSwapChainExtent().width;
-			attachmentCreateInfo.height = renderer.getSwapChainExtent().height;
-			attachmentCreateInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
-			attachmentCreateInfo.layerCount = 1;
-			attachmentCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-			attachmentCreateInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			attachmentCreateInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attachmentCreateInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attachmentCreateInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			resources->createAttachment(attachmentCreateInfo);
+			const RenderGraph::Image& color = renderGraph.getImage(colorImage);
+
+			AttachmentAddInfo attachmentAddInfo{};
+			attachmentAddInfo.format = color.format;
+			attachmentAddInfo.imageSampleCount = VK_SAMPLE_COUNT_1_BIT;
+			attachmentAddInfo.view = color.view;
+			attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachmentAddInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			attachmentAddInfo.layerCount = 1;
+			attachmentAddInfo.width = color.extent.width;
+			attachmentAddInfo.height = color.extent.height;
+			attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachmentAddInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			resources->addLoadAttachment(attachmentAddInfo);
 		}
 
 		// Depth Attachment
@@ -63,8 +67,8 @@ namespace Aspen {
 			attachmentAddInfo.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 			attachmentAddInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 			attachmentAddInfo.layerCount = 1;
-			attachmentAddInfo.width = renderer.getSwapChainExtent().width;
-			attachmentAddInfo.height = renderer.getSwapChainExtent().height;
+			attachmentAddInfo.width = renderer.getTargetExtent().width;
+			attachmentAddInfo.height = renderer.getTargetExtent().height;
 			attachmentAddInfo.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 			attachmentAddInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 			attachmentAddInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
@@ -82,25 +86,26 @@ namespace Aspen {
 
 		std::vector<VkDescriptorImageInfo> descriptorImageInfos(scene.getSceneData().textureCount);
 
-		int index = 0;
+		// Slots are indexed by texture id so that entities which do not own a texture can still sample one by material.
 		auto group = scene.getRenderComponents();
 		for (const auto& entity : group) {
-			auto& mesh = group.get<MeshComponent>(entity);
+			auto [mesh, meshMaterial] = group.get<MeshComponent, MaterialComponent>(entity);
 
 			if (!mesh.texture.isTextureLoaded) {
 				continue;
 			}
 
-			descriptorImageInfos[index].imageLayout = mesh.texture.imageLayout;
-			descriptorImageInfos[index].imageView = mesh.texture.view;
-			descriptorImageInfos[index].sampler = mesh.texture.sampler;
-			++index;
+			descriptorImageInfos[meshMaterial.diffuseTextureId].imageLayout = mesh.texture.imageLayout;
+			descriptorImageInfos[meshMaterial.diffuseTextureId].imageView = mesh.texture.view;
+			descriptorImageInfos[meshMaterial.diffuseTextureId].sampler = mesh.texture.sampler;
 		}
 
 		for (int i = 0; i < textureDescriptorSets.size(); ++i) {
-			DescriptorWriter(*textureDescriptorSetLayout, device.getDescriptorPool())
-			    .writeImage(0, descriptorImageInfos.data(), scene.getSceneData().textureCount)
-			    .build(textureDescriptorSets[i]);
+			if (!DescriptorWriter(*textureDescriptorSetLayout, device.getDescriptorPool())
+			         .writeImage(0, descriptorImageInfos.data(), scene.getSceneData().textureCount)
+			         .build(textureDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate texture descriptor set!");
+			}
 		}
 	}
 
@@ -111,12 +116,24 @@ namespace Aspen {
 		                                 .build();
 
 		shadowDescriptorSetLayout = DescriptorSetLayout::Builder(device)
-		                                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // Binding 0: Fragment shader combined image sampler for shadows.
+		                                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // Binding 0: Fragment shader combined image sampler for the shadow atlas.
+		                                .addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)         // Binding 1: Fragment shader uniform buffer with every light's tiles.
 		                                .build();
 	}
 
 	// Create Descriptor Sets.
 	void SimpleRenderSystem::createDescriptorSet() {
+		for (int i = 0; i < shadowDescriptorSets.size(); ++i) {
+			if (!DescriptorWriter(*shadowDescriptorSetLayout, device.getDescriptorPool())
+			         .build(shadowDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate shadow atlas descriptor set!");
+			}
+		}
+		writeShadowDescriptorSets();
+	}
+
+	// Points the shadow sets at the shadow atlas, which is recreated whenever the render graph is baked, and the light UBO.
+	void SimpleRenderSystem::writeShadowDescriptorSets() {
 		std::shared_ptr<Framebuffer> tempFramebuffer = resourcesShadow.lock();
 
 		VkDescriptorImageInfo descriptorImageInfo{};
@@ -128,19 +145,15 @@ namespace Aspen {
 		for (int i = 0; i < shadowDescriptorSets.size(); ++i) {
 			DescriptorWriter(*shadowDescriptorSetLayout, device.getDescriptorPool())
 			    .writeImage(0, &descriptorImageInfo, 1)
-			    .build(shadowDescriptorSets[i]);
+			    .writeBuffer(1, &shadowUboInfos[i])
+			    .overwrite(shadowDescriptorSets[i]);
 		}
 	}
 
-	// Create a pipeline layout.
+	// Create a pipeline layout. Shadow map (per pass) then the bindless textures (per material).
 	void SimpleRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                                // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout[0]->getDescriptorSetLayout(), globalDescriptorSetLayout[1]->getDescriptorSetLayout(), shadowDescriptorSetLayout->getDescriptorSetLayout(), textureDescriptorSetLayout->getDescriptorSetLayout()};
-		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+		static_assert(sizeof(SimplePushConstantData) <= GlobalRenderSystem::PUSH_CONSTANT_SIZE);
+		GlobalRenderSystem::createRasterPipelineLayout(pipeline, globalDescriptorSetLayout, {shadowDescriptorSetLayout->getDescriptorSetLayout(), textureDescriptorSetLayout->getDescriptorSetLayout()});
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -150,11 +163,11 @@ namespace Aspen {
 		// Each shader constant of a shader stage corresponds to one map entry
 		std::array<VkSpecializationMapEntry, 1> specializationMapEntries{};
 		// Shader bindings based on specialization constants are marked by the new "constant_id" layout qualifier:
-		//	layout (constant_id = 0) const int numLights = 10;
+		//	layout (constant_id = 0) const int numShadowedLights = 10;
 
 		// Map entry for the lighting model to be used by the fragment shader
 		specializationMapEntries[0].constantID = 0;
-		specializationMapEntries[0].size = sizeof(specializationData.numLights);
+		specializationMapEntries[0].size = sizeof(specializationData.numShadowedLights);
 		specializationMapEntries[0].offset = 0;
 
 		// Prepare specialization info block for the shader stage
@@ -164,8 +177,8 @@ namespace Aspen {
 		specializationInfo.pMapEntries = specializationMapEntries.data();
 		specializationInfo.pData = &specializationData;
 
-		// Set the number of max lights.
-		specializationData.numLights = MAX_LIGHTS;
+		// Set the number of shadowed lights.
+		specializationData.numShadowedLights = MAX_SHADOWED_LIGHTS;
 
 		PipelineConfigInfo pipelineConfig{};
 		Pipeline::defaultPipelineConfigInfo(pipelineConfig);
@@ -196,55 +209,40 @@ namespace Aspen {
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.getSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.getSwapChainExtent().height);
+		viewport.width = static_cast<float>(renderer.getRenderExtent().width);
+		viewport.height = static_cast<float>(renderer.getRenderExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		renderInfo.viewport = viewport;
 
-		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getSwapChainExtent()};
+		renderInfo.scissorDimensions = VkRect2D{{0, 0}, renderer.getRenderExtent()};
 
 		return renderInfo;
 	}
 
 	void SimpleRenderSystem::render(FrameInfo& frameInfo) { // Flush changes to update on the GPU side.
+		ASPEN_PROFILE_SCOPE("SimpleRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
 
-		int index = 0;
-		int textureIndex = 0;
+		// Everything per entity comes from the instance buffer, so descriptors and push constants only need to be set once.
+		// The frame set is already bound, only the culled instances and this pass' own sets change.
+		pipeline.bindDescriptorSets(frameInfo.commandBuffer, GlobalRenderSystem::INSTANCE_SET, {frameInfo.drawList.getInstanceDescriptorSet(frameInfo.descriptorSet[1], DrawList::Instances::VISIBLE), shadowDescriptorSets[frameInfo.frameIndex], textureDescriptorSets[frameInfo.frameIndex]});
 
-		auto group = frameInfo.scene->getRenderComponents();
-		for (const auto& entity : group) {
-			uint32_t dynamicOffset = index * frameInfo.dynamicOffset;
-			std::vector<VkDescriptorSet> descriptorSetsCombined{frameInfo.descriptorSet[0], frameInfo.descriptorSet[1], shadowDescriptorSets[frameInfo.frameIndex], textureDescriptorSets[frameInfo.frameIndex]};
-			vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, 4, descriptorSetsCombined.data(), 1, &dynamicOffset);
-
-			auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
-			// transform.rotation.y = glm::mod(transform.rotation.y + 0.0001f, glm::two_pi<float>());  // Slowly rotate game objects.
-			// transform.rotation.x = glm::mod(transform.rotation.x + 0.00003f, glm::two_pi<float>()); // Slowly rotate game objects.
-
-			SimplePushConstantData push{};
-			push.textureMapping = frameInfo.appState.useTextureMapping;
-			push.shadows = frameInfo.appState.useShadows;
-			push.shadowBias = frameInfo.appState.rasterShadowBias;
-			push.shadowOpacity = frameInfo.appState.rasterShadowOpacity;
-			if (mesh.texture.isTextureLoaded) {
-				push.imageIndex = textureIndex++;
-			} else {
-				push.imageIndex = -1;
-			}
-
-			vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-			Aspen::Model::bind(frameInfo.commandBuffer, mesh.vertexBuffer, mesh.indexBuffer);
-			Aspen::Model::draw(frameInfo.commandBuffer, static_cast<uint32_t>(mesh.indices.size()));
+		SimplePushConstantData push{};
+		push.textureMapping = frameInfo.appState.useTextureMapping;
+		push.shadows = frameInfo.appState.useShadows;
+		push.shadowBias = frameInfo.appState.rasterShadowBias;
+		push.shadowOpacity = frameInfo.appState.rasterShadowOpacity;
+		vkCmdPushConstants(frameInfo.commandBuffer, pipeline.getPipelineLayout(), GlobalRenderSystem::PUSH_CONSTANT_STAGES, 0, sizeof(SimplePushConstantData), &push);
 
-			++index;
-		}
+		frameInfo.drawList.draw(frameInfo.commandBuffer, frameInfo.bindState, frameInfo.appState.useIndirectDraw, DrawList::Instances::VISIBLE, frameInfo.drawRange);
 	}
 
+	// The render graph recreated the images, the render pass and sampler stay.
 	void SimpleRenderSystem::onResize() {
-		resources->clearFramebuffer();
-		createResources();
+		const RenderGraph::Image& color = renderGraph.getImage(colorImage);
+		resources->recreateFramebuffer(color.extent.width, color.extent.height, {color.view, resourcesDepthPrePass.lock()->attachments[0].view});
+		writeShadowDescriptorSets();
 	}
 } // namespace Aspen
\ No newline at end of file
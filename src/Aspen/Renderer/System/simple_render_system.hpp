@@ -1,16 +1,17 @@
 #pragma once
 #include "Aspen/Renderer/System/global_render_system.hpp"
+#include "Aspen/Renderer/render_graph.hpp"
 
 namespace Aspen {
 	// Host data to take specialization constants from
 	struct SpecializationData {
-		// Sets the lighting model used in the fragment "uber" shader
-		int numLights;
+		// Sets the number of shadows in the fragment "uber" shader
+		int numShadowedLights;
 	};
 
 	class SimpleRenderSystem {
 	public:
-		SimpleRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, std::shared_ptr<Framebuffer> resourcesDepthPrePass, std::shared_ptr<Framebuffer> resourcesShadow);
+		SimpleRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout, RenderGraph& renderGraph, RenderGraph::ResourceHandle colorImage, std::shared_ptr<Framebuffer> resourcesDepthPrePass, std::shared_ptr<Framebuffer> resourcesShadow, std::vector<VkDescriptorBufferInfo> shadowUboInfos);
 		~SimpleRenderSystem() = default;
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
@@ -19,6 +20,7 @@ namespace Aspen {
 		SimpleRenderSystem(SimpleRenderSystem&&) = delete;            // Move Constructor
 		SimpleRenderSystem& operator=(SimpleRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo);
 		void createResources();
 		void assignTextures(Scene& scene);
@@ -36,14 +38,17 @@ namespace Aspen {
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
+		void writeShadowDescriptorSets();
 		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
 
 		Device& device;
 		Renderer& renderer;
+		RenderGraph& renderGraph;
+		RenderGraph::ResourceHandle colorImage;
 		std::shared_ptr<Framebuffer> resources;
 		std::weak_ptr<Framebuffer> resourcesDepthPrePass;
 		std::weak_ptr<Framebuffer> resourcesShadow;
+		std::vector<VkDescriptorBufferInfo> shadowUboInfos; // Every frame's light UBO, with each light's tiles of the shadow atlas.
 		Pipeline pipeline{device};
 
 		SpecializationData specializationData{};
@@ -1,16 +1,13 @@
 #include "Aspen/Renderer/System/ui_render_system.hpp"
 
-namespace Aspen {
-	struct SimplePushConstantData {
-		glm::mat4 modelMatrix{1.0f};
-		glm::mat4 normalMatrix{1.0f};
-	};
+#include "Aspen/Core/cpu_profiler.hpp"
+#include "Aspen/Renderer/System/culling_render_system.hpp"
 
+namespace Aspen {
 	UIRenderSystem::UIRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& descriptorSetLayout)
 	    : device(device), renderer(renderer), uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT), descriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT) {
 
-		createPipelineLayout(descriptorSetLayout[0]);
-		createPipelines();
+		createPipelineLayout(descriptorSetLayout);
 	}
 
 	// Create a Descriptor Set Layout for a Uniform Buffer Object (UBO) & Textures.
@@ -26,22 +23,18 @@ namespace Aspen {
 		for (int i = 0; i < descriptorSets.size(); ++i) {
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
 			// auto offscreenPass = renderer.getOffscreenPass();
-			DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
-			    .writeBuffer(0, &bufferInfo)
-			    // .writeImage(1, &offscreenPass.descriptor)
-			    .build(descriptorSets[i]);
+			if (!DescriptorWriter(*descriptorSetLayout, device.getDescriptorPool())
+			         .writeBuffer(0, &bufferInfo)
+			         // .writeImage(1, &offscreenPass.descriptor)
+			         .build(descriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate UI descriptor set!");
+			}
 		}
 	}
 
 	// Create a pipeline layout.
-	void UIRenderSystem::createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& descriptorSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT; // Which shaders will have access to this push constant range?
-		pushConstantRange.offset = 0;                                                             // To be used if you are using separate ranges for the vertex and fragment shaders.
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{descriptorSetLayout->getDescriptorSetLayout()};
-		pipeline.createPipelineLayout(descriptorSetLayouts, pushConstantRange);
+	void UIRenderSystem::createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout) {
+		GlobalRenderSystem::createRasterPipelineLayout(pipeline, globalDescriptorSetLayout);
 	}
 
 	// Create the graphics pipeline defined in aspen_pipeline.cpp
@@ -80,9 +73,9 @@ namespace Aspen {
 	}
 
 	void UIRenderSystem::render(FrameInfo& frameInfo, UIState& uiState, ApplicationState& appState) { // Flush changes to update on the GPU side.
+		ASPEN_PROFILE_SCOPE("UIRenderSystem::render");
 		// Bind the graphics pipieline.
 		pipeline.bind(frameInfo.commandBuffer, pipeline.getPipeline());
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, 1, &frameInfo.descriptorSet[0], 0, nullptr);
 
 		// Start the Dear ImGui frame
 		ImGui_ImplVulkan_NewFrame();
@@ -158,8 +151,22 @@ namespace Aspen {
 			ImVec2 scenePanelSize = ImGui::GetContentRegionAvail();
 			uiState.viewportSize = {scenePanelSize.x, scenePanelSize.y};
 
-			ImGui::Image((ImTextureID)uiState.viewportTexture,
-			             ImVec2(static_cast<float>(renderer.getSwapChainExtent().width), static_cast<float>(renderer.getSwapChainExtent().height)));
+			// The scene only covers the render extent of the offscreen target, the sampler upsamples it to the viewport. Below
+			// full resolution the texture coordinates stop half a texel short of its edges, so nothing beyond them bleeds in.
+			{
+				const VkExtent2D swapChainExtent = renderer.getSwapChainExtent();
+				const VkExtent2D targetExtent = renderer.getTargetExtent();
+				const VkExtent2D renderExtent = renderer.getRenderExtent();
+				const ImVec2 imageSize{static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height)};
+				const ImVec2 targetSize{static_cast<float>(targetExtent.width), static_cast<float>(targetExtent.height)};
+				ImVec2 uvMin{0.0f, 0.0f};
+				ImVec2 uvMax{static_cast<float>(renderExtent.width) / targetSize.x, static_cast<float>(renderExtent.height) / targetSize.y};
+				if (renderExtent.width != swapChainExtent.width || renderExtent.height != swapChainExtent.height) {
+					uvMin = ImVec2(0.5f / targetSize.x, 0.5f / targetSize.y);
+					uvMax = ImVec2((static_cast<float>(renderExtent.width) - 0.5f) / targetSize.x, (static_cast<float>(renderExtent.height) - 0.5f) / targetSize.y);
+				}
+				ImGui::Image((ImTextureID)uiState.viewportTexture, imageSize, uvMin, uvMax);
+			}
 
 			ImVec2 windowSize = ImGui::GetWindowSize();
 			ImVec2 minBounds = ImGui::GetWindowPos();
@@ -239,6 +246,7 @@ namespace Aspen {
 					objectComponent.rotation = glm::normalize(glm::quat(rotation));
 					objectComponent.scale = scale;
 					objectComponent.isTransformUpdated = true;
+					frameInfo.scene->markTransformsChanged();
 				}
 			}
 			ImGui::End();
@@ -282,6 +290,7 @@ namespace Aspen {
 						ImGui::EndDisabled();
 					}
 					changed |= ImGui::SliderInt("Update Rate", &appState.update_rate, 1, 300, "%i", ImGuiSliderFlags_AlwaysClamp);
+					changed |= ImGui::SliderInt("Frames In Flight", &appState.framesInFlight, 2, SwapChain::MAX_FRAMES_IN_FLIGHT, "%i", ImGuiSliderFlags_AlwaysClamp);
 				}
 
 				// Vsync
@@ -324,6 +333,12 @@ namespace Aspen {
 						changed |= ImGui::Checkbox("Refractions?", &appState.useRTRefractions);
 					}
 
+					changed |= ImGui::Checkbox("Dynamic Resolution", &appState.dynamicResolution);
+					if (appState.dynamicResolution) {
+						changed |= ImGui::DragFloat("GPU Budget", &appState.gpuFrameBudget, 0.1f, 1.0f, 100.0f, "%.1f ms", ImGuiSliderFlags_AlwaysClamp);
+						changed |= ImGui::SliderFloat("Min Scale", &appState.minRenderScale, 0.25f, 1.0f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+					}
+
 					changed |= ImGui::Checkbox("Shadow Mapping", &appState.useShadows);
 					if (appState.useShadows) {
 						float shadowBias;
@@ -351,6 +366,16 @@ namespace Aspen {
 					}
 
 					changed |= ImGui::Checkbox("Texture Mapping", &appState.useTextureMapping);
+					ImGui::Checkbox("CPU Mouse Picking", &appState.useCPUPicking);
+					ImGui::Checkbox("Indirect Drawing", &appState.useIndirectDraw);
+					if (appState.useIndirectDraw) {
+						ImGui::Checkbox("GPU Frustum Culling", &appState.useGPUCulling);
+						if (appState.useGPUCulling) {
+							ImGui::Checkbox("Occlusion Culling", &appState.useOcclusionCulling);
+						}
+					}
+					ImGui::Checkbox("Front-to-back Sorting", &appState.sortFrontToBack);
+					ImGui::Checkbox("Parallel Recording", &appState.parallelRecording);
 				}
 				ImGui::TreePop();
 			}
@@ -388,6 +413,7 @@ namespace Aspen {
 					objectTranform.rotation = glm::normalize(glm::quat(rotation));
 					objectTranform.scale = scale;
 					objectTranform.isTransformUpdated = true;
+					frameInfo.scene->markTransformsChanged();
 				}
 
 				if (uiState.gizmoOperation != ImGuizmo::SCALE) {
@@ -455,7 +481,86 @@ namespace Aspen {
 					ImGui::Separator();
 
 					ImGui::Text("Average over 120 frames: %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+					{
+						const VkExtent2D renderExtent = renderer.getRenderExtent();
+						const VkExtent2D targetExtent = renderer.getTargetExtent();
+						ImGui::Text("Render extent: %ux%u (%.0f%% scale) of %ux%u targets", renderExtent.width, renderExtent.height, renderer.getDynamicResolution().getScale() * 100.0f, targetExtent.width, targetExtent.height);
+					}
+					const auto& pacing = renderer.getFramePacing();
+					ImGui::Text("Frame pacing: %.3f ms (deviation %.3f ms), %.3f ms waiting for the GPU, %d in flight", pacing.frameTime, pacing.frameTimeDeviation, pacing.fenceWait, renderer.getFramesInFlight());
 					ImGui::Text("%d vertices, %d indices (%d triangles)", io.MetricsRenderVertices + appState.totalVertexCount, io.MetricsRenderIndices + appState.totalIndexCount, io.MetricsRenderIndices + appState.totalIndexCount / 3);
+					ImGui::Text("Draw calls: %d (%d without instancing, %d recorded)", appState.drawCallsBatched, appState.drawCallsUnbatched, appState.drawCallsRecorded);
+					ImGui::Text("Binds: %d pipelines, %d descriptor sets", appState.pipelineBinds, appState.descriptorSetBinds);
+					ImGui::Text("Geometry binds: %d (%d skipped)", appState.geometryBinds, appState.skippedBinds);
+					if (ImGui::TreeNode("RecordingTimes", "Command recording: %.3f ms", appState.recordTime)) {
+						for (size_t i = 0; i < appState.threadRecordTimes.size(); ++i) {
+							if (i + 1 == appState.threadRecordTimes.size()) {
+								ImGui::Text("Main thread: %.3f ms", appState.threadRecordTimes[i]);
+							} else {
+								ImGui::Text("Worker %d: %.3f ms", static_cast<int>(i), appState.threadRecordTimes[i]);
+							}
+						}
+						ImGui::TreePop();
+					}
+					// Rolling over the last GpuProfiler::HISTORY_SIZE samples of every scope, the frame's first.
+					auto& profiler = renderer.getProfiler();
+					const auto reports = profiler.isSupported() ? profiler.getReports() : std::vector<GpuProfiler::ScopeReport>{};
+					if (profiler.isSupported()) {
+						const auto frame = std::find_if(reports.begin(), reports.end(), [](const auto& report) { return report.name == GpuProfiler::FRAME_SCOPE; });
+						if (frame != reports.end()) {
+							// How much of the shorter of the CPU's and the GPU's work per frame hides behind the other. 0 when they
+							// take turns, 1 when it is hidden entirely.
+							const double cpuBusy = pacing.frameTime - pacing.fenceWait;
+							const double shorter = std::min(cpuBusy, frame->average);
+							const double overlap = shorter > 0.0 ? std::clamp((cpuBusy + frame->average - pacing.frameTime) / shorter, 0.0, 1.0) : 0.0;
+							ImGui::Text("CPU/GPU overlap: %.0f%% (CPU %.3f ms, GPU %.3f ms)", overlap * 100.0, cpuBusy, frame->average);
+						}
+						if (frame != reports.end() && ImGui::TreeNode("GpuTimings", "GPU: %.3f ms (min %.3f, avg %.3f, p99 %.3f)", frame->last, frame->min, frame->average, frame->p99)) {
+							for (const auto& report : reports) {
+								if (&report == &*frame) {
+									continue;
+								}
+								ImGui::Text("%s: %.3f ms (min %.3f, avg %.3f, p99 %.3f)", report.name.c_str(), report.last, report.min, report.average, report.p99);
+								if (report.hasStatistics) {
+									const auto& statistics = report.statistics;
+									ImGui::TextDisabled("    %llu vertices, %llu primitives, %llu fragments, %llu compute", static_cast<unsigned long long>(statistics.vertexInvocations), static_cast<unsigned long long>(statistics.clippingPrimitives), static_cast<unsigned long long>(statistics.fragmentInvocations), static_cast<unsigned long long>(statistics.computeInvocations));
+								}
+							}
+							if (ImGui::Button("Export CSV")) {
+								if (!profiler.exportCsv(GPU_PROFILE_PATH)) {
+									std::cout << "Failed to write GPU profile " << GPU_PROFILE_PATH << std::endl;
+								}
+							}
+							ImGui::TreePop();
+						}
+					}
+					if (ImGui::TreeNode("CpuTimeline", "CPU timeline: %.3f ms", static_cast<double>(CpuProfiler::getLastFrame().end - CpuProfiler::getLastFrame().start) / 1e6)) {
+						drawCpuTimeline();
+						ImGui::TreePop();
+					}
+					ImGui::Text("Render graph: %d passes (%d culled), %d barriers in %d batches", appState.renderGraphPasses, appState.renderGraphCulledPasses, appState.renderGraphBarriers, appState.renderGraphBarrierBatches);
+					ImGui::Text("Transient memory: %.1f MiB (%.1f MiB without aliasing)", appState.transientMemory, appState.transientMemoryUnaliased);
+					ImGui::Text("Pipelines: %d in %.1f ms (%s start), %d shader modules (%d shared)", appState.pipelineCount, appState.pipelineCreationTime, appState.pipelineCacheWarm ? "warm" : "cold", appState.shaderModuleCount, appState.shaderModuleHits);
+					ImGui::Text("Startup: %.1f ms, first frame after %.1f ms", appState.startupTime, appState.timeToFirstFrame);
+					ImGui::Text("Shadowed lights: %d (%d culled, %d over budget), atlas %.0f%% used", appState.shadowedLights, appState.shadowCulledLights, appState.shadowDroppedLights, appState.shadowAtlasUsage * 100.0f);
+					ImGui::Text("Shadow tiles: %d static, %d composited, %d dynamic casters", appState.shadowStaticFaces, appState.shadowCompositedFaces, appState.shadowDynamicCasters);
+					ImGui::Text("Light grid: %d lights, %d of %d clusters lit, up to %d lights per cluster", appState.clusteredLights, appState.occupiedClusters, appState.clusterCount, appState.maxClusterLights);
+					if (appState.useIndirectDraw && appState.useGPUCulling) {
+						// The occlusion culling passes keep their last timing once they stop running, so only count them while they run.
+						double cullingTime = 0.0;
+						for (const auto& report : reports) {
+							const bool occlusionPass = report.name == CullingRenderSystem::DEPTH_PYRAMID_PASS || report.name == CullingRenderSystem::OCCLUSION_CULLING_PASS;
+							if (report.name == CullingRenderSystem::CULLING_PASS || (occlusionPass && appState.useOcclusionCulling)) {
+								cullingTime += report.last;
+							}
+						}
+						ImGui::Text("GPU culling: %d instances, %d outside the frustum, %d occluded, %d late, %.3f ms", appState.culledInstancesTested, appState.frustumCulledInstances, appState.occlusionCulledInstances, appState.lateInstances, cullingTime);
+					}
+					if (appState.useCPUPicking) {
+						ImGui::Text("Mouse Picking: %.4f ms", appState.mousePickingTime);
+					} else {
+						ImGui::Text("Mouse Picking: resolved %d frames after recording", appState.mousePickingLatency);
+					}
 
 					if (ImGui::BeginPopupContextWindow()) {
 						if (ImGui::MenuItem("Custom", nullptr, corner == -1))
@@ -482,4 +587,72 @@ namespace Aspen {
 		// Render ImGui UI at the end of the render pass.
 		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), frameInfo.commandBuffer);
 	}
+
+	void UIRenderSystem::drawCpuTimeline() {
+		constexpr float WIDTH = 600.0f;
+		constexpr float ROW_HEIGHT = 18.0f;
+
+		bool enabled = CpuProfiler::isEnabled();
+		if (ImGui::Checkbox("Profile", &enabled)) {
+			CpuProfiler::setEnabled(enabled);
+		}
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(100.0f);
+		ImGui::InputInt("frames", &cpuCaptureFrames);
+		cpuCaptureFrames = std::max(cpuCaptureFrames, 1);
+		ImGui::SameLine();
+		if (CpuProfiler::isCapturing()) {
+			ImGui::TextDisabled("Capturing...");
+		} else if (ImGui::Button("Capture trace")) {
+			CpuProfiler::startCapture(static_cast<uint32_t>(cpuCaptureFrames), CpuProfiler::TRACE_PATH);
+		}
+
+		const auto& frame = CpuProfiler::getLastFrame();
+		const double duration = static_cast<double>(std::max<int64_t>(frame.end - frame.start, 1));
+		const auto threadNames = CpuProfiler::getThreadNames();
+
+		// Rows each thread needs, threads without events are left out.
+		std::vector<uint32_t> depths(threadNames.size(), 0);
+		for (const auto& event : frame.events) {
+			depths[event.thread] = std::max(depths[event.thread], event.depth + 1);
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		for (size_t thread = 0; thread < threadNames.size(); thread++) {
+			if (depths[thread] == 0) {
+				continue;
+			}
+
+			ImGui::TextUnformatted(threadNames[thread].c_str());
+			const ImVec2 origin = ImGui::GetCursorScreenPos();
+			const float height = static_cast<float>(depths[thread]) * ROW_HEIGHT;
+			ImGui::Dummy(ImVec2(WIDTH, height));
+			drawList->AddRectFilled(origin, ImVec2(origin.x + WIDTH, origin.y + height), IM_COL32(30, 30, 30, 160));
+
+			for (const auto& event : frame.events) {
+				if (event.thread != thread) {
+					continue;
+				}
+
+				// Startup events of the first frame may begin before it.
+				const double first = std::clamp(static_cast<double>(event.start - frame.start) / duration, 0.0, 1.0);
+				const double last = std::clamp(static_cast<double>(event.end - frame.start) / duration, 0.0, 1.0);
+				const ImVec2 min{origin.x + static_cast<float>(first) * WIDTH, origin.y + static_cast<float>(event.depth) * ROW_HEIGHT};
+				const ImVec2 max{std::max(origin.x + static_cast<float>(last) * WIDTH, min.x + 1.0f), min.y + ROW_HEIGHT - 1.0f};
+
+				// Colour by name, so a scope keeps its colour from frame to frame.
+				const size_t hash = std::hash<std::string_view>{}(event.name);
+				const ImU32 color = IM_COL32(80 + hash % 150, 80 + (hash >> 8) % 150, 80 + (hash >> 16) % 150, 255);
+				drawList->AddRectFilled(min, max, color);
+
+				const float textWidth = ImGui::CalcTextSize(event.name).x;
+				if (max.x - min.x > textWidth + 4.0f) {
+					drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name);
+				}
+				if (ImGui::IsMouseHoveringRect(min, max)) {
+					ImGui::SetTooltip("%s: %.3f ms", event.name, static_cast<double>(event.end - event.start) / 1e6);
+				}
+			}
+		}
+	}
 } // namespace Aspen
\ No newline at end of file
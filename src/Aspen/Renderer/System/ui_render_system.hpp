@@ -28,6 +28,8 @@ namespace Aspen {
 
 	class UIRenderSystem {
 	public:
+		static constexpr const char* GPU_PROFILE_PATH = "gpu_profile.csv"; // Written by the metrics window's export button.
+
 		UIRenderSystem(Device& device, Renderer& renderer, std::vector<std::unique_ptr<DescriptorSetLayout>>& descriptorSetLayout);
 		~UIRenderSystem() = default;
 
@@ -37,6 +39,7 @@ namespace Aspen {
 		UIRenderSystem(UIRenderSystem&&) = delete;            // Move Constructor
 		UIRenderSystem& operator=(UIRenderSystem&&) = delete; // Move Assignment Operator
 
+		void createPipelines();
 		void render(FrameInfo& frameInfo, UIState& uiState, ApplicationState& appState);
 		void onResize();
 
@@ -47,8 +50,9 @@ namespace Aspen {
 	private:
 		void createDescriptorSetLayout();
 		void createDescriptorSet();
-		void createPipelines();
-		void createPipelineLayout(std::unique_ptr<DescriptorSetLayout>& descriptorSetLayout);
+		void createPipelineLayout(std::vector<std::unique_ptr<DescriptorSetLayout>>& globalDescriptorSetLayout);
+		// Every thread's profiled scopes of the last frame, one row per nesting level.
+		void drawCpuTimeline();
 
 		Device& device;
 		Renderer& renderer;
@@ -58,5 +62,7 @@ namespace Aspen {
 		std::vector<VkDescriptorSet> descriptorSets;
 
 		std::vector<std::unique_ptr<Buffer>> uboBuffers;
+
+		int cpuCaptureFrames = 60;
 	};
 } // namespace Aspen
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Aspen/Renderer/device.hpp"
+#include "Aspen/Renderer/swap_chain.hpp"
 
 namespace Aspen {
 
@@ -117,6 +118,9 @@ namespace Aspen {
 		// Setup Descriptor Pools.
 		createDescriptorPool();
 
+		// Seed the pipeline cache with what the last run compiled.
+		pipelineCache = std::make_unique<PipelineCache>(*this, PIPELINE_CACHE_PATH);
+
 		// Setup ImGui Descriptor Pools.
 		initImGuiBackend();
 
@@ -139,6 +143,8 @@ namespace Aspen {
 		descriptorPool.reset();      // Free descriptor pool pointer.
 		descriptorPoolImGui.reset(); // Free ImGui's descriptor pool pointer.
 
+		pipelineCache.reset(); // Save the pipeline cache and destroy the shader modules.
+
 		// vkDestroyDescriptorPool(device_, descriptorPool, nullptr);       // Destroy descriptor pool.
 		// vkDestroyDescriptorPool(device_, ImGui_descriptorPool, nullptr); // Destroy ImGui's descriptor pool.
 
@@ -271,7 +277,17 @@ namespace Aspen {
 		enabledFeatures.samplerAnisotropy = VK_TRUE;
 		enabledFeatures.fragmentStoresAndAtomics = VK_TRUE;
 		enabledFeatures.shaderInt64 = VK_TRUE;
+		enabledFeatures.multiDrawIndirect = VK_TRUE;         // More than one draw per vkCmdDrawIndexedIndirect.
+		enabledFeatures.drawIndirectFirstInstance = VK_TRUE; // Indirect commands select their instances through firstInstance.
 		enabledFeatures.samplerAnisotropy = VK_TRUE;
+
+		// Optional, the GPU profiler only collects pipeline statistics if both are supported.
+		{
+			VkPhysicalDeviceFeatures supportedFeatures;
+			vkGetPhysicalDeviceFeatures(physicalDevice_, &supportedFeatures);
+			enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+			enabledFeatures.inheritedQueries = supportedFeatures.inheritedQueries; // Statistics queries stay active across secondary command buffers.
+		}
 		// enabledFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
 		// enabledFeatures.fillModeNonSolid = true;
 		// enabledFeatures.wideLines = true;
@@ -280,6 +296,7 @@ namespace Aspen {
 		{
 			enabledVK12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
 			enabledVK12Features.hostQueryReset = VK_TRUE;
+			enabledVK12Features.drawIndirectCount = VK_TRUE; // GPU culling writes the number of draws.
 
 			// Descriptor Indexing
 			enabledVK12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
@@ -369,13 +386,18 @@ namespace Aspen {
 		}
 	}
 
+	// Sized for the sets the render systems allocate from it, the culling system has a pool of its own.
+	// Per frame in flight: the global and instance sets, the UI, point light, mouse picking and shadow UBO sets, the shadow atlas set and both bindless texture sets.
+	// Once: the ray tracing set and the outline and depth pre-pass sets.
 	void Device::createDescriptorPool() {
+		constexpr uint32_t frames = SwapChain::MAX_FRAMES_IN_FLIGHT;
+		constexpr uint32_t bindlessTextures = 32; // Variable count of the texture bindings, allocated in full.
+
 		descriptorPool = DescriptorPool::Builder(*this)
-		                     .setMaxSets(20)
-		                     .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10)
-		                     .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 10)
-		                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10)
-		                     .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10)
+		                     .setMaxSets(frames * 9 + 3)
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frames * 5)
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frames * 5 + 4)
+		                     .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames * (2 * bindlessTextures + 1) + 2)
 		                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1)
 		                     .addPoolSize(VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1)
 		                     .build();
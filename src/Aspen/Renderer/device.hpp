@@ -5,6 +5,7 @@
 #include "Aspen/Renderer/descriptors.hpp"
 #include "Aspen/Renderer/tools.hpp"
 #include "Aspen/Renderer/device_procedures.hpp"
+#include "Aspen/Renderer/pipeline_cache.hpp"
 
 namespace Aspen {
 
@@ -33,6 +34,7 @@ namespace Aspen {
 #else
 		const bool enableValidationLayers = true;
 #endif
+		static constexpr const char* PIPELINE_CACHE_PATH = "assets/pipeline.cache";
 
 		explicit Device(Window& window);
 		~Device();
@@ -98,6 +100,10 @@ namespace Aspen {
 			return *descriptorPoolImGui;
 		}
 
+		PipelineCache& getPipelineCache() {
+			return *pipelineCache;
+		}
+
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
 		QueueFamilyIndices findPhysicalQueueFamilies() {
@@ -169,6 +175,8 @@ namespace Aspen {
 		std::unique_ptr<DescriptorPool> descriptorPool{};
 		std::unique_ptr<DescriptorPool> descriptorPoolImGui{};
 
+		std::unique_ptr<PipelineCache> pipelineCache{};
+
 		const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
 		const std::vector<const char*> deviceExtensions = {
 		    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
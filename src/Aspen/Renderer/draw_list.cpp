@@ -0,0 +1,57 @@
+#include "Aspen/Renderer/draw_list.hpp"
+
+#include "Aspen/Core/model.hpp"
+
+namespace Aspen {
+	const DrawList::CulledDraws* DrawList::getCulledDraws(Instances instances) const {
+		if (!culled) {
+			return nullptr;
+		}
+		switch (instances) {
+			case Instances::VISIBLE:
+				return &visible;
+			case Instances::EARLY:
+				return early.commandBuffer ? &early : &visible;
+			case Instances::LATE:
+				return &late;
+			default:
+				return nullptr;
+		}
+	}
+
+	void DrawList::draw(VkCommandBuffer commandBuffer, BindState& bindState, bool useIndirect, Instances instances, DrawRange range) const {
+		// Culling only runs for indirect draws, so culled commands are always drawn indirectly.
+		const CulledDraws* culledDraws = getCulledDraws(instances);
+		if (instances == Instances::LATE && (!culledDraws || !culledDraws->commandBuffer)) {
+			return;
+		}
+		if (!culledDraws && isSplittable(useIndirect)) {
+			const auto first = std::min(range.first, static_cast<uint32_t>(batches.size()));
+			const auto last = first + std::min(range.count, static_cast<uint32_t>(batches.size()) - first);
+			for (uint32_t i = first; i < last; ++i) {
+				const auto& batch = batches[i];
+				bindState.bindGeometry(commandBuffer, batch.geometry->vertexBuffer->getBuffer(), batch.geometry->indexBuffer->getBuffer());
+				Model::drawInstanced(commandBuffer, static_cast<uint32_t>(batch.geometry->indices.size()), batch.instanceCount, batch.firstInstance);
+			}
+			return;
+		}
+
+		assert(range.isFull() && "Indirect draws cannot be split by batch range!");
+
+		// Bind the scene wide buffers once, each indirect command selects its geometry through firstIndex and vertexOffset.
+		bindState.bindGeometry(commandBuffer, sceneVertexBuffer->getBuffer(), sceneIndexBuffer->getBuffer());
+
+		if (culledDraws) {
+			// The culling pass wrote how many of the commands survived.
+			vkCmdDrawIndexedIndirectCount(commandBuffer, culledDraws->commandBuffer->getBuffer(), 0, culledDraws->drawCountBuffer->getBuffer(), 0, indirectDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+		} else {
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectCommandBuffer->getBuffer(), 0, indirectDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		for (uint32_t batchIndex : looseBatches) {
+			const auto& batch = batches[batchIndex];
+			bindState.bindGeometry(commandBuffer, batch.geometry->vertexBuffer->getBuffer(), batch.geometry->indexBuffer->getBuffer());
+			Model::drawInstanced(commandBuffer, static_cast<uint32_t>(batch.geometry->indices.size()), batch.instanceCount, batch.firstInstance);
+		}
+	}
+} // namespace Aspen
\ No newline at end of file
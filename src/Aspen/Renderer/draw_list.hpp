@@ -0,0 +1,91 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Scene/scene.hpp"
+#include "Aspen/Renderer/render_queue.hpp"
+
+namespace Aspen {
+	// A run of consecutive slots in the frame's instance buffer which all use the same geometry, drawn with one instanced call.
+	// Batches are ordered front to back by their closest instance, and so are the instances within a batch.
+	struct DrawBatch {
+		MeshComponent::Geometry* geometry;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+		uint32_t geometryIndex;   // Index into SceneData::geometries, or INVALID_GEOMETRY if the geometry is not part of the scene buffers.
+		uint32_t commandIndex;    // Index of the batch's indirect command, or LOOSE_BATCH if it is drawn directly.
+		glm::vec4 boundingSphere; // Local space bounds of the geometry.
+
+		static constexpr uint32_t INVALID_GEOMETRY = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t LOOSE_BATCH = std::numeric_limits<uint32_t>::max();
+	};
+
+	// Batches [first, first + count) of a draw list, lets a pass be split over several command buffers.
+	struct DrawRange {
+		uint32_t first = 0;
+		uint32_t count = std::numeric_limits<uint32_t>::max();
+
+		bool isFull() const {
+			return first == 0 && count == std::numeric_limits<uint32_t>::max();
+		}
+	};
+
+	// Everything a render system needs to draw the scene's render entities for one frame. Built by GlobalRenderSystem::updateUBOs.
+	struct DrawList {
+		std::vector<DrawBatch> batches;
+		std::vector<uint32_t> instanceSlots; // Instance buffer slot of every render entity, indexed by entity id.
+
+		// Batches whose geometry lives in the scene wide vertex/index buffers are drawn from a single indirect command buffer.
+		Buffer* sceneVertexBuffer = nullptr;
+		Buffer* sceneIndexBuffer = nullptr;
+		Buffer* indirectCommandBuffer = nullptr;
+		uint32_t indirectDrawCount = 0;
+		std::vector<uint32_t> looseBatches; // Batches whose geometry was added after the scene buffers were built.
+		uint32_t instanceCount = 0;
+
+		// The instances and compacted commands one culling phase left.
+		struct CulledDraws {
+			Buffer* commandBuffer = nullptr;
+			Buffer* drawCountBuffer = nullptr; // Number of culled commands, stored at offset 0.
+			VkDescriptorSet instanceDescriptorSet = VK_NULL_HANDLE;
+		};
+
+		// Set by CullingRenderSystem once it has recorded this frame's culling passes.
+		// The culled instances and commands replace the unculled ones for the passes that ask for them.
+		bool culled = false;
+		CulledDraws visible; // What survived every test, for the passes after the depth pre-pass.
+		CulledDraws early;   // Only with occlusion culling: what was visible last frame, for the depth pre-pass.
+		CulledDraws late;    // Only with occlusion culling: what the occlusion test found that the depth pre-pass has not drawn.
+
+		// Which of the frame's instances a pass draws.
+		enum class Instances {
+			ALL,     // Every render entity, e.g. for the shadows, which the camera frustum says nothing about.
+			VISIBLE, // The ones that survived culling, or all of them if it did not run.
+			EARLY,   // The first phase of occlusion culling, the same as VISIBLE without it.
+			LATE,    // The second phase of occlusion culling. Draws nothing without it.
+		};
+
+		uint32_t getInstanceSlot(entt::entity entity) const {
+			return instanceSlots[entt::to_entity(entity)];
+		}
+
+		// Instance set to bind at set 1 before calling draw(), which depends on which instances are drawn.
+		VkDescriptorSet getInstanceDescriptorSet(VkDescriptorSet unculledInstanceDescriptorSet, Instances instances) const {
+			const CulledDraws* draws = getCulledDraws(instances);
+			return draws ? draws->instanceDescriptorSet : unculledInstanceDescriptorSet;
+		}
+
+		// Records the draws for every batch. Expects the pipeline, descriptor sets and push constants to be bound already.
+		// Vertex and index buffers go through bindState, so buffers that are still bound are not bound again.
+		// Only direct draws can be limited to a range of batches, see isSplittable().
+		void draw(VkCommandBuffer commandBuffer, BindState& bindState, bool useIndirect, Instances instances = Instances::ALL, DrawRange range = {}) const;
+
+		// Whether draw() records one call per batch, which is the only case where splitting the batches over several command buffers pays off.
+		bool isSplittable(bool useIndirect) const {
+			return !useIndirect || indirectDrawCount == 0;
+		}
+
+	private:
+		// Culled draws standing in for the unculled ones, nullptr if the unculled ones are drawn.
+		const CulledDraws* getCulledDraws(Instances instances) const;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "Aspen/Renderer/dynamic_resolution.hpp"
+
+namespace Aspen {
+	void DynamicResolution::setEnabled(bool value) {
+		enabled = value;
+		if (!enabled) {
+			scale = MAX_SCALE;
+			averageFrameTime = 0.0;
+			settling = 0;
+		}
+	}
+
+	void DynamicResolution::update(double gpuFrameTime, int settleFrames) {
+		if (!enabled || gpuFrameTime <= 0.0) {
+			return;
+		}
+
+		// Still measuring frames recorded at the previous scale.
+		if (settling > 0) {
+			settling--;
+			return;
+		}
+
+		averageFrameTime = averageFrameTime == 0.0 ? gpuFrameTime : averageFrameTime + (gpuFrameTime - averageFrameTime) * SMOOTHING;
+		if (averageFrameTime <= targetFrameTime && averageFrameTime >= targetFrameTime * LOW_WATERMARK) {
+			return;
+		}
+
+		// The frame time mostly grows with the pixel count, the square of the scale. Growing aims for the middle of the
+		// band, so the next frames do not go straight over the budget.
+		const double target = averageFrameTime > targetFrameTime ? targetFrameTime : targetFrameTime * (1.0 + LOW_WATERMARK) * 0.5;
+		const float desired = scale * static_cast<float>(std::sqrt(target / averageFrameTime));
+		const float next = std::clamp(std::round(desired / SCALE_STEP) * SCALE_STEP, minScale, MAX_SCALE);
+		if (next == scale) {
+			return;
+		}
+
+		scale = next;
+		averageFrameTime = 0.0;
+		settling = settleFrames;
+	}
+
+	VkExtent2D DynamicResolution::getRenderExtent(VkExtent2D targetExtent) const {
+		return {
+		    std::max(1u, static_cast<uint32_t>(static_cast<float>(targetExtent.width) * scale)),
+		    std::max(1u, static_cast<uint32_t>(static_cast<float>(targetExtent.height) * scale)),
+		};
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+
+#include <vulkan/vulkan_core.h>
+
+namespace Aspen {
+	// Picks the scale the scene is rendered at from the GPU frame time, to keep it within a budget.
+	//
+	// The offscreen targets are at least the swap chain's size, the scene is rendered into their top left corner at the
+	// scale and the UI upsamples that corner into the viewport. Changing the scale only changes viewports, scissors and
+	// the ray tracing launch size, nothing is recreated.
+	// The GPU time of a frame is known a few frames after it was recorded, so after every change the controller waits
+	// for the frames rendered at the new scale before it adjusts again.
+	class DynamicResolution {
+	public:
+		static constexpr float MAX_SCALE = 1.0f;
+		static constexpr float SCALE_STEP = 1.0f / 32.0f; // The scale is a multiple of it.
+		static constexpr double LOW_WATERMARK = 0.85;     // Of the budget, the scale only grows below it.
+		static constexpr double SMOOTHING = 0.25;          // Weight of a new frame time in the running average.
+
+		bool isEnabled() const {
+			return enabled;
+		}
+		float getScale() const {
+			return scale;
+		}
+
+		// Disabling renders at full resolution again.
+		void setEnabled(bool value);
+		// Milliseconds of GPU time per frame to stay under.
+		void setTargetFrameTime(double milliseconds) {
+			targetFrameTime = milliseconds;
+		}
+		void setMinScale(float value) {
+			minScale = std::clamp(value, SCALE_STEP, MAX_SCALE);
+		}
+
+		// Feeds the GPU milliseconds of a finished frame, 0 if none was read back. settleFrames is how many frames pass
+		// before a frame recorded now is measured.
+		void update(double gpuFrameTime, int settleFrames);
+		// The part of a target of the given size to render to at the current scale.
+		VkExtent2D getRenderExtent(VkExtent2D targetExtent) const;
+
+	private:
+		bool enabled = false;
+		double targetFrameTime = 1000.0 / 60.0;
+		float minScale = 0.5f;
+
+		float scale = MAX_SCALE;
+		double averageFrameTime = 0.0; // 0 until a frame at the current scale was measured.
+		int settling = 0;              // Frames left that were recorded before the last change.
+	};
+} // namespace Aspen
\ No newline at end of file
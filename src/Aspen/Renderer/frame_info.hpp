@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Aspen/Scene/scene.hpp"
+#include "Aspen/Renderer/draw_list.hpp"
 
 namespace Aspen {
 	struct RenderInfo {
@@ -30,6 +30,14 @@ namespace Aspen {
 
 		int useRayTracer = 0;
 		bool useTextureMapping = true;
+		bool useCPUPicking = true; // Ray cast against the scene BVH instead of rendering the picking pass and reading it back.
+		bool useIndirectDraw = true; // Draw the scene from the concatenated scene buffers with one indirect call per pass.
+		bool useGPUCulling = true;   // Frustum cull the depth pre-pass and main pass in a compute pass. Needs indirect drawing.
+		bool useOcclusionCulling = true; // Also cull what the depth pre-pass hides, against a depth pyramid. Needs GPU culling.
+
+		bool dynamicResolution = false; // Scale the scene's render extent to keep the GPU frame time within the budget.
+		float gpuFrameBudget = 16.0f;   // Milliseconds.
+		float minRenderScale = 0.5f;
 
 		bool useShadows = true;
 		float rasterShadowBias = 0.00001;
@@ -44,6 +52,7 @@ namespace Aspen {
 
 		bool enable_vsync = true;
 		int fps_cap = 60;
+		int framesInFlight = 2; // Frames the CPU may record ahead of the GPU, 2 or 3.
 
 		bool resync = true;
 		bool vsync_snapping = false;
@@ -65,16 +74,59 @@ namespace Aspen {
 
 		int totalVertexCount = 0;
 		int totalIndexCount = 0;
+		double mousePickingTime = 0.0; // Milliseconds taken by the last CPU ray cast.
+		int mousePickingLatency = 0;   // Frames between recording the last GPU pick and reading it back.
+		int drawCallsUnbatched = 0;    // Draw calls the depth, shadow and main passes would issue with one draw per entity.
+		int drawCallsBatched = 0;      // Draw calls they actually issue with instancing.
+		int drawCallsRecorded = 0;     // Draw commands recorded on the CPU, a single indirect draw covers many batches.
+		int pipelineBinds = 0;         // Pipeline binds recorded in the last frame.
+		int descriptorSetBinds = 0;    // vkCmdBindDescriptorSets calls recorded in the last frame.
+		int geometryBinds = 0;         // Vertex and index buffer binds recorded in the last frame.
+		int skippedBinds = 0;          // Vertex and index buffer binds skipped because the buffer was still bound.
+		bool sortFrontToBack = true;   // Order batches and their instances front to back for early depth rejection.
+		bool parallelRecording = true; // Record the render passes on worker threads.
+		double recordTime = 0.0;       // Milliseconds from handing out the render passes to all of them being recorded.
+		std::vector<double> threadRecordTimes; // Milliseconds each thread spent recording, the main thread is last.
+		int renderGraphPasses = 0;             // Passes the render graph executed in the last frame.
+		int renderGraphCulledPasses = 0;       // Passes it skipped because they were disabled or nothing consumed their output.
+		int renderGraphBarriers = 0;           // Image and memory barriers it recorded.
+		int renderGraphBarrierBatches = 0;     // vkCmdPipelineBarrier calls they were batched into.
+		double transientMemory = 0.0;          // MiB bound to the render graph's images.
+		double transientMemoryUnaliased = 0.0; // MiB they would take without sharing memory.
+		bool pipelineCacheWarm = false;        // The pipeline cache was loaded from disk at startup.
+		int pipelineCount = 0;                 // Pipelines created at startup.
+		double pipelineCreationTime = 0.0;     // Milliseconds spent creating them.
+		int shaderModuleCount = 0;             // Distinct SPIR-V modules they use.
+		int shaderModuleHits = 0;              // Shader stages served by an already created module.
+		double startupTime = 0.0;              // Milliseconds from startup until the application was constructed.
+		double timeToFirstFrame = 0.0;         // Milliseconds from startup until the first frame was submitted.
+		int shadowStaticFaces = 0;             // Tiles of the cached static shadow atlas drawn this frame.
+		int shadowCompositedFaces = 0;         // Tiles of the shadow atlas rebuilt from the cache and the dynamic casters this frame.
+		int shadowDynamicCasters = 0;          // Animated entities drawn on top of the cached tiles, once per light they cast a shadow of.
+		int shadowedLights = 0;                // Point lights with a shadow this frame.
+		int shadowCulledLights = 0;            // Point lights without a shadow as their range is outside the camera frustum.
+		int shadowDroppedLights = 0;           // Point lights without a shadow as the texel budget ran out.
+		float shadowAtlasUsage = 0.0f;         // Fraction of the shadow atlas handed out to the lights.
+		int clusteredLights = 0;               // Point lights assigned to the light grid.
+		int clusterCount = 0;                  // Clusters of the light grid.
+		int occupiedClusters = 0;              // Clusters at least one light reaches.
+		int maxClusterLights = 0;              // Lights the busiest cluster's fragments loop over.
+		int culledInstancesTested = 0;         // Instances the GPU culling passes tested. Their counts are read back a few frames late.
+		int frustumCulledInstances = 0;        // Outside the camera frustum.
+		int occlusionCulledInstances = 0;      // Inside it but hidden behind the depth pre-pass' depth.
+		int lateInstances = 0;                 // Visible instances the depth pre-pass missed as they were hidden last frame.
 	};
 
 	struct FrameInfo {
 		int frameIndex;
 		float frameTime;
 		std::vector<VkDescriptorSet> descriptorSet;
-		uint32_t dynamicOffset;
+		const DrawList& drawList;
 		VkCommandBuffer commandBuffer;
 		Camera& camera;
 		std::shared_ptr<Scene>& scene;
-		ApplicationState appState;
+		ApplicationState& appState; // The application's, so the stats the render systems write show up in the UI.
+		BindState bindState{}; // Geometry buffers bound on commandBuffer so far.
+		DrawRange drawRange{}; // Batches the main pass should draw when it is split over several command buffers.
 	};
 } // namespace Aspen
\ No newline at end of file
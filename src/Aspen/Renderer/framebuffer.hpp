@@ -166,6 +166,40 @@ namespace Aspen {
 			vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
 		}
 
+		/**
+		 * Points the loaded attachments at new image views and recreates the framebuffer, keeping the render pass and sampler.
+		 * To be used when the images loaded from elsewhere were recreated, pipelines made with the render pass stay valid.
+		 * Only for framebuffers made by createRenderPass() from loaded attachments.
+		 *
+		 * @param newWidth Width of the framebuffer
+		 * @param newHeight Height of the framebuffer
+		 * @param views The new view of every attachment, in attachment order
+		 */
+		void recreateFramebuffer(uint32_t newWidth, uint32_t newHeight, const std::vector<VkImageView>& views) {
+			assert(views.size() == attachments.size() && "Every attachment needs a view.");
+
+			vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+
+			width = newWidth;
+			height = newHeight;
+			uint32_t maxLayers = 0;
+			for (size_t i = 0; i < attachments.size(); i++) {
+				assert(!attachments[i].image && "Owned attachments are not recreated.");
+				attachments[i].view = views[i];
+				maxLayers = std::max(maxLayers, attachments[i].subresourceRange.layerCount);
+			}
+
+			VkFramebufferCreateInfo framebufferInfo = {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.pAttachments = views.data();
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+			framebufferInfo.width = width;
+			framebufferInfo.height = height;
+			framebufferInfo.layers = maxLayers;
+			VK_CHECK(vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer));
+		}
+
 		/**
 		 * Create a new attachment described by createinfo to the framebuffer's attachment list.
 		 * This will also create a image and image view to go with the attachment.
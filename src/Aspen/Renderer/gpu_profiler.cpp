@@ -0,0 +1,265 @@
+#include "Aspen/Renderer/gpu_profiler.hpp"
+#include "Aspen/Renderer/swap_chain.hpp"
+
+namespace Aspen {
+	namespace {
+		constexpr uint32_t TIMESTAMPS_PER_FRAME = GpuProfiler::MAX_SCOPES * 2;
+		constexpr uint32_t STATISTICS_COUNT = std::popcount(GpuProfiler::PIPELINE_STATISTICS);
+	} // namespace
+
+	GpuProfiler::GpuProfiler(Device& device)
+	    : device(device), frames(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+		if (!device.properties.limits.timestampComputeAndGraphics) {
+			return;
+		}
+
+		uint32_t validBits = 0;
+		{
+			uint32_t familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, families.data());
+			validBits = families[device.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+		}
+		if (validBits == 0) {
+			return;
+		}
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = TIMESTAMPS_PER_FRAME * frameCount + 2;
+		if (vkCreateQueryPool(device.device(), &queryPoolInfo, nullptr, &timestampPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create GPU profiler timestamp query pool!");
+		}
+		vkResetQueryPool(device.device(), timestampPool, 0, queryPoolInfo.queryCount);
+
+		if (usesPipelineStatistics(device)) {
+			queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			queryPoolInfo.queryCount = MAX_SCOPES * frameCount;
+			queryPoolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+			if (vkCreateQueryPool(device.device(), &queryPoolInfo, nullptr, &statisticsPool) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create GPU profiler pipeline statistics query pool!");
+			}
+			vkResetQueryPool(device.device(), statisticsPool, 0, queryPoolInfo.queryCount);
+		}
+	}
+
+	GpuProfiler::~GpuProfiler() {
+		if (statisticsPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device.device(), statisticsPool, nullptr);
+		}
+		if (timestampPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device.device(), timestampPool, nullptr);
+		}
+	}
+
+	// A statistics query may only be active while secondary command buffers execute if they inherit it.
+	bool GpuProfiler::usesPipelineStatistics(const Device& device) {
+		return device.enabledFeatures.pipelineStatisticsQuery && device.enabledFeatures.inheritedQueries;
+	}
+
+	void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+		if (!isSupported()) {
+			return;
+		}
+
+		frameTime = 0.0;
+		readResults(frameIndex);
+
+		auto& frame = frames[frameIndex];
+		vkCmdResetQueryPool(commandBuffer, timestampPool, frameIndex * TIMESTAMPS_PER_FRAME, TIMESTAMPS_PER_FRAME);
+		if (statisticsPool != VK_NULL_HANDLE) {
+			vkCmdResetQueryPool(commandBuffer, statisticsPool, frameIndex * MAX_SCOPES, MAX_SCOPES);
+		}
+		frame.scopes.clear();
+
+		currentFrame = frameIndex;
+		statisticsActive = true; // The frame's scope only measures time, it would otherwise hold the statistics query.
+		frame.frameScope = beginScope(commandBuffer, FRAME_SCOPE);
+		statisticsActive = false;
+	}
+
+	void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+		if (!isSupported()) {
+			return;
+		}
+
+		endScope(commandBuffer, frames[currentFrame].frameScope);
+		assert(!statisticsActive && "A GPU profiler scope was not ended!");
+		currentFrame = -1;
+	}
+
+	uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name) {
+		if (!isSupported() || currentFrame < 0) {
+			return NO_SCOPE;
+		}
+
+		auto& frame = frames[currentFrame];
+		if (frame.scopes.size() >= MAX_SCOPES) {
+			return NO_SCOPE;
+		}
+
+		const uint32_t scope = static_cast<uint32_t>(frame.scopes.size());
+		const bool statistics = statisticsPool != VK_NULL_HANDLE && !statisticsActive;
+		frame.scopes.push_back({getSeries(name), statistics, false});
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, currentFrame * TIMESTAMPS_PER_FRAME + scope * 2);
+		if (statistics) {
+			vkCmdBeginQuery(commandBuffer, statisticsPool, currentFrame * MAX_SCOPES + scope, 0);
+			statisticsActive = true;
+		}
+		return scope;
+	}
+
+	void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+		if (scope == NO_SCOPE) {
+			return;
+		}
+
+		auto& recorded = frames[currentFrame].scopes[scope];
+		assert(!recorded.ended && "GPU profiler scope ended twice!");
+		if (recorded.statistics) {
+			vkCmdEndQuery(commandBuffer, statisticsPool, currentFrame * MAX_SCOPES + scope);
+			statisticsActive = false;
+		}
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, currentFrame * TIMESTAMPS_PER_FRAME + scope * 2 + 1);
+		recorded.ended = true;
+	}
+
+	void GpuProfiler::beginImmediate(VkCommandBuffer commandBuffer) {
+		if (!isSupported()) {
+			return;
+		}
+
+		const uint32_t first = static_cast<uint32_t>(frames.size()) * TIMESTAMPS_PER_FRAME;
+		vkCmdResetQueryPool(commandBuffer, timestampPool, first, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, first);
+	}
+
+	void GpuProfiler::endImmediate(VkCommandBuffer commandBuffer) {
+		if (!isSupported()) {
+			return;
+		}
+
+		const uint32_t first = static_cast<uint32_t>(frames.size()) * TIMESTAMPS_PER_FRAME;
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, first + 1);
+	}
+
+	void GpuProfiler::resolveImmediate(const std::string& name) {
+		if (!isSupported()) {
+			return;
+		}
+
+		const uint32_t first = static_cast<uint32_t>(frames.size()) * TIMESTAMPS_PER_FRAME;
+		uint64_t timestamps[2]{};
+		if (vkGetQueryPoolResults(device.device(), timestampPool, first, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+			addSample(getSeries(name), timestamps[0], timestamps[1]);
+		}
+	}
+
+	uint32_t GpuProfiler::getSeries(const std::string& name) {
+		auto [it, inserted] = seriesIndices.try_emplace(name, static_cast<uint32_t>(series.size()));
+		if (inserted) {
+			series.emplace_back().name = name;
+		}
+		return it->second;
+	}
+
+	double GpuProfiler::addSample(uint32_t index, uint64_t begin, uint64_t end) {
+		auto& samples = series[index];
+		const double milliseconds = static_cast<double>((end - begin) & timestampMask) * device.properties.limits.timestampPeriod / 1e6;
+		if (samples.history.size() < HISTORY_SIZE) {
+			samples.history.push_back(milliseconds);
+		} else {
+			samples.history[samples.next] = milliseconds;
+		}
+		samples.next = (samples.next + 1) % HISTORY_SIZE;
+		return milliseconds;
+	}
+
+	void GpuProfiler::readResults(int frameIndex) {
+		auto& frame = frames[frameIndex];
+		if (frame.scopes.empty()) {
+			return;
+		}
+
+		// The frame's fence has signaled, so every query it wrote is available.
+		const uint32_t scopeCount = static_cast<uint32_t>(frame.scopes.size());
+		std::array<uint64_t, TIMESTAMPS_PER_FRAME> timestamps{};
+		if (vkGetQueryPoolResults(device.device(), timestampPool, frameIndex * TIMESTAMPS_PER_FRAME, scopeCount * 2, scopeCount * 2 * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+			return;
+		}
+
+		for (uint32_t scope = 0; scope < scopeCount; scope++) {
+			const auto& recorded = frame.scopes[scope];
+			if (!recorded.ended) {
+				continue;
+			}
+			const double milliseconds = addSample(recorded.series, timestamps[scope * 2], timestamps[scope * 2 + 1]);
+			if (scope == frame.frameScope) {
+				frameTime = milliseconds;
+			}
+
+			if (recorded.statistics) {
+				std::array<uint64_t, STATISTICS_COUNT> values{};
+				if (vkGetQueryPoolResults(device.device(), statisticsPool, frameIndex * MAX_SCOPES + scope, 1, sizeof(values), values.data(), sizeof(values), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+					auto& samples = series[recorded.series];
+					samples.hasStatistics = true;
+					samples.statistics = {values[0], values[1], values[2], values[3]};
+				}
+			}
+		}
+	}
+
+	std::vector<GpuProfiler::ScopeReport> GpuProfiler::getReports() const {
+		std::vector<ScopeReport> reports;
+		reports.reserve(series.size());
+
+		std::vector<double> sorted;
+		for (const auto& samples : series) {
+			if (samples.history.empty()) {
+				continue;
+			}
+
+			ScopeReport& report = reports.emplace_back();
+			report.name = samples.name;
+			report.samples = samples.history.size();
+			report.last = samples.history[(samples.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+			report.hasStatistics = samples.hasStatistics;
+			report.statistics = samples.statistics;
+
+			sorted.assign(samples.history.begin(), samples.history.end());
+			std::sort(sorted.begin(), sorted.end());
+			report.min = sorted.front();
+			for (double sample : sorted) {
+				report.average += sample;
+			}
+			report.average /= static_cast<double>(sorted.size());
+			report.p99 = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+		}
+		return reports;
+	}
+
+	bool GpuProfiler::exportCsv(const std::string& filePath) const {
+		std::ofstream file{filePath, std::ios::trunc};
+		if (!file.is_open()) {
+			return false;
+		}
+
+		file << "scope,samples,last_ms,min_ms,avg_ms,p99_ms,vertex_invocations,clipping_primitives,fragment_invocations,compute_invocations\n";
+		for (const auto& report : getReports()) {
+			file << report.name << ',' << report.samples << ',' << report.last << ',' << report.min << ',' << report.average << ',' << report.p99;
+			if (report.hasStatistics) {
+				file << ',' << report.statistics.vertexInvocations << ',' << report.statistics.clippingPrimitives << ',' << report.statistics.fragmentInvocations << ',' << report.statistics.computeInvocations;
+			} else {
+				file << ",,,,";
+			}
+			file << '\n';
+		}
+		return static_cast<bool>(file);
+	}
+} // namespace Aspen
\ No newline at end of file
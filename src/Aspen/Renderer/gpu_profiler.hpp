@@ -0,0 +1,124 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Renderer/device.hpp"
+
+namespace Aspen {
+	// Measures how long the GPU spends on every scope of a frame with timestamp queries, and what it processed with
+	// pipeline statistics queries where the device supports them.
+	//
+	// Every frame in flight has its own range of queries. Renderer::beginFrame() reads a range back after it has waited
+	// for that frame's fence, so results arrive as many frames late as there are frames in flight and never stall. Each
+	// scope keeps a rolling history of its timings, reported as its minimum, average and 99th percentile.
+	class GpuProfiler {
+	public:
+		static constexpr uint32_t MAX_SCOPES = 64;     // Per frame, scopes beyond this are not measured.
+		static constexpr uint32_t HISTORY_SIZE = 240;  // Samples kept per scope.
+		static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+		static constexpr const char* FRAME_SCOPE = "Frame";
+
+		// In the order vkGetQueryPoolResults() writes them, by bit.
+		static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		                                                                     VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		                                                                     VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		                                                                     VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+		struct PipelineStatistics {
+			uint64_t vertexInvocations = 0;
+			uint64_t clippingPrimitives = 0; // Primitives left after clipping.
+			uint64_t fragmentInvocations = 0;
+			uint64_t computeInvocations = 0;
+		};
+
+		// A scope's timings over its history, in milliseconds.
+		struct ScopeReport {
+			std::string name;
+			size_t samples = 0;
+			double last = 0.0;
+			double min = 0.0;
+			double average = 0.0;
+			double p99 = 0.0;
+			bool hasStatistics = false;
+			PipelineStatistics statistics{}; // Of the last sample.
+		};
+
+		GpuProfiler(Device& device);
+		~GpuProfiler();
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+		GpuProfiler(GpuProfiler&&) = delete;            // Move Constructor
+		GpuProfiler& operator=(GpuProfiler&&) = delete; // Move Assignment Operator
+
+		bool isSupported() const {
+			return timestampPool != VK_NULL_HANDLE;
+		}
+
+		// Whether secondary command buffers have to inherit PIPELINE_STATISTICS, see SecondaryCommandBuffers::begin().
+		static bool usesPipelineStatistics(const Device& device);
+
+		// Reads back the results of the last time this frame index was rendered and starts measuring the frame.
+		// The GPU has to be done with the frame, which Renderer::beginFrame() ensures.
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+		void endFrame(VkCommandBuffer commandBuffer);
+
+		// Measures the commands recorded between them, outside of a render pass. Only the outermost scope collects pipeline
+		// statistics, as queries of one type cannot nest. Returns the scope to end, NO_SCOPE if it is not measured.
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// Measures a command buffer the caller waits for right after submitting it, like the acceleration structure builds.
+		// resolveImmediate() reads the result once it has completed.
+		void beginImmediate(VkCommandBuffer commandBuffer);
+		void endImmediate(VkCommandBuffer commandBuffer);
+		void resolveImmediate(const std::string& name);
+
+		// GPU milliseconds of the frame the last beginFrame() read back, 0 if it read none.
+		double getFrameTime() const {
+			return frameTime;
+		}
+
+		// Every scope measured so far, in the order they were first seen.
+		std::vector<ScopeReport> getReports() const;
+		// Writes every scope's report as comma separated values. Returns false if the file cannot be written.
+		bool exportCsv(const std::string& filePath) const;
+
+	private:
+		struct Series {
+			std::string name;
+			std::vector<double> history; // Ring buffer of up to HISTORY_SIZE milliseconds.
+			size_t next = 0;
+			bool hasStatistics = false;
+			PipelineStatistics statistics{};
+		};
+
+		struct RecordedScope {
+			uint32_t series;
+			bool statistics; // Whether it began a pipeline statistics query.
+			bool ended;
+		};
+
+		struct FrameQueries {
+			std::vector<RecordedScope> scopes;
+			uint32_t frameScope = NO_SCOPE;
+		};
+
+		uint32_t getSeries(const std::string& name);
+		double addSample(uint32_t series, uint64_t begin, uint64_t end);
+		void readResults(int frameIndex);
+
+		Device& device;
+		uint64_t timestampMask = ~0ull; // The bits of a timestamp the queue writes.
+
+		// MAX_SCOPES pairs of timestamps and MAX_SCOPES statistics queries per frame index, then the immediate scope's.
+		VkQueryPool timestampPool = VK_NULL_HANDLE;
+		VkQueryPool statisticsPool = VK_NULL_HANDLE; // Null unless the device supports pipeline statistics.
+		std::vector<FrameQueries> frames;
+		int currentFrame = -1;
+		bool statisticsActive = false;
+		double frameTime = 0.0;
+
+		std::vector<Series> series;
+		std::unordered_map<std::string, uint32_t> seriesIndices;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "Aspen/Renderer/light_grid.hpp"
+
+namespace Aspen {
+	void LightGrid::build(const Camera& camera, VkExtent2D extent, const std::vector<glm::vec4>& lights) {
+		const glm::mat4& projection = camera.getProjection();
+		const glm::mat4& view = camera.getView();
+
+		gridSize = glm::uvec3((extent.width + TILE_SIZE - 1) / TILE_SIZE, (extent.height + TILE_SIZE - 1) / TILE_SIZE, DEPTH_SLICES);
+
+		// The near and far plane of the projection, see Camera::setPerspectiveProjection().
+		const float near = -projection[3][2] / projection[2][2];
+		const float far = projection[3][2] / (1.0f - projection[2][2]);
+		const float logRatio = glm::log(far / near);
+		depthParams = glm::vec4(near, far, DEPTH_SLICES / logRatio, -(DEPTH_SLICES * glm::log(near)) / logRatio);
+
+		const uint32_t clusterCount = gridSize.x * gridSize.y * gridSize.z;
+		clusters.assign(clusterCount, glm::uvec2(0));
+		assignments.clear();
+
+		// Tiles along an axis covering the view space interval [low, high] of that axis, between the depths near and far of
+		// a slice. The interval projects furthest out at the near depth for the side away from the axis, at the far depth
+		// for the other, so this covers the whole box. Returns false if it is off screen.
+		const glm::vec2 focalLength{projection[0][0], projection[1][1]};
+		const glm::vec2 tilesPerUnit = 0.5f * glm::vec2(static_cast<float>(extent.width), static_cast<float>(extent.height)) / static_cast<float>(TILE_SIZE);
+		auto tileRange = [&](int axis, float low, float high, float sliceNear, float sliceFar, uint32_t& first, uint32_t& last) {
+			const float ndcLow = focalLength[axis] * low / (low < 0.0f ? sliceNear : sliceFar);
+			const float ndcHigh = focalLength[axis] * high / (high > 0.0f ? sliceNear : sliceFar);
+			if (ndcLow > 1.0f || ndcHigh < -1.0f) {
+				return false;
+			}
+			const float maxTile = static_cast<float>(gridSize[axis] - 1);
+			first = static_cast<uint32_t>(glm::clamp(glm::floor((ndcLow + 1.0f) * tilesPerUnit[axis]), 0.0f, maxTile));
+			last = static_cast<uint32_t>(glm::clamp(glm::floor((ndcHigh + 1.0f) * tilesPerUnit[axis]), 0.0f, maxTile));
+			return true;
+		};
+
+		// Count the lights of every cluster, slice by slice, narrowing the sphere to its cross section within the slice.
+		for (uint32_t light = 0; light < lights.size(); ++light) {
+			const glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(lights[light]), 1.0f));
+			const float radius = lights[light].w;
+			const float minDepth = glm::max(center.z - radius, near);
+			const float maxDepth = glm::min(center.z + radius, far);
+			if (minDepth > maxDepth) {
+				continue;
+			}
+
+			const uint32_t lastSlice = depthSlice(maxDepth);
+			for (uint32_t slice = depthSlice(minDepth); slice <= lastSlice; ++slice) {
+				const float sliceNear = glm::max(sliceDepth(slice), minDepth);
+				const float sliceFar = glm::min(sliceDepth(slice + 1), maxDepth);
+				const float offset = center.z < sliceNear ? sliceNear - center.z : (center.z > sliceFar ? center.z - sliceFar : 0.0f);
+				const float sliceRadius = glm::sqrt(glm::max(radius * radius - offset * offset, 0.0f));
+
+				uint32_t firstX, lastX, firstY, lastY;
+				if (!tileRange(0, center.x - sliceRadius, center.x + sliceRadius, sliceNear, sliceFar, firstX, lastX) ||
+				    !tileRange(1, center.y - sliceRadius, center.y + sliceRadius, sliceNear, sliceFar, firstY, lastY)) {
+					continue;
+				}
+
+				for (uint32_t y = firstY; y <= lastY; ++y) {
+					for (uint32_t x = firstX; x <= lastX; ++x) {
+						const uint32_t cluster = (slice * gridSize.y + y) * gridSize.x + x;
+						assignments.push_back({cluster, light});
+						++clusters[cluster].y;
+					}
+				}
+			}
+		}
+
+		// Give every cluster its range of the index list, then fill the ranges from their ends so the offsets end up at
+		// their starts.
+		stats = {};
+		stats.clusterCount = clusterCount;
+		uint32_t offset = 0;
+		for (auto& cluster : clusters) {
+			offset += cluster.y;
+			cluster.x = offset;
+			stats.occupiedClusters += cluster.y > 0 ? 1 : 0;
+			stats.maxClusterLights = std::max(stats.maxClusterLights, cluster.y);
+		}
+		lightIndices.resize(assignments.size());
+		for (const auto& assignment : assignments) {
+			lightIndices[--clusters[assignment.cluster].x] = assignment.light;
+		}
+		stats.lightIndexCount = static_cast<uint32_t>(lightIndices.size());
+	}
+
+	uint32_t LightGrid::depthSlice(float viewDepth) const {
+		const float slice = glm::floor(glm::log(viewDepth) * depthParams.z + depthParams.w);
+		return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(DEPTH_SLICES - 1)));
+	}
+
+	// View depth where a slice starts, the inverse of depthSlice().
+	float LightGrid::sliceDepth(uint32_t slice) const {
+		return glm::exp((static_cast<float>(slice) - depthParams.w) / depthParams.z);
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "pch.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include "Aspen/Renderer/camera.hpp"
+
+namespace Aspen {
+	// Assigns point lights to the clusters (froxels) of the camera frustum, for clustered forward shading.
+	//
+	// The frustum is cut into TILE_SIZE pixel tiles on screen and DEPTH_SLICES slices in depth, spaced logarithmically so
+	// clusters stay roughly cubic. A light is added to every cluster its sphere of influence overlaps, and a fragment only
+	// shades the lights of its own cluster. Every cluster is an (offset, count) range into one shared list of light indices.
+	class LightGrid {
+	public:
+		static constexpr uint32_t TILE_SIZE = 64;
+		static constexpr uint32_t DEPTH_SLICES = 24;
+
+		struct Stats {
+			uint32_t clusterCount = 0;
+			uint32_t occupiedClusters = 0; // Clusters with at least one light.
+			uint32_t maxClusterLights = 0; // Lights in the busiest cluster.
+			uint32_t lightIndexCount = 0;  // Entries in the light index list.
+		};
+
+		// Rebuilds the grid for the lights' world space spheres of influence, centre (xyz) and radius (w).
+		void build(const Camera& camera, VkExtent2D extent, const std::vector<glm::vec4>& lights);
+
+		// Clusters along x, y and z, and the tile size in pixels (w).
+		glm::uvec4 getGridSize() const {
+			return glm::uvec4(gridSize, TILE_SIZE);
+		}
+		// Near and far plane (xy), then the scale (z) and bias (w) turning the log of a view depth into a slice.
+		glm::vec4 getDepthParams() const {
+			return depthParams;
+		}
+
+		// Offset into getLightIndices() (x) and light count (y) of every cluster, x fastest, then y, then the slice.
+		const std::vector<glm::uvec2>& getClusters() const {
+			return clusters;
+		}
+		const std::vector<uint32_t>& getLightIndices() const {
+			return lightIndices;
+		}
+
+		const Stats& getStats() const {
+			return stats;
+		}
+
+	private:
+		struct Assignment {
+			uint32_t cluster;
+			uint32_t light;
+		};
+
+		uint32_t depthSlice(float viewDepth) const;
+		float sliceDepth(uint32_t slice) const;
+
+		glm::uvec3 gridSize{0};
+		glm::vec4 depthParams{0.0f};
+		std::vector<glm::uvec2> clusters;
+		std::vector<uint32_t> lightIndices;
+		Stats stats{};
+
+		// Kept around so building the grid does not allocate every frame.
+		std::vector<Assignment> assignments;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -1,18 +1,11 @@
 #include "Aspen/Renderer/pipeline.hpp"
 
+#include "Aspen/Core/timer.hpp"
+
 namespace Aspen {
 	VkPipelineShaderStageCreateInfo Pipeline::createShaderModule(const std::string& shaderFilepath, VkShaderStageFlagBits stageType, VkSpecializationInfo* specializationInfo) {
-		auto shaderCode = readFile(shaderFilepath);
-
-		VkShaderModule shaderModule{};
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = shaderCode.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
-
-		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create shader module.");
-		}
+		// Files shared by several pipelines are only read and compiled once.
+		VkShaderModule shaderModule = device.getPipelineCache().getShaderModule(shaderFilepath);
 
 		VkPipelineShaderStageCreateInfo shaderStage;
 		// Setup shader stage for vertex shader.
@@ -29,42 +22,32 @@ namespace Aspen {
 		// do optimizations such as eliminating if statements and loops that depend on these values.
 		shaderStage.pSpecializationInfo = specializationInfo;
 
-		shaderModules.push_back(shaderModule);
 		shaderStages.push_back(shaderStage);
 
 		return shaderStage;
 	}
 
-	std::vector<char> Pipeline::readFile(const std::string& filepath) {
-		// std::string enginePath = ENGINE_DIR + filepath;
-		// ate = Bit flag to make sure we seek to the end of a file when it is opened.
-		// binary = Bit flag to set it to read in the file as a binary to prevent any unwanted text transformations.
-		std::ifstream file{filepath, std::ios::ate | std::ios::binary};
+	void Pipeline::createPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, VkPushConstantRange& pushConstantRange) {
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-		if (!file.is_open()) {
-			throw std::runtime_error("Failed to open file: " + filepath);
+		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline layout!");
 		}
-
-		// Get file size by just getting the last position of the file.
-		// NOTE: This is not actually guaranteed to return the correct data as explained here: https://stackoverflow.com/questions/22984956/tellg-function-give-wrong-size-of-file/22986486#22986486
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		// Read entire file into a char vector the size of the file.
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
-
-		return buffer;
 	}
 
-	void Pipeline::createPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, VkPushConstantRange& pushConstantRange) {
+	// Pipeline layout without push constants.
+	void Pipeline::createPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts) {
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
 		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create pipeline layout!");
@@ -107,10 +90,13 @@ namespace Aspen {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		// Create graphics pipeline.
-		if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		// Create graphics pipeline. Compiled shaders from this or previous runs are reused through the pipeline cache.
+		PipelineCache& pipelineCache = device.getPipelineCache();
+		Timer creationTimer{};
+		if (vkCreateGraphicsPipelines(device.device(), pipelineCache.getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
+		pipelineCache.recordPipelineCreation(creationTimer.elapsedMillis());
 	}
 
 	void Pipeline::createRayTracingPipeline(const RayTracingPipelineConfigInfo& configInfo, VkPipeline& pipeline) {
@@ -134,9 +120,33 @@ namespace Aspen {
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
 		// Create graphics pipeline.
-		if (deviceProcedures.vkCreateRayTracingPipelinesKHR(device.device(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		PipelineCache& pipelineCache = device.getPipelineCache();
+		Timer creationTimer{};
+		if (deviceProcedures.vkCreateRayTracingPipelinesKHR(device.device(), VK_NULL_HANDLE, pipelineCache.getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
+		pipelineCache.recordPipelineCreation(creationTimer.elapsedMillis());
+	}
+
+	void Pipeline::createComputePipeline(VkPipeline& pipeline) {
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: No pipeline layout created");
+		assert(shaderStages.size() == 1 && "Cannot create compute pipeline:: A compute pipeline has exactly one shader stage");
+
+		pipelineType = PipelineType::Compute;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderStages[0];
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		PipelineCache& pipelineCache = device.getPipelineCache();
+		Timer creationTimer{};
+		if (vkCreateComputePipelines(device.device(), pipelineCache.getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create compute pipeline");
+		}
+		pipelineCache.recordPipelineCreation(creationTimer.elapsedMillis());
 	}
 
 	// Bind a command buffer to a graphics pipeline.
@@ -151,6 +161,21 @@ namespace Aspen {
 		} else if (pipelineType == PipelineType::Compute) {
 			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 		}
+		s_PipelineBinds.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Bind descriptor sets starting at firstSet, using this pipeline's layout and bind point.
+	// Sets below firstSet stay bound as long as the previously used layout is compatible with this one up to firstSet.
+	void Pipeline::bindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t firstSet, const std::vector<VkDescriptorSet>& descriptorSets) {
+		VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		if (pipelineType == PipelineType::RayTracing) {
+			bindPoint = VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+		} else if (pipelineType == PipelineType::Compute) {
+			bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+		}
+
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+		s_DescriptorSetBinds.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) {
@@ -2,6 +2,8 @@
 
 #include "Aspen/Core/model.hpp"
 
+#include <atomic>
+
 namespace Aspen {
 	// Data specifying how we want to configure our pipeline.
 	struct PipelineConfigInfo {
@@ -47,12 +49,16 @@ namespace Aspen {
 
 	class Pipeline {
 	public:
+		// Bind calls recorded since the last resetBindStats(). Atomic so passes can be recorded from several threads.
+		struct BindStats {
+			uint32_t pipelineBinds = 0;
+			uint32_t descriptorSetBinds = 0;
+		};
+
 		Pipeline(Device& device)
 		    : device(device), deviceProcedures(device.deviceProcedures()) {}
 		~Pipeline() {
-			for (auto& module : shaderModules) {
-				vkDestroyShaderModule(device.device(), module, nullptr);
-			}
+			// The shader modules belong to the device's PipelineCache, other pipelines may share them.
 			vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
 			vkDestroyPipeline(device.device(), pipeline, nullptr);
 		}
@@ -64,11 +70,14 @@ namespace Aspen {
 		Pipeline& operator=(Pipeline&&) = delete; // Move Assignment Operator
 
 		void bind(VkCommandBuffer commandBuffer, VkPipeline& pipeline);
+		void bindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t firstSet, const std::vector<VkDescriptorSet>& descriptorSets);
 		VkPipelineShaderStageCreateInfo createShaderModule(const std::string& shaderFilepath, VkShaderStageFlagBits stageType, VkSpecializationInfo* specializationInfo = nullptr);
 		void createPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, VkPushConstantRange& pushConstantRange);
+		void createPipelineLayout(std::vector<VkDescriptorSetLayout>& descriptorSetLayouts);
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 		void createGraphicsPipeline(const PipelineConfigInfo& configInfo, VkPipeline& pipeline);
 		void createRayTracingPipeline(const RayTracingPipelineConfigInfo& configInfo, VkPipeline& pipeline);
+		void createComputePipeline(VkPipeline& pipeline);
 		static void defaultRayTracingPipelineConfigInfo(RayTracingPipelineConfigInfo& configInfo);
 
 		VkPipeline& getPipeline() {
@@ -79,13 +88,16 @@ namespace Aspen {
 			return pipelineLayout;
 		}
 
-		std::vector<VkShaderModule>& getShaderModules() {
-			return shaderModules;
+		static BindStats getBindStats() {
+			return {s_PipelineBinds.load(std::memory_order_relaxed), s_DescriptorSetBinds.load(std::memory_order_relaxed)};
 		}
 
-	private:
-		std::vector<char> readFile(const std::string& filepath);
+		static void resetBindStats() {
+			s_PipelineBinds.store(0, std::memory_order_relaxed);
+			s_DescriptorSetBinds.store(0, std::memory_order_relaxed);
+		}
 
+	private:
 		Device& device;
 		// Used for calling extension functions that were manually leaded in DeviceProcedures.
 		DeviceProcedures& deviceProcedures;
@@ -94,11 +106,13 @@ namespace Aspen {
 			Graphics,
 			RayTracing,
 			Compute
-		} pipelineType;
+		} pipelineType = Graphics; // A pipeline that only owns a layout is used for graphics binds.
 
 		VkPipeline pipeline{};
 		VkPipelineLayout pipelineLayout{};
-		std::vector<VkShaderModule> shaderModules{};
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages{};
+
+		inline static std::atomic<uint32_t> s_PipelineBinds = 0;
+		inline static std::atomic<uint32_t> s_DescriptorSetBinds = 0;
 	};
 } // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "Aspen/Renderer/pipeline_cache.hpp"
+
+#include <filesystem>
+
+#include "Aspen/Renderer/device.hpp"
+#include "Aspen/Utils/utils.hpp"
+
+namespace Aspen {
+	PipelineCache::PipelineCache(Device& device, const std::string& filePath)
+	    : device(device), filePath(filePath) {
+		std::vector<char> data = load();
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(device.device(), &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline cache!");
+		}
+
+		stats.warmStart = !data.empty();
+		stats.loadedBytes = data.size();
+	}
+
+	PipelineCache::~PipelineCache() {
+		save();
+
+		for (auto& [hash, module] : shaderModules) {
+			vkDestroyShaderModule(device.device(), module, nullptr);
+		}
+		vkDestroyPipelineCache(device.device(), pipelineCache, nullptr);
+	}
+
+	// Returns the cache data stored on disk, or nothing if there is none or it does not belong to this device and driver.
+	std::vector<char> PipelineCache::load() {
+		std::ifstream file{filePath, std::ios::ate | std::ios::binary};
+		if (!file.is_open()) {
+			return {};
+		}
+
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		if (fileSize < sizeof(FileHeader)) {
+			return {};
+		}
+
+		FileHeader header{};
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+		if (header.magic != FILE_MAGIC || header.driverVersion != device.properties.driverVersion || header.dataSize != fileSize - sizeof(FileHeader)) {
+			std::cout << "Discarding pipeline cache " << filePath << ": written by a different driver or truncated" << std::endl;
+			return {};
+		}
+
+		std::vector<char> data(static_cast<size_t>(header.dataSize));
+		file.read(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file || hashBytes(data.data(), data.size()) != header.dataHash || !isCompatible(data)) {
+			std::cout << "Discarding pipeline cache " << filePath << ": corrupt or written by a different device" << std::endl;
+			return {};
+		}
+
+		return data;
+	}
+
+	// Checks the header every implementation puts in front of its cache data against the device we are running on.
+	// Drivers are required to reject foreign data themselves, but not all of them do so gracefully.
+	bool PipelineCache::isCompatible(const std::vector<char>& data) const {
+		VkPipelineCacheHeaderVersionOne header{};
+		if (data.size() < sizeof(header)) {
+			return false;
+		}
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header) &&
+		       header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		       header.vendorID == device.properties.vendorID &&
+		       header.deviceID == device.properties.deviceID &&
+		       std::memcmp(header.pipelineCacheUUID, device.properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void PipelineCache::save() {
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(device.device(), pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+			return;
+		}
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(device.device(), pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+			return;
+		}
+		data.resize(dataSize);
+
+		FileHeader header{};
+		header.magic = FILE_MAGIC;
+		header.driverVersion = device.properties.driverVersion;
+		header.dataSize = data.size();
+		header.dataHash = hashBytes(data.data(), data.size());
+
+		// Write next to the old file and swap it in, so a crash mid write never leaves a truncated cache behind.
+		std::string tempPath = filePath + ".tmp";
+		{
+			std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+			if (!file.is_open()) {
+				std::cout << "Failed to write pipeline cache " << filePath << std::endl;
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+			file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filePath, error);
+		if (error) {
+			std::cout << "Failed to write pipeline cache " << filePath << ": " << error.message() << std::endl;
+		}
+	}
+
+	VkShaderModule PipelineCache::getShaderModule(const std::string& shaderFilepath) {
+		std::lock_guard<std::mutex> lock{mutex};
+
+		// A file that was loaded before is not read again.
+		auto fileIt = fileHashes.find(shaderFilepath);
+		if (fileIt != fileHashes.end()) {
+			stats.shaderModuleHits++;
+			return shaderModules.at(fileIt->second);
+		}
+
+		std::ifstream file{shaderFilepath, std::ios::ate | std::ios::binary};
+		if (!file.is_open()) {
+			throw std::runtime_error("Failed to open file: " + shaderFilepath);
+		}
+
+		// SPIR-V is a stream of 32-bit words, read it as such so pCode is suitably aligned.
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		std::vector<uint32_t> code((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(fileSize));
+
+		uint64_t hash = hashBytes(code.data(), fileSize);
+		fileHashes[shaderFilepath] = hash;
+
+		// The same SPIR-V under a different path.
+		auto moduleIt = shaderModules.find(hash);
+		if (moduleIt != shaderModules.end()) {
+			stats.shaderModuleHits++;
+			return moduleIt->second;
+		}
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = fileSize;
+		createInfo.pCode = code.data();
+
+		VkShaderModule shaderModule{};
+		if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create shader module.");
+		}
+
+		shaderModules[hash] = shaderModule;
+		stats.shaderModules++;
+		return shaderModule;
+	}
+
+	void PipelineCache::recordPipelineCreation(double milliseconds) {
+		std::lock_guard<std::mutex> lock{mutex};
+		stats.pipelines++;
+		stats.creationTime += milliseconds;
+	}
+
+	PipelineCache::Stats PipelineCache::getStats() {
+		std::lock_guard<std::mutex> lock{mutex};
+		return stats;
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include "pch.h"
+
+#include <mutex>
+
+#include <vulkan/vulkan_core.h>
+
+namespace Aspen {
+	class Device;
+
+	// The process-wide VkPipelineCache, persisted to disk between runs, and the shader modules shared by every pipeline.
+	//
+	// The cache file starts with a small header of our own (its size, a hash of the data and the driver version) followed
+	// by the data vkGetPipelineCacheData() returned. It is only handed back to the driver when both headers match the
+	// device, a stale or truncated file is dropped and the cache starts out cold.
+	// Shader modules are keyed by the hash of their SPIR-V, so a file shared by several pipelines is read and compiled once.
+	class PipelineCache {
+	public:
+		struct Stats {
+			bool warmStart = false;    // The cache was seeded from disk.
+			size_t loadedBytes = 0;    // Size of the data it was seeded with.
+			uint32_t pipelines = 0;    // Pipelines created through the cache.
+			double creationTime = 0.0; // Milliseconds spent in vkCreate*Pipelines.
+			uint32_t shaderModules = 0;
+			uint32_t shaderModuleHits = 0; // Requests served by an existing module.
+		};
+
+		PipelineCache(Device& device, const std::string& filePath);
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+		PipelineCache(PipelineCache&&) = delete;            // Move Constructor
+		PipelineCache& operator=(PipelineCache&&) = delete; // Move Assignment Operator
+
+		VkPipelineCache getPipelineCache() const {
+			return pipelineCache;
+		}
+
+		// Returns the module for a SPIR-V file, creating it on first use. The cache owns the module.
+		// Thread safe, pipelines may be created from several threads.
+		VkShaderModule getShaderModule(const std::string& shaderFilepath);
+
+		void recordPipelineCreation(double milliseconds);
+
+		// Writes the cache to disk. Called on destruction, can be called earlier to survive a crash.
+		void save();
+
+		Stats getStats();
+
+	private:
+		struct FileHeader {
+			uint32_t magic;
+			uint32_t driverVersion;
+			uint64_t dataSize;
+			uint64_t dataHash;
+		};
+		static constexpr uint32_t FILE_MAGIC = 0x43504141; // "AAPC"
+
+		std::vector<char> load();
+		bool isCompatible(const std::vector<char>& data) const;
+
+		Device& device;
+		std::string filePath;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, uint64_t> fileHashes;       // SPIR-V file path -> hash of its contents.
+		std::unordered_map<uint64_t, VkShaderModule> shaderModules; // SPIR-V hash -> module.
+		Stats stats{};
+	};
+} // namespace Aspen
\ No newline at end of file
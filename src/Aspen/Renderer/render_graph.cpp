@@ -0,0 +1,601 @@
+#include "Aspen/Renderer/render_graph.hpp"
+
+namespace Aspen {
+	namespace {
+		constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		                                       VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+		bool hasDepth(VkFormat format) {
+			switch (format) {
+				case VK_FORMAT_D16_UNORM:
+				case VK_FORMAT_X8_D24_UNORM_PACK32:
+				case VK_FORMAT_D32_SFLOAT:
+				case VK_FORMAT_D16_UNORM_S8_UINT:
+				case VK_FORMAT_D24_UNORM_S8_UINT:
+				case VK_FORMAT_D32_SFLOAT_S8_UINT:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		bool hasStencil(VkFormat format) {
+			return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+
+		uint32_t mipLevelCount(const RenderGraph::ImageDesc& desc, VkExtent2D extent) {
+			return desc.mipLevels != 0 ? desc.mipLevels : static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+		}
+	} // namespace
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceHandle resource, const Access& access) {
+		return use(resource, access, true, false);
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceHandle resource, const Access& access) {
+		return use(resource, access, false, true);
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::readWrite(ResourceHandle resource, const Access& access) {
+		return use(resource, access, true, true);
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect() {
+		graph.passes[pass].sideEffect = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::use(ResourceHandle resource, const Access& access, bool read, bool write) {
+		assert(resource < graph.resources.size() && "Pass uses a resource that was not declared.");
+
+		// A pass uses every resource once, so a second declaration widens the first.
+		auto& uses = graph.passes[pass].uses;
+		auto existing = std::find_if(uses.begin(), uses.end(), [resource](const ResourceUse& use) { return use.resource == resource; });
+		if (existing != uses.end()) {
+			assert(existing->access.layout == access.layout && "A pass can only use an image in one layout.");
+			existing->access.stages |= access.stages;
+			existing->access.access |= access.access;
+			existing->read |= read;
+			existing->write |= write;
+			return *this;
+		}
+
+		uses.push_back({resource, access, read, write});
+		return *this;
+	}
+
+	RenderGraph::RenderGraph(Device& device)
+	    : device(device) {
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	}
+
+	RenderGraph::~RenderGraph() {
+		destroyTransientImages();
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::createImage(const std::string& name, const ImageDesc& desc) {
+		Resource resource{};
+		resource.name = name;
+		resource.isImage = true;
+		resource.desc = desc;
+		resources.push_back(resource);
+		return static_cast<ResourceHandle>(resources.size() - 1);
+	}
+
+	RenderGraph::ResourceHandle RenderGraph::importBuffer(const std::string& name) {
+		Resource resource{};
+		resource.name = name;
+		resources.push_back(resource);
+		return static_cast<ResourceHandle>(resources.size() - 1);
+	}
+
+	RenderGraph::PassHandle RenderGraph::addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup) {
+		Pass pass{};
+		pass.name = name;
+		passes.push_back(pass);
+
+		const auto handle = static_cast<PassHandle>(passes.size() - 1);
+		PassBuilder builder{*this, handle};
+		setup(builder);
+		return handle;
+	}
+
+	void RenderGraph::bake(VkExtent2D swapChainExtent) {
+		destroyTransientImages();
+		orderPasses();
+		createTransientImages(swapChainExtent);
+	}
+
+	// Passes depend on the earlier passes that touch the same resources, so the declaration order is always valid.
+	// Within that, every pass is scheduled as late as the passes consuming its results allow, which keeps the transient
+	// images short lived and lets more of them share memory.
+	void RenderGraph::orderPasses() {
+		const size_t passCount = passes.size();
+		std::vector<std::vector<PassHandle>> dependencies(passCount);
+		std::vector<uint32_t> dependentCounts(passCount, 0);
+
+		{
+			std::vector<PassHandle> lastWriters(resources.size(), UINT32_MAX);
+			std::vector<std::vector<PassHandle>> readers(resources.size()); // Readers since the last write.
+
+			auto addDependency = [&](PassHandle pass, PassHandle dependency) {
+				if (dependency == UINT32_MAX || dependency == pass) {
+					return;
+				}
+				auto& passDependencies = dependencies[pass];
+				if (std::find(passDependencies.begin(), passDependencies.end(), dependency) == passDependencies.end()) {
+					passDependencies.push_back(dependency);
+					++dependentCounts[dependency];
+				}
+			};
+
+			for (PassHandle pass = 0; pass < passCount; ++pass) {
+				for (const auto& use : passes[pass].uses) {
+					addDependency(pass, lastWriters[use.resource]);
+					if (use.write) {
+						for (PassHandle reader : readers[use.resource]) {
+							addDependency(pass, reader);
+						}
+						lastWriters[use.resource] = pass;
+						readers[use.resource].clear();
+					} else {
+						readers[use.resource].push_back(pass);
+					}
+				}
+			}
+		}
+
+		// Schedule backwards: a pass is ready once everything depending on it is placed. Ties go to the pass declared last.
+		order.clear();
+		std::vector<PassHandle> ready;
+		for (PassHandle pass = 0; pass < passCount; ++pass) {
+			if (dependentCounts[pass] == 0) {
+				ready.push_back(pass);
+			}
+		}
+		while (!ready.empty()) {
+			auto latest = std::max_element(ready.begin(), ready.end());
+			const PassHandle pass = *latest;
+			ready.erase(latest);
+			order.push_back(pass);
+
+			for (PassHandle dependency : dependencies[pass]) {
+				if (--dependentCounts[dependency] == 0) {
+					ready.push_back(dependency);
+				}
+			}
+		}
+		assert(order.size() == passCount && "Render graph has a dependency cycle.");
+		std::reverse(order.begin(), order.end());
+
+		for (auto& resource : resources) {
+			resource.firstUse = UINT32_MAX;
+			resource.lastUse = 0;
+		}
+		for (uint32_t position = 0; position < order.size(); ++position) {
+			for (const auto& use : passes[order[position]].uses) {
+				auto& resource = resources[use.resource];
+				resource.firstUse = std::min(resource.firstUse, position);
+				resource.lastUse = std::max(resource.lastUse, position);
+			}
+		}
+	}
+
+	void RenderGraph::createTransientImages(VkExtent2D swapChainExtent) {
+		std::vector<ResourceHandle> images;
+		for (ResourceHandle handle = 0; handle < resources.size(); ++handle) {
+			auto& resource = resources[handle];
+			if (!resource.isImage) {
+				continue;
+			}
+			images.push_back(handle);
+
+			const auto& desc = resource.desc;
+			resource.image.format = desc.format;
+			resource.image.extent = desc.swapChainSized ? swapChainExtent : desc.extent;
+			if (desc.powerOfTwo) {
+				resource.image.extent.width = std::bit_floor(std::max(resource.image.extent.width, 1u));
+				resource.image.extent.height = std::bit_floor(std::max(resource.image.extent.height, 1u));
+			}
+			const uint32_t mipLevels = mipLevelCount(desc, resource.image.extent);
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.flags = desc.flags;
+			imageInfo.format = desc.format;
+			imageInfo.extent = {resource.image.extent.width, resource.image.extent.height, 1};
+			imageInfo.mipLevels = mipLevels;
+			imageInfo.arrayLayers = desc.layerCount;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = desc.usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			if (vkCreateImage(device.device(), &imageInfo, nullptr, &resource.image.image) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create render graph image " + resource.name + "!");
+			}
+			vkGetImageMemoryRequirements(device.device(), resource.image.image, &resource.memoryRequirements);
+		}
+
+		// Place the largest images first, each into the first block whose images are all used at other times.
+		// Images are always bound at offset 0, so a block is as large as its largest image.
+		std::sort(images.begin(), images.end(), [this](ResourceHandle a, ResourceHandle b) {
+			return resources[a].memoryRequirements.size > resources[b].memoryRequirements.size;
+		});
+
+		auto overlaps = [this](ResourceHandle a, ResourceHandle b) {
+			const auto& first = resources[a];
+			const auto& second = resources[b];
+			// An image no pass uses never shares its memory, nor does one whose contents outlive the frame.
+			if (first.firstUse == UINT32_MAX || second.firstUse == UINT32_MAX || first.desc.persistent || second.desc.persistent) {
+				return true;
+			}
+			return first.firstUse <= second.lastUse && second.firstUse <= first.lastUse;
+		};
+
+		stats.transientMemoryUnaliased = 0;
+		for (ResourceHandle handle : images) {
+			const auto& requirements = resources[handle].memoryRequirements;
+			stats.transientMemoryUnaliased += requirements.size;
+
+			auto block = std::find_if(memoryBlocks.begin(), memoryBlocks.end(), [&](const MemoryBlock& block) {
+				return (block.memoryTypeBits & requirements.memoryTypeBits) != 0 &&
+				       std::none_of(block.images.begin(), block.images.end(), [&](ResourceHandle other) { return overlaps(handle, other); });
+			});
+			if (block == memoryBlocks.end()) {
+				memoryBlocks.emplace_back();
+				block = std::prev(memoryBlocks.end());
+			}
+			block->size = std::max(block->size, requirements.size);
+			block->memoryTypeBits &= requirements.memoryTypeBits;
+			block->images.push_back(handle);
+			resources[handle].syncIndex = static_cast<uint32_t>(std::distance(memoryBlocks.begin(), block));
+		}
+
+		stats.transientMemory = 0;
+		for (auto& block : memoryBlocks) {
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = block.size;
+			allocInfo.memoryTypeIndex = device.findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			if (vkAllocateMemory(device.device(), &allocInfo, nullptr, &block.memory) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate render graph memory!");
+			}
+			stats.transientMemory += block.size;
+
+			for (ResourceHandle handle : block.images) {
+				if (vkBindImageMemory(device.device(), resources[handle].image.image, block.memory, 0) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to bind render graph image memory!");
+				}
+			}
+		}
+
+		// Buffers follow the memory blocks in the sync states.
+		syncStates.assign(memoryBlocks.size(), {});
+		for (auto& resource : resources) {
+			if (!resource.isImage) {
+				resource.syncIndex = static_cast<uint32_t>(syncStates.size());
+				syncStates.emplace_back();
+			}
+		}
+
+		for (ResourceHandle handle : images) {
+			auto& resource = resources[handle];
+			const auto& desc = resource.desc;
+
+			VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			if (hasDepth(desc.format) || hasStencil(desc.format)) {
+				aspectMask = (hasDepth(desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : 0) | (hasStencil(desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+			}
+			const uint32_t mipLevels = mipLevelCount(desc, resource.image.extent);
+			resource.image.subresourceRange = {aspectMask, 0, mipLevels, 0, desc.layerCount};
+
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = resource.image.image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			if (desc.layerCount == 6 && (desc.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT)) {
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+			} else if (desc.layerCount > 1) {
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+			}
+			viewInfo.format = desc.viewFormat != VK_FORMAT_UNDEFINED ? desc.viewFormat : desc.format;
+			viewInfo.subresourceRange = resource.image.subresourceRange;
+			if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.image.view) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create render graph image view " + resource.name + "!");
+			}
+
+			if (desc.layerViews) {
+				resource.image.layerViews.resize(desc.layerCount);
+				for (uint32_t layer = 0; layer < desc.layerCount; ++layer) {
+					viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+					viewInfo.subresourceRange.baseArrayLayer = layer;
+					viewInfo.subresourceRange.layerCount = 1;
+					if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.image.layerViews[layer]) != VK_SUCCESS) {
+						throw std::runtime_error("Failed to create render graph image view " + resource.name + "!");
+					}
+				}
+			}
+
+			if (desc.mipViews) {
+				viewInfo.subresourceRange = resource.image.subresourceRange;
+				resource.image.mipViews.resize(mipLevels);
+				for (uint32_t level = 0; level < mipLevels; ++level) {
+					viewInfo.subresourceRange.baseMipLevel = level;
+					viewInfo.subresourceRange.levelCount = 1;
+					if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.image.mipViews[level]) != VK_SUCCESS) {
+						throw std::runtime_error("Failed to create render graph image view " + resource.name + "!");
+					}
+				}
+			}
+
+			if ((desc.usage & VK_IMAGE_USAGE_SAMPLED_BIT) && hasDepth(desc.format) && hasStencil(desc.format)) {
+				viewInfo.subresourceRange = resource.image.subresourceRange;
+				viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+				if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.image.depthView) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create render graph image view " + resource.name + "!");
+				}
+			}
+
+			resource.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+	}
+
+	void RenderGraph::destroyTransientImages() {
+		for (auto& resource : resources) {
+			if (resource.isImage && resource.image.image != VK_NULL_HANDLE) {
+				for (VkImageView layerView : resource.image.layerViews) {
+					vkDestroyImageView(device.device(), layerView, nullptr);
+				}
+				resource.image.layerViews.clear();
+				for (VkImageView mipView : resource.image.mipViews) {
+					vkDestroyImageView(device.device(), mipView, nullptr);
+				}
+				resource.image.mipViews.clear();
+				if (resource.image.depthView != VK_NULL_HANDLE) {
+					vkDestroyImageView(device.device(), resource.image.depthView, nullptr);
+					resource.image.depthView = VK_NULL_HANDLE;
+				}
+				vkDestroyImageView(device.device(), resource.image.view, nullptr);
+				vkDestroyImage(device.device(), resource.image.image, nullptr);
+				resource.image.view = VK_NULL_HANDLE;
+				resource.image.image = VK_NULL_HANDLE;
+			}
+		}
+		for (auto& block : memoryBlocks) {
+			vkFreeMemory(device.device(), block.memory, nullptr);
+		}
+		memoryBlocks.clear();
+	}
+
+	void RenderGraph::setPassEnabled(PassHandle pass, bool enabled) {
+		passes[pass].enabled = enabled;
+	}
+
+	void RenderGraph::setExecute(PassHandle pass, std::function<void(VkCommandBuffer)> execute) {
+		passes[pass].execute = std::move(execute);
+	}
+
+	void RenderGraph::requestOutput(ResourceHandle resource, const Access& access) {
+		resources[resource].requested = true;
+		resources[resource].outputAccess = access;
+	}
+
+	// Walk the passes backwards, keeping track of the resources a later pass (or the frame's outputs) still needs.
+	void RenderGraph::compile() {
+		std::vector<bool> needed(resources.size(), false);
+		for (ResourceHandle handle = 0; handle < resources.size(); ++handle) {
+			needed[handle] = resources[handle].requested;
+		}
+
+		stats.livePasses = 0;
+		stats.culledPasses = 0;
+		for (auto it = order.rbegin(); it != order.rend(); ++it) {
+			auto& pass = passes[*it];
+			pass.live = pass.enabled && (pass.sideEffect || std::any_of(pass.uses.begin(), pass.uses.end(), [&](const ResourceUse& use) {
+				            return use.write && needed[use.resource];
+			            }));
+
+			if (!pass.live) {
+				++stats.culledPasses;
+				continue;
+			}
+			++stats.livePasses;
+
+			// Whatever the pass overwrites is no longer needed from earlier passes, whatever it reads is.
+			for (const auto& use : pass.uses) {
+				if (use.write && !use.read) {
+					needed[use.resource] = false;
+				}
+			}
+			for (const auto& use : pass.uses) {
+				if (use.read) {
+					needed[use.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler) {
+		stats.barrierBatches = 0;
+		stats.imageBarriers = 0;
+		stats.memoryBarriers = 0;
+
+		// Transient images do not keep their contents from one frame to the next, persistent ones stay in their last layout.
+		for (auto& resource : resources) {
+			resource.writtenThisFrame = false;
+			if (resource.isImage && !resource.desc.persistent) {
+				resource.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+		}
+
+		for (PassHandle handle : order) {
+			auto& pass = passes[handle];
+			if (!pass.live) {
+				continue;
+			}
+
+			for (const auto& use : pass.uses) {
+				addBarriers(use);
+			}
+			flushBarriers(commandBuffer);
+
+			if (pass.execute) {
+				const uint32_t scope = profiler ? profiler->beginScope(commandBuffer, pass.name) : GpuProfiler::NO_SCOPE;
+				pass.execute(commandBuffer);
+				if (profiler) {
+					profiler->endScope(commandBuffer, scope);
+				}
+			}
+		}
+
+		// Make the requested outputs visible to whoever reads them after the frame.
+		for (auto& resource : resources) {
+			const auto& sync = syncStates[resource.syncIndex];
+			if (resource.requested && resource.outputAccess.stages != 0 && sync.writeStages != 0) {
+				srcStages |= sync.writeStages;
+				dstStages |= resource.outputAccess.stages;
+				memoryBarrier.srcAccessMask |= sync.writeAccess;
+				memoryBarrier.dstAccessMask |= resource.outputAccess.access;
+			}
+			resource.requested = false;
+		}
+		flushBarriers(commandBuffer);
+
+		// The callbacks usually reference the frame's locals.
+		for (auto& pass : passes) {
+			pass.execute = nullptr;
+		}
+	}
+
+	void RenderGraph::addBarriers(const ResourceUse& use) {
+		auto& resource = resources[use.resource];
+		auto& sync = syncStates[resource.syncIndex];
+
+		// Nothing wrote the image this frame (its writer is disabled), so there is nothing to wait for or read.
+		// A persistent image still holds what was written in an earlier frame.
+		const bool discard = resource.isImage && !resource.desc.persistent && !resource.writtenThisFrame;
+		if (discard && !use.write) {
+			return;
+		}
+
+		const VkImageLayout oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : resource.layout;
+		const bool transition = resource.isImage && use.access.layout != VK_IMAGE_LAYOUT_UNDEFINED && use.access.layout != oldLayout;
+
+		VkPipelineStageFlags waitStages = 0;
+		VkAccessFlags waitAccess = 0;
+		if (use.write || transition) {
+			// Writes and layout transitions wait for every earlier access, including those to an aliased image.
+			waitStages = sync.writeStages | sync.readStages;
+			waitAccess = sync.writeAccess;
+		} else if ((use.access.stages & ~sync.readStages) != 0) {
+			// Reads wait for the last write, unless an earlier read in the same stages already did.
+			waitStages = sync.writeStages;
+			waitAccess = sync.writeAccess;
+		}
+
+		if (transition) {
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = waitAccess;
+			barrier.dstAccessMask = use.access.access;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = use.access.layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = resource.image.image;
+			barrier.subresourceRange = resource.image.subresourceRange;
+			imageBarriers.push_back(barrier);
+
+			srcStages |= waitStages != 0 ? waitStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			dstStages |= use.access.stages;
+		} else if (waitStages != 0) {
+			// Write-after-read only needs the execution dependency.
+			if (waitAccess != 0) {
+				memoryBarrier.srcAccessMask |= waitAccess;
+				memoryBarrier.dstAccessMask |= use.access.access;
+			}
+			srcStages |= waitStages;
+			dstStages |= use.access.stages;
+		}
+
+		if (use.write) {
+			sync.writeStages = use.access.stages;
+			sync.writeAccess = use.access.access & WRITE_ACCESS;
+			sync.readStages = 0;
+			resource.writtenThisFrame = true;
+		} else if (transition) {
+			// Later readers in other stages have to wait for the transition as well.
+			sync.writeStages |= use.access.stages;
+			sync.readStages = use.access.stages;
+		} else {
+			sync.readStages |= use.access.stages;
+		}
+
+		if (resource.isImage) {
+			if (use.access.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
+				resource.layout = use.access.finalLayout;
+			} else if (use.access.layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+				resource.layout = use.access.layout;
+			}
+		}
+	}
+
+	void RenderGraph::flushBarriers(VkCommandBuffer commandBuffer) {
+		if (srcStages == 0) {
+			return;
+		}
+
+		const bool hasMemoryBarrier = memoryBarrier.srcAccessMask != 0;
+		vkCmdPipelineBarrier(
+		    commandBuffer,
+		    srcStages,
+		    dstStages,
+		    0,
+		    hasMemoryBarrier ? 1 : 0,
+		    &memoryBarrier,
+		    0,
+		    nullptr,
+		    static_cast<uint32_t>(imageBarriers.size()),
+		    imageBarriers.data());
+
+		++stats.barrierBatches;
+		stats.imageBarriers += static_cast<uint32_t>(imageBarriers.size());
+		stats.memoryBarriers += hasMemoryBarrier ? 1 : 0;
+
+		srcStages = 0;
+		dstStages = 0;
+		memoryBarrier.srcAccessMask = 0;
+		memoryBarrier.dstAccessMask = 0;
+		imageBarriers.clear();
+	}
+
+	RenderGraph::Access RenderGraph::colorAttachment(VkImageLayout layout, VkImageLayout finalLayout) {
+		return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, layout, finalLayout};
+	}
+
+	RenderGraph::Access RenderGraph::depthAttachment(VkImageLayout layout, VkImageLayout finalLayout) {
+		return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, layout, finalLayout};
+	}
+
+	RenderGraph::Access RenderGraph::sampledImage(VkPipelineStageFlags stages, VkImageLayout layout) {
+		return {stages, VK_ACCESS_SHADER_READ_BIT, layout};
+	}
+
+	RenderGraph::Access RenderGraph::storageImage(VkPipelineStageFlags stages, VkAccessFlags access) {
+		return {stages, access, VK_IMAGE_LAYOUT_GENERAL};
+	}
+
+	RenderGraph::Access RenderGraph::transferSource() {
+		return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+	}
+
+	RenderGraph::Access RenderGraph::transferDestination() {
+		return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+	}
+
+	RenderGraph::Access RenderGraph::buffer(VkPipelineStageFlags stages, VkAccessFlags access) {
+		return {stages, access};
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,196 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Renderer/device.hpp"
+#include "Aspen/Renderer/gpu_profiler.hpp"
+
+namespace Aspen {
+	// Orders the passes of a frame, places the barriers between them and owns the transient images they render into.
+	//
+	// Resources and passes, with the resources each pass reads and writes, are declared once and then baked: the passes are
+	// ordered and transient images whose lifetimes do not overlap are bound to the same memory. Every frame passes can be
+	// switched off and outputs requested. compile() culls the passes nobody consumes and execute() records the rest,
+	// with the barriers each pass needs batched into a single vkCmdPipelineBarrier.
+	class RenderGraph {
+	public:
+		using ResourceHandle = uint32_t;
+		using PassHandle = uint32_t;
+
+		// How a pass uses a resource.
+		struct Access {
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags access = 0;
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;      // Layout the pass expects, UNDEFINED when it discards the contents (and for buffers).
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED; // Layout the pass' render pass leaves the image in, UNDEFINED if it stays in layout.
+		};
+
+		// An image created and owned by the graph. Transient unless persistent is set.
+		struct ImageDesc {
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkFormat viewFormat = VK_FORMAT_UNDEFINED; // Defaults to format.
+			VkExtent2D extent{};                       // Only used when the image is not sized to the swap chain.
+			bool swapChainSized = true;
+			bool powerOfTwo = false;                   // Rounds the size down to a power of two, so every mip level is exactly half the one above.
+			uint32_t layerCount = 1;
+			uint32_t mipLevels = 1; // 0 for a full mip chain.
+			VkImageUsageFlags usage = 0;
+			VkImageCreateFlags flags = 0;
+			bool persistent = false; // Keeps its contents from one frame to the next (until the next bake), so it is never aliased.
+			bool layerViews = false; // Also create a 2D view of every layer, e.g. to render into the faces of a cube map one at a time.
+			bool mipViews = false;   // Also create a view of every mip level, e.g. to write them one at a time from a compute shader.
+		};
+
+		struct Image {
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkFormat format = VK_FORMAT_UNDEFINED;
+			VkExtent2D extent{};
+			VkImageSubresourceRange subresourceRange{};
+			std::vector<VkImageView> layerViews; // Only if ImageDesc::layerViews is set.
+			std::vector<VkImageView> mipViews;   // Only if ImageDesc::mipViews is set.
+			VkImageView depthView = VK_NULL_HANDLE; // Depth aspect alone of a sampled depth/stencil image, the part shaders can sample.
+		};
+
+		struct Stats {
+			uint32_t livePasses = 0;
+			uint32_t culledPasses = 0;
+			uint32_t barrierBatches = 0; // vkCmdPipelineBarrier calls.
+			uint32_t imageBarriers = 0;
+			uint32_t memoryBarriers = 0;
+			VkDeviceSize transientMemory = 0;         // Bytes allocated for the graph's images, persistent ones included.
+			VkDeviceSize transientMemoryUnaliased = 0; // Bytes they would take with their own allocations.
+		};
+
+		class PassBuilder {
+		public:
+			PassBuilder& read(ResourceHandle resource, const Access& access);
+			PassBuilder& write(ResourceHandle resource, const Access& access);
+			PassBuilder& readWrite(ResourceHandle resource, const Access& access);
+			// The pass has effects outside the graph (e.g. presenting), so it is never culled.
+			PassBuilder& sideEffect();
+
+		private:
+			friend class RenderGraph;
+			PassBuilder(RenderGraph& graph, PassHandle pass)
+			    : graph(graph), pass(pass) {}
+
+			PassBuilder& use(ResourceHandle resource, const Access& access, bool read, bool write);
+
+			RenderGraph& graph;
+			PassHandle pass;
+		};
+
+		RenderGraph(Device& device);
+		~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+		RenderGraph(RenderGraph&&) = delete;            // Move Constructor
+		RenderGraph& operator=(RenderGraph&&) = delete; // Move Assignment Operator
+
+		// Declaration, before bake().
+		ResourceHandle createImage(const std::string& name, const ImageDesc& desc);
+		ResourceHandle importBuffer(const std::string& name); // Only synchronized, the graph never touches the buffer itself.
+		PassHandle addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup);
+
+		// Orders the passes and creates the images, the swap chain sized ones at the given extent (the renderer's target
+		// extent). bake() again when it grows to recreate them, persistent images lose their contents.
+		void bake(VkExtent2D swapChainExtent);
+
+		// Per frame.
+		void setPassEnabled(PassHandle pass, bool enabled);
+		void setExecute(PassHandle pass, std::function<void(VkCommandBuffer)> execute);
+		void requestOutput(ResourceHandle resource, const Access& access = {}); // Keeps the resource's writers alive this frame, access is the consumer after the frame (e.g. a host read).
+		void compile();
+		bool isPassLive(PassHandle pass) const {
+			return passes[pass].live;
+		}
+		// Measures every pass it records under the pass name if given a profiler.
+		void execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler = nullptr);
+
+		const Image& getImage(ResourceHandle resource) const {
+			return resources[resource].image;
+		}
+
+		const Stats& getStats() const {
+			return stats;
+		}
+
+		// Common accesses.
+		static Access colorAttachment(VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		static Access depthAttachment(VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+		static Access sampledImage(VkPipelineStageFlags stages, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		static Access storageImage(VkPipelineStageFlags stages, VkAccessFlags access);
+		static Access transferSource();
+		static Access transferDestination();
+		static Access buffer(VkPipelineStageFlags stages, VkAccessFlags access);
+
+	private:
+		struct ResourceUse {
+			ResourceHandle resource;
+			Access access;
+			bool read = false;
+			bool write = false;
+		};
+
+		struct Pass {
+			std::string name;
+			std::vector<ResourceUse> uses;
+			bool sideEffect = false;
+			bool enabled = true;
+			bool live = false;
+			std::function<void(VkCommandBuffer)> execute;
+		};
+
+		// The last accesses to a piece of memory. Aliased images share one, so the first user of a block waits for the previous one.
+		struct SyncState {
+			VkPipelineStageFlags writeStages = 0;
+			VkAccessFlags writeAccess = 0;
+			VkPipelineStageFlags readStages = 0; // Stages that read since the last write, they already wait for it.
+		};
+
+		struct Resource {
+			std::string name;
+			bool isImage = false;
+			ImageDesc desc{};
+			Image image{};
+			VkMemoryRequirements memoryRequirements{};
+			uint32_t firstUse = UINT32_MAX; // Positions in the baked order.
+			uint32_t lastUse = 0;
+			uint32_t syncIndex = 0;
+
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			bool writtenThisFrame = false;
+			bool requested = false;
+			Access outputAccess{};
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			uint32_t memoryTypeBits = ~0u;
+			std::vector<ResourceHandle> images;
+		};
+
+		void orderPasses();
+		void createTransientImages(VkExtent2D swapChainExtent);
+		void destroyTransientImages();
+		void addBarriers(const ResourceUse& use);
+		void flushBarriers(VkCommandBuffer commandBuffer);
+
+		Device& device;
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<PassHandle> order; // Passes in execution order.
+		std::vector<MemoryBlock> memoryBlocks;
+		std::vector<SyncState> syncStates;
+
+		// Barriers of the pass being executed.
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		VkMemoryBarrier memoryBarrier{};
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+
+		Stats stats{};
+	};
+} // namespace Aspen
\ No newline at end of file
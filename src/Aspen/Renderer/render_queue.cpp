@@ -0,0 +1,75 @@
+#include "Aspen/Renderer/render_queue.hpp"
+
+namespace Aspen {
+	uint64_t SortKey::make(uint32_t mesh, uint32_t depth) {
+		auto field = [](uint32_t value, uint32_t bits) {
+			return static_cast<uint64_t>(std::min(value, (1u << bits) - 1));
+		};
+
+		return (field(mesh, MESH_BITS) << DEPTH_BITS) | field(depth, DEPTH_BITS);
+	}
+
+	uint32_t SortKey::quantizeDepth(float depth, float maxDepth) {
+		constexpr float maxValue = static_cast<float>((1u << DEPTH_BITS) - 1);
+		if (maxDepth <= 0.0f) {
+			return 0;
+		}
+		return static_cast<uint32_t>(std::clamp(depth / maxDepth, 0.0f, 1.0f) * maxValue);
+	}
+
+	void RenderQueue::sort() {
+		if (packets.size() < 2) {
+			return;
+		}
+
+		// Gather the histograms of all eight key bytes in a single pass.
+		std::array<std::array<uint32_t, 256>, sizeof(uint64_t)> histograms{};
+		for (const auto& packet : packets) {
+			for (uint32_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+				++histograms[byte][(packet.sortKey >> (8 * byte)) & 0xFF];
+			}
+		}
+
+		scratch.resize(packets.size());
+		for (uint32_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+			auto& histogram = histograms[byte];
+			const uint32_t shift = 8 * byte;
+
+			// Every key has the same value in this byte, so the pass would not move anything.
+			if (histogram[(packets.front().sortKey >> shift) & 0xFF] == packets.size()) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (auto& count : histogram) {
+				const uint32_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (const auto& packet : packets) {
+				scratch[histogram[(packet.sortKey >> shift) & 0xFF]++] = packet;
+			}
+			packets.swap(scratch);
+		}
+	}
+
+	void BindState::bindGeometry(VkCommandBuffer commandBuffer, VkBuffer vertices, VkBuffer indices) {
+		if (vertices == vertexBuffer) {
+			++skippedBinds;
+		} else {
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices, &offset);
+			vertexBuffer = vertices;
+			++recordedBinds;
+		}
+
+		if (indices == indexBuffer) {
+			++skippedBinds;
+		} else {
+			vkCmdBindIndexBuffer(commandBuffer, indices, 0, VK_INDEX_TYPE_UINT32);
+			indexBuffer = indices;
+			++recordedBinds;
+		}
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "pch.h"
+
+#include <vulkan/vulkan_core.h>
+
+namespace Aspen {
+	// Packed draw sort key. The mesh is stored above the quantised depth, so sorting the keys groups draws by mesh
+	// and orders each group front to back.
+	// There is no pipeline or material field: every scene pass draws all instances with a single pipeline and materials
+	// are read per instance from a storage buffer, so the only state that changes between draws is the geometry.
+	struct SortKey {
+		static constexpr uint32_t MESH_BITS = 24;
+		static constexpr uint32_t DEPTH_BITS = 24;
+		static_assert(MESH_BITS + DEPTH_BITS <= 64);
+
+		// Fields wider than their bit count are clamped, which only costs sort quality.
+		static uint64_t make(uint32_t mesh, uint32_t depth);
+
+		// Maps a distance in [0, maxDepth] to the depth field, closer distances sort first.
+		static uint32_t quantizeDepth(float depth, float maxDepth);
+	};
+
+	struct DrawPacket {
+		uint64_t sortKey;
+		uint32_t index; // Caller defined, usually the position of the draw's source data.
+	};
+
+	// Collects draw packets and radix sorts them by key. The storage is kept between frames so filling the queue does not allocate.
+	// The key bytes above the used fields are the same for every packet and skipped by the sort.
+	class RenderQueue {
+	public:
+		void clear() {
+			packets.clear();
+		}
+
+		void reserve(size_t count) {
+			packets.reserve(count);
+			scratch.reserve(count);
+		}
+
+		void push(uint64_t sortKey, uint32_t index) {
+			packets.push_back({sortKey, index});
+		}
+
+		// Stable LSD radix sort over the key bytes. Bytes that are identical in every key are skipped.
+		void sort();
+
+		const std::vector<DrawPacket>& getPackets() const {
+			return packets;
+		}
+
+	private:
+		std::vector<DrawPacket> packets;
+		std::vector<DrawPacket> scratch;
+	};
+
+	// Geometry buffers last bound on a command buffer, used to skip binds that would not change anything.
+	// Pipelines and descriptor sets are bound once per pass, so geometry is the only per draw state to filter.
+	// Valid for one command buffer only, anything binding vertex or index buffers on it has to go through here.
+	struct BindState {
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		uint32_t recordedBinds = 0;
+		uint32_t skippedBinds = 0;
+
+		void bindGeometry(VkCommandBuffer commandBuffer, VkBuffer vertices, VkBuffer indices);
+	};
+} // namespace Aspen
\ No newline at end of file
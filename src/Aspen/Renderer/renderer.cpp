@@ -1,11 +1,15 @@
 #include "Aspen/Renderer/renderer.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 
 	Renderer::Renderer(Window& window, Device& device, const int desiredPresentMode)
 	    : window{window}, device{device}, desiredPresentMode(desiredPresentMode) {
 		recreateSwapChain();
+		fitTargetExtent();
 		createCommandBuffers();
+		profiler = std::make_unique<GpuProfiler>(device);
 	}
 
 	Renderer::~Renderer() {
@@ -38,14 +42,13 @@ namespace Aspen {
 	}
 
 	void Renderer::recreateSwapChain() {
+		ASPEN_PROFILE_SCOPE("Renderer::recreateSwapChain");
 		auto extent = window.getExtent();
 		while (extent.width == 0 || extent.height == 0) { // While the window is minimized...
 			extent = window.getExtent();
 			glfwWaitEvents(); // While one of the windows dimensions is 0 (e.g. during minimization), wait until otherwise.
 		}
 
-		vkDeviceWaitIdle(device.device()); // Wait until the current swapchain is no longer being used.
-
 		if (swapChain == nullptr) {
 			swapChain = std::make_unique<SwapChain>(device, extent, desiredPresentMode); // Create new swapchain with new extents.
 		} else {
@@ -58,17 +61,51 @@ namespace Aspen {
 			if (!oldSwapChain->compareSwapFormats(*swapChain)) {
 				throw std::runtime_error("Swap chain image(or depth) format has changed!");
 			}
+
+			// The frames in flight may still use its images and framebuffers.
+			retiredSwapChains.push_back({std::move(oldSwapChain), submittedFrames});
 		}
 
+		updateRenderExtent();
+
 		// If Render Pass is compatible there is no need to create a new pipeline.
 		// TODO: Check if new and old render passes are compatible.
 	}
 
+	bool Renderer::fitTargetExtent() {
+		auto roundUp = [](uint32_t size) { return (size + TARGET_BUCKET - 1) / TARGET_BUCKET * TARGET_BUCKET; };
+		const VkExtent2D swapChainExtent = swapChain->getSwapChainExtent();
+		const VkExtent2D fitted{
+		    std::max(targetExtent.width, roundUp(swapChainExtent.width)),
+		    std::max(targetExtent.height, roundUp(swapChainExtent.height)),
+		};
+		if (fitted.width == targetExtent.width && fitted.height == targetExtent.height) {
+			return false;
+		}
+
+		targetExtent = fitted;
+		updateRenderExtent();
+		return true;
+	}
+
+	// Clamped to the targets, the swap chain may have grown past them before the application fitted them again.
+	void Renderer::updateRenderExtent() {
+		const VkExtent2D extent = dynamicResolution.getRenderExtent(swapChain->getSwapChainExtent());
+		renderExtent = {std::min(extent.width, targetExtent.width), std::min(extent.height, targetExtent.height)};
+	}
+
+	// acquireNextImage() waited for the last frame with the current index. Once every index was waited for since a swap
+	// chain was replaced, nothing submitted to it is still running.
+	void Renderer::releaseRetiredSwapChains() {
+		std::erase_if(retiredSwapChains, [&](const RetiredSwapChain& retired) { return submittedFrames + 1 >= retired.frame + framesInFlight; });
+	}
+
 	// beginFrame will start recording the current command buffer and check that the current frame buffer is still valid.
 	VkCommandBuffer Renderer::beginFrame() {
+		ASPEN_PROFILE_SCOPE("Renderer::beginFrame");
 		assert(!isFrameStarted && "Cannot call beginFrame while it is already in progress!");
 
-		auto result = swapChain->acquireNextImage(&currentImageIndex); // Get the index of the frame buffer to render to next.
+		auto result = swapChain->acquireNextImage(currentFrameIndex, &currentImageIndex); // Get the index of the frame buffer to render to next.
 
 		// Recreate swapchain if window was resized.
 		// VK_ERROR_OUT_OF_DATE_KHR occurs when the surface is no longer compatible with the swapchain (e.g. after window is resized).
@@ -84,6 +121,8 @@ namespace Aspen {
 		}
 
 		isFrameStarted = true;
+		updatePacing();
+		releaseRetiredSwapChains();
 
 		// Start command buffer recording.
 		auto* commandBuffer = getCurrentCommandBuffer();
@@ -96,15 +135,24 @@ namespace Aspen {
 			throw std::runtime_error("Failed to begin recording command buffer.");
 		}
 
+		// The fence acquireNextImage() waited for covers the queries this frame index wrote last time.
+		profiler->beginFrame(commandBuffer, currentFrameIndex);
+
+		// The frame read back was recorded framesInFlight frames ago, so the frames in between still show the old scale.
+		dynamicResolution.update(profiler->getFrameTime(), framesInFlight - 1);
+		updateRenderExtent();
+
 		return commandBuffer;
 	}
 
 	// End from will stop recording the current command buffer and submit it to the render queue.
 	void Renderer::endFrame() {
+		ASPEN_PROFILE_SCOPE("Renderer::endFrame");
 		assert(isFrameStarted && "Can't call endFrame while frame is not in progress!");
 
 		// Stop command buffer recording.
 		auto* commandBuffer = getCurrentCommandBuffer();
+		profiler->endFrame(commandBuffer);
 
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to record command buffer.");
@@ -113,7 +161,8 @@ namespace Aspen {
 		// Submit command buffer.
 		// Vulkan is going to go off and execute the commands in this command buffer
 		// to output that information to the selected frame buffer.
-		auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, currentFrameIndex);
+		submittedFrames++;
 
 		// Check again if window was resized during command buffer recording/submitting and recreate swapchain if so.
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasWindowResized()) {
@@ -124,7 +173,49 @@ namespace Aspen {
 		}
 
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT; // Increment currentFrameIndex.
+		previousFrameIndex = currentFrameIndex;
+		currentFrameIndex = (currentFrameIndex + 1) % framesInFlight; // Increment currentFrameIndex.
+	}
+
+	void Renderer::setFramesInFlight(int count) {
+		assert(!isFrameStarted && "Cannot change the frames in flight while a frame is in progress!");
+		count = std::clamp(count, 2, SwapChain::MAX_FRAMES_IN_FLIGHT);
+		if (count == framesInFlight) {
+			return;
+		}
+
+		// Every frame's resources are free once the GPU is idle. The next frame still follows the previous one, so
+		// whatever reads the previous frame's results finds them.
+		vkDeviceWaitIdle(device.device());
+		retiredSwapChains.clear();
+		framesInFlight = count;
+		currentFrameIndex = (previousFrameIndex + 1) % framesInFlight;
+	}
+
+	void Renderer::updatePacing() {
+		const auto frameStart = std::chrono::steady_clock::now();
+		if (lastFrameStart != std::chrono::steady_clock::time_point{}) {
+			const size_t slot = pacingSamples++ % PACING_HISTORY;
+			frameTimes[slot] = std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count();
+			fenceWaits[slot] = swapChain->takeFenceWaitTime();
+
+			const size_t count = std::min(pacingSamples, PACING_HISTORY);
+			double frameTimeSum = 0.0;
+			double fenceWaitSum = 0.0;
+			for (size_t i = 0; i < count; ++i) {
+				frameTimeSum += frameTimes[i];
+				fenceWaitSum += fenceWaits[i];
+			}
+			pacing.frameTime = frameTimeSum / static_cast<double>(count);
+			pacing.fenceWait = fenceWaitSum / static_cast<double>(count);
+
+			double variance = 0.0;
+			for (size_t i = 0; i < count; ++i) {
+				variance += (frameTimes[i] - pacing.frameTime) * (frameTimes[i] - pacing.frameTime);
+			}
+			pacing.frameTimeDeviation = std::sqrt(variance / static_cast<double>(count));
+		}
+		lastFrameStart = frameStart;
 	}
 
 	// Special function for rendering to the screen.
@@ -154,7 +245,7 @@ namespace Aspen {
 	}
 
 	// beginSwapChainRenderPass will start the render pass in order to then record commands to it.
-	void Renderer::beginRenderPass(VkCommandBuffer commandBuffer, RenderInfo renderInfo) {
+	void Renderer::beginRenderPass(VkCommandBuffer commandBuffer, RenderInfo renderInfo, VkSubpassContents contents) {
 		assert(isFrameStarted && "Can't call beginRenderPass if frame is not in progress!");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Cannot begin render pass on command buffer from a different frame.");
 
@@ -184,10 +275,13 @@ namespace Aspen {
 		// commands we want to execute will come from secondary command buffers. This
 		// means we cannot mix command types and have a primary command buffer that
 		// has both inline commands and secondary command buffers.
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
-		vkCmdSetViewport(commandBuffer, 0, 1, &renderInfo.viewport);
-		vkCmdSetScissor(commandBuffer, 0, 1, &renderInfo.scissorDimensions);
+		// Secondary command buffers set their own dynamic state, see SecondaryCommandBuffers::begin().
+		if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+			vkCmdSetViewport(commandBuffer, 0, 1, &renderInfo.viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &renderInfo.scissorDimensions);
+		}
 	}
 
 	// End the render pass when commands have been recorded.
@@ -1,11 +1,23 @@
 #pragma once
 
+#include "Aspen/Renderer/dynamic_resolution.hpp"
+#include "Aspen/Renderer/gpu_profiler.hpp"
 #include "Aspen/Renderer/swap_chain.hpp"
 #include "Aspen/Renderer/frame_info.hpp"
 
 namespace Aspen {
 	class Renderer {
 	public:
+		static constexpr size_t PACING_HISTORY = 120;
+		static constexpr uint32_t TARGET_BUCKET = 256; // The target extent is a multiple of it.
+
+		// Rolling over the last PACING_HISTORY frames, in milliseconds.
+		struct FramePacing {
+			double frameTime = 0.0;          // Between the starts of consecutive frames.
+			double frameTimeDeviation = 0.0; // Standard deviation of the frame time.
+			double fenceWait = 0.0;          // The CPU spent waiting for the GPU to release a frame.
+		};
+
 		Renderer(Window& window, Device& device, const int desiredPresentMode);
 		~Renderer();
 
@@ -56,30 +68,95 @@ namespace Aspen {
 			return currentFrameIndex;
 		}
 
+		// The index the frame before the current one was recorded with.
+		int getPreviousFrameIndex() const {
+			return previousFrameIndex;
+		}
+
+		int getFramesInFlight() const {
+			return framesInFlight;
+		}
+
+		const FramePacing& getFramePacing() const {
+			return pacing;
+		}
+
+		// Measures the GPU time of every frame, and of the scopes recorded into it.
+		GpuProfiler& getProfiler() {
+			return *profiler;
+		}
+
+		// Picks the render extent from the GPU frame time at the start of every frame.
+		DynamicResolution& getDynamicResolution() {
+			return dynamicResolution;
+		}
+
+		// The size of the offscreen targets. It only grows, so a smaller window renders into their top left corner.
+		VkExtent2D getTargetExtent() const {
+			return targetExtent;
+		}
+
+		// The top left part of the offscreen targets the scene is rendered to this frame.
+		VkExtent2D getRenderExtent() const {
+			return renderExtent;
+		}
+
 		void setDesiredPresentMode(int mode) {
 			desiredPresentMode = mode;
 		}
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginRenderPass(VkCommandBuffer commandBuffer, RenderInfo renderInfo);
+		void beginRenderPass(VkCommandBuffer commandBuffer, RenderInfo renderInfo, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void beginPresentRenderPass(VkCommandBuffer commandBuffer);
 		void endRenderPass(VkCommandBuffer commandBuffer) const;
+		// The old swap chain is kept until the frames submitted to it are done, nothing waits for the device to go idle.
 		void recreateSwapChain();
+		// Grows the target extent to hold the swap chain extent, rounded up to TARGET_BUCKET. Returns true if it grew, the
+		// offscreen targets must then be recreated at the new size.
+		bool fitTargetExtent();
+		// Waits for every frame in flight, before destroying resources they may use.
+		void waitForFrames() {
+			swapChain->waitForFrames();
+		}
+		// Between 2 and SwapChain::MAX_FRAMES_IN_FLIGHT. Waits for the GPU to go idle.
+		void setFramesInFlight(int count);
 
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
+		void updatePacing();
+		void updateRenderExtent();
+		void releaseRetiredSwapChains();
 
 		Window& window;
 		Device& device;
 		std::unique_ptr<SwapChain> swapChain;
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::unique_ptr<GpuProfiler> profiler;
+		DynamicResolution dynamicResolution{};
+		VkExtent2D targetExtent{};
+		VkExtent2D renderExtent{};
+
+		struct RetiredSwapChain {
+			std::shared_ptr<SwapChain> swapChain;
+			uint64_t frame; // Frames submitted when it was replaced.
+		};
+		std::vector<RetiredSwapChain> retiredSwapChains{};
+		uint64_t submittedFrames = 0;
 
 		uint32_t currentImageIndex{};
+		int framesInFlight{2};
 		int currentFrameIndex{0};
+		int previousFrameIndex{framesInFlight - 1};
 		bool isFrameStarted{false};
 
+		FramePacing pacing{};
+		std::array<double, PACING_HISTORY> frameTimes{};
+		std::array<double, PACING_HISTORY> fenceWaits{};
+		size_t pacingSamples = 0;
+		std::chrono::steady_clock::time_point lastFrameStart{};
+
 		int desiredPresentMode = 1;
 	};
 } // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "Aspen/Renderer/secondary_command_buffers.hpp"
+
+#include "Aspen/Renderer/gpu_profiler.hpp"
+#include "Aspen/Renderer/swap_chain.hpp"
+
+namespace Aspen {
+	SecondaryCommandBuffers::SecondaryCommandBuffers(Device& device, uint32_t threadCount)
+	    : device(device), threadCount(threadCount), framePools(SwapChain::MAX_FRAMES_IN_FLIGHT) {
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // Reset as a whole every frame.
+
+		for (auto& pools : framePools) {
+			pools.resize(threadCount);
+			for (auto& pool : pools) {
+				if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create secondary command pool!");
+				}
+			}
+		}
+	}
+
+	SecondaryCommandBuffers::~SecondaryCommandBuffers() {
+		// Destroying a pool frees its command buffers.
+		for (auto& pools : framePools) {
+			for (auto& pool : pools) {
+				vkDestroyCommandPool(device.device(), pool.commandPool, nullptr);
+			}
+		}
+	}
+
+	void SecondaryCommandBuffers::reset(int frameIndex) {
+		for (auto& pool : framePools[frameIndex]) {
+			vkResetCommandPool(device.device(), pool.commandPool, 0);
+			pool.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer SecondaryCommandBuffers::begin(int frameIndex, uint32_t threadIndex, const RenderInfo& renderInfo) {
+		auto& pool = framePools[frameIndex][threadIndex];
+		if (pool.usedCount == pool.commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = pool.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate secondary command buffer.");
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+		// The render pass and framebuffer the secondary command buffer will be executed in.
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderInfo.renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = renderInfo.framebuffer;
+		if (GpuProfiler::usesPipelineStatistics(device)) {
+			inheritanceInfo.pipelineStatistics = GpuProfiler::PIPELINE_STATISTICS; // Executed inside the profiler's scopes.
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to begin recording secondary command buffer.");
+		}
+
+		// Dynamic state is not inherited from the primary command buffer.
+		vkCmdSetViewport(commandBuffer, 0, 1, &renderInfo.viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &renderInfo.scissorDimensions);
+
+		return commandBuffer;
+	}
+
+	void SecondaryCommandBuffers::end(VkCommandBuffer commandBuffer) {
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to record secondary command buffer.");
+		}
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Renderer/device.hpp"
+#include "Aspen/Renderer/frame_info.hpp"
+
+namespace Aspen {
+	// Secondary command buffers for recording render passes from several threads.
+	// A command pool may only be used by one thread at a time, so every thread gets its own pool per frame in flight.
+	class SecondaryCommandBuffers {
+	public:
+		SecondaryCommandBuffers(Device& device, uint32_t threadCount);
+		~SecondaryCommandBuffers();
+
+		SecondaryCommandBuffers(const SecondaryCommandBuffers&) = delete;
+		SecondaryCommandBuffers& operator=(const SecondaryCommandBuffers&) = delete;
+		SecondaryCommandBuffers(SecondaryCommandBuffers&&) = delete;            // Move Constructor
+		SecondaryCommandBuffers& operator=(SecondaryCommandBuffers&&) = delete; // Move Assignment Operator
+
+		// Recycles every command buffer of the frame. The GPU has to be done with the frame, which Renderer::beginFrame() ensures.
+		void reset(int frameIndex);
+
+		// Begins a command buffer that continues renderInfo's render pass, with the viewport and scissor already set.
+		// Must only be called from the thread owning threadIndex.
+		VkCommandBuffer begin(int frameIndex, uint32_t threadIndex, const RenderInfo& renderInfo);
+		void end(VkCommandBuffer commandBuffer);
+
+		uint32_t getThreadCount() const {
+			return threadCount;
+		}
+
+	private:
+		struct ThreadCommandPool {
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers; // Allocated so far, reused every time the frame comes around.
+			uint32_t usedCount = 0;
+		};
+
+		Device& device;
+		uint32_t threadCount;
+		std::vector<std::vector<ThreadCommandPool>> framePools; // Indexed by frame, then by thread.
+	};
+} // namespace Aspen
\ No newline at end of file
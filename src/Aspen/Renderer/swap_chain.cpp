@@ -1,5 +1,7 @@
 #include "Aspen/Renderer/swap_chain.hpp"
 
+#include "Aspen/Core/cpu_profiler.hpp"
+
 namespace Aspen {
 
 	SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent, const int desiredPresentMode)
@@ -11,7 +13,7 @@ namespace Aspen {
 	    : device{deviceRef}, windowExtent{extent}, oldSwapChain{std::move(previous)}, desiredPresentMode(desiredPresentMode) {
 		init();
 
-		// Clean up old swap chain since it's no longer being used. Setting to nullptr will signify the system to release its resources.
+		// The previous swap chain may still be in use by frames in flight, whoever passed it in releases it once they are done.
 		oldSwapChain = nullptr;
 	}
 
@@ -54,36 +56,54 @@ namespace Aspen {
 		vkDestroyRenderPass(device.device(), presentRenderPass, nullptr);
 
 		// Cleanup synchronization objects.
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-			vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-			vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+		for (auto* semaphore : renderFinishedSemaphores) {
+			vkDestroySemaphore(device.device(), semaphore, nullptr);
+		}
+		// Empty if a newer swap chain took them over.
+		for (auto* semaphore : imageAvailableSemaphores) {
+			vkDestroySemaphore(device.device(), semaphore, nullptr);
+		}
+		for (auto* fence : inFlightFences) {
+			vkDestroyFence(device.device(), fence, nullptr);
 		}
 	}
 
 	// Get the next available image in the swap chain to use for rendering operations.
-	VkResult SwapChain::acquireNextImage(uint32_t* imageIndex) {
-		vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	VkResult SwapChain::acquireNextImage(int frameIndex, uint32_t* imageIndex) {
+		ASPEN_PROFILE_SCOPE("SwapChain::acquireNextImage");
+		// Waits for the frame that last used this index, otherwise the CPU runs ahead of the GPU.
+		const auto waitStart = std::chrono::steady_clock::now();
+		vkWaitForFences(device.device(), 1, &inFlightFences[frameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		fenceWaitTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
 
 		VkResult result =
 		    vkAcquireNextImageKHR(device.device(),
 		                          swapChain,
 		                          std::numeric_limits<uint64_t>::max(),   // The max amount of time to wait in nanoseconds for an image to become available. Max of uint64_t disables this timeout.
-		                          imageAvailableSemaphores[currentFrame], // Semaphore to be signaled when the image is ready to be rendered to. Must be a not signaled semaphore.
+		                          imageAvailableSemaphores[frameIndex],   // Semaphore to be signaled when the image is ready to be rendered to. Must be a not signaled semaphore.
 		                          VK_NULL_HANDLE,                         // Can also specify a fence if required.
 		                          imageIndex);                            // The index of the swap chain image that has become available.
 
 		return result;
 	}
 
-	VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex) {
+	void SwapChain::waitForFrames() {
+		ASPEN_PROFILE_SCOPE("SwapChain::waitForFrames");
+		const auto waitStart = std::chrono::steady_clock::now();
+		vkWaitForFences(device.device(), static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+		fenceWaitTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+
+	VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex, int frameIndex) {
+		ASPEN_PROFILE_SCOPE("SwapChain::submitCommandBuffers");
 		// If the current image is in flight, wait for that image's fence to be signaled so we don't send more frames than desired.
 		if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-			// std::cout << "waiting for fence of image " << imageIndex << std::endl;
+			const auto waitStart = std::chrono::steady_clock::now();
 			vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX); // VK_TRUE means it will wait for all fences in the array to be signaled.
+			fenceWaitTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
 		}
 		// Associate an available fence to the current image.
-		imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+		imagesInFlight[*imageIndex] = inFlightFences[frameIndex];
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -91,7 +111,7 @@ namespace Aspen {
 		// Specify the semaphore to wait on before execution begins and in which stage of the pipeline to wait.
 		// In this case, we are saying to wait on semaphore x in the pipeline stage where writing to the image is performed until the image is ready.
 		// This theoretically means that we can still perform other stages of the pipeline such as the vertex shader while the image is not yet available.
-		VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
+		VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[frameIndex]};
 		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 		submitInfo.waitSemaphoreCount = 1;
 		submitInfo.pWaitSemaphores = waitSemaphores;
@@ -102,14 +122,15 @@ namespace Aspen {
 		submitInfo.pCommandBuffers = buffers;
 
 		// Specify the semaphore to signal once execution of the command buffer has completed.
-		VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+		// One per image rather than per frame, as nothing tells when a presentation is done waiting on it.
+		VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[*imageIndex]};
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		vkResetFences(device.device(), 1, &inFlightFences[currentFrame]); // Restore fences from signaled to unsignaled state.
+		vkResetFences(device.device(), 1, &inFlightFences[frameIndex]); // Restore fences from signaled to unsignaled state.
 		// Submit command buffer to the graphics queue.
 		// We also pass in a fence to signal when the command buffer being submitted has finished executing.
-		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[frameIndex]) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to submit draw command buffer!");
 		}
 
@@ -128,14 +149,8 @@ namespace Aspen {
 		presentInfo.pImageIndices = imageIndex; // The index of the image to present.
 		presentInfo.pResults = nullptr;         // Optional
 
-		vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max()); // Prevents stuttering for some reason...
-		// vkQueueWaitIdle(device.presentQueue());                                                                            // Prevents stuttering for some reason...
-
-		auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo); // Send image to be presented to the display.
-
-		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT; // Advance to the next frame.
-
-		return result;
+		// No wait for the frame here, the CPU records the next frame while the GPU executes this one.
+		return vkQueuePresentKHR(device.presentQueue(), &presentInfo); // Send image to be presented to the display.
 	}
 
 	// Creates the swap chain.
@@ -446,10 +461,10 @@ namespace Aspen {
 	}
 
 	// Create semaphores and fences for every frame.
+	// The per frame ones are taken over from the previous swap chain, as frames submitted to it may still be in flight and
+	// the next use of their frame index has to wait for them.
 	void SwapChain::createSyncObjects() {
-		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		renderFinishedSemaphores.resize(imageCount());
 		imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -459,11 +474,25 @@ namespace Aspen {
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Start all fences as signaled.
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-			if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-			    vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-			    vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-				throw std::runtime_error("Failed to create synchronization objects for a frame!");
+		if (oldSwapChain != nullptr) {
+			imageAvailableSemaphores = std::move(oldSwapChain->imageAvailableSemaphores);
+			inFlightFences = std::move(oldSwapChain->inFlightFences);
+			oldSwapChain->imageAvailableSemaphores.clear();
+			oldSwapChain->inFlightFences.clear();
+			fenceWaitTime = oldSwapChain->takeFenceWaitTime();
+		} else {
+			imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+			inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+			for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+				if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+				    vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create synchronization objects for a frame!");
+				}
+			}
+		}
+		for (auto& semaphore : renderFinishedSemaphores) {
+			if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create synchronization objects for a swap chain image!");
 			}
 		}
 	}
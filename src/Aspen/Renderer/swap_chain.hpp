@@ -7,7 +7,8 @@ namespace Aspen {
 
 	class SwapChain {
 	public:
-		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+		// Per frame resources are created for this many frames, Renderer::setFramesInFlight() picks how many are used.
+		static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 
 		SwapChain(Device& deviceRef, VkExtent2D windowExtent, const int desiredPresentMode);
 		SwapChain(Device& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous, const int desiredPresentMode);
@@ -50,8 +51,16 @@ namespace Aspen {
 			return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
 		}
 
-		VkResult acquireNextImage(uint32_t* imageIndex);
-		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex);
+		// The frame index is the renderer's, so the fence waited for here guards that frame's resources.
+		VkResult acquireNextImage(int frameIndex, uint32_t* imageIndex);
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, const uint32_t* imageIndex, int frameIndex);
+		// Waits for every submitted frame, without stalling the rest of the device.
+		void waitForFrames();
+
+		// Milliseconds the CPU waited for the GPU to release a frame or a swap chain image since the last call.
+		double takeFenceWaitTime() {
+			return std::exchange(fenceWaitTime, 0.0);
+		}
 
 		bool compareSwapFormats(const SwapChain& swapChain) const {
 			return swapChain.swapChainDepthFormat == swapChainDepthFormat && swapChain.swapChainImageFormat == swapChainImageFormat;
@@ -96,10 +105,10 @@ namespace Aspen {
 		std::shared_ptr<SwapChain> oldSwapChain{};
 
 		std::vector<VkSemaphore> imageAvailableSemaphores{};
-		std::vector<VkSemaphore> renderFinishedSemaphores{};
+		std::vector<VkSemaphore> renderFinishedSemaphores{}; // Per swap chain image, the presentation of an image waits on it.
 		std::vector<VkFence> inFlightFences{};
 		std::vector<VkFence> imagesInFlight{};
-		size_t currentFrame = 0;
+		double fenceWaitTime = 0.0;
 	};
 
 } // namespace Aspen
@@ -23,6 +23,11 @@ namespace Aspen {
 	}
 
 	void Texture::destroy() {
+		// Nothing was ever loaded into this texture (e.g. a mesh without a texture).
+		if (device == nullptr) {
+			return;
+		}
+
 		vkDestroyImageView(device->device(), view, nullptr);
 		vkDestroyImage(device->device(), image, nullptr);
 		if (sampler) {
@@ -43,6 +48,11 @@ namespace Aspen {
 		}
 	}
 
+	void Texture::freeImage(ImageProperties& imageProps) {
+		stbi_image_free(imageProps.pixels);
+		imageProps.pixels = nullptr;
+	}
+
 	/**
 	 * Load a 2D texture including all mip levels
 	 *
@@ -59,9 +69,17 @@ namespace Aspen {
 		ImageProperties imageProps{};
 		loadImage(filename, imageProps);
 
+		loadFromImage(device, std::move(filename), imageProps, format, copyQueue, imageUsageFlags, imageLayout, forceLinear);
+
+		freeImage(imageProps);
+	}
+
+	// Uploads an image that was already decoded with loadImage(), e.g. on another thread. The caller keeps ownership of the pixels.
+	void Texture2D::loadFromImage(Device* device, std::string filename, const ImageProperties& imageProps, VkFormat format, VkQueue copyQueue, VkImageUsageFlags imageUsageFlags, VkImageLayout imageLayout, bool forceLinear) {
 		assert(imageProps.pixels != nullptr);
 
 		this->device = device;
+		filePath = filename;
 		width = imageProps.texWidth;
 		height = imageProps.texHeight;
 		mipLevels = 1;
@@ -250,9 +268,6 @@ namespace Aspen {
 			// device->flushCommandBuffer(copyCmd, copyQueue);
 		}
 
-		// Free the image.
-		stbi_image_free(imageProps.pixels);
-
 		// Create image view
 		// Textures are not directly accessed by the shaders and are abstracted by image views containing additional information and sub resource ranges.
 		VkImageViewCreateInfo viewCreateInfo = {};
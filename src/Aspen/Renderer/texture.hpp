@@ -18,22 +18,25 @@ namespace Aspen {
 
 	class Texture {
 	public:
-		Device* device;
-		VkImage image;
+		Device* device = nullptr;
+		VkImage image = VK_NULL_HANDLE;
 		VkImageLayout imageLayout;
-		VkDeviceMemory deviceMemory;
-		VkImageView view;
+		VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
 		uint32_t width, height;
 		uint32_t mipLevels;
 		uint32_t layerCount;
 		VkDescriptorImageInfo descriptor;
-		VkSampler sampler;
+		VkSampler sampler = VK_NULL_HANDLE;
 		bool isTextureLoaded = false;
+		std::string filePath;
 
 		~Texture();
 		void updateDescriptor();
 		void destroy();
-		void loadImage(std::string fileName, ImageProperties& imageProps);
+		// Decodes an image file into RGBA8 pixels. Only touches imageProps, so it may be called from any thread.
+		static void loadImage(std::string fileName, ImageProperties& imageProps);
+		static void freeImage(ImageProperties& imageProps);
 	};
 
 	class Texture2D : public Texture {
@@ -46,6 +49,15 @@ namespace Aspen {
 		    VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 		    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 		    bool forceLinear = false);
+		void loadFromImage(
+		    Device* device,
+		    std::string filename,
+		    const ImageProperties& imageProps,
+		    VkFormat format,
+		    VkQueue copyQueue,
+		    VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+		    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		    bool forceLinear = false);
 		void fromBuffer(
 		    Device* device,
 		    void* buffer,
@@ -3,6 +3,7 @@
 #include "Aspen/Renderer/texture.hpp"
 #include "Aspen/Renderer/camera.hpp"
 #include "Aspen/Core/uuid.hpp"
+#include "Aspen/Math/bvh.hpp"
 
 namespace Aspen {
 
@@ -10,15 +11,26 @@ namespace Aspen {
 		UUID id;
 		IDComponent() = default;
 		IDComponent(const IDComponent&) = default;
+
+		IDComponent(UUID id)
+		    : id(id){};
 	};
 
 	struct TagComponent {
 		std::string tag;
+		const std::string* interned = nullptr; // Tag shared through the scene's tag table, avoids a string per entity.
 		TagComponent() = default;
 		TagComponent(const TagComponent&) = default;
 
 		TagComponent(std::string tag)
 		    : tag(std::move(tag)){};
+
+		TagComponent(const std::string* interned)
+		    : interned(interned){};
+
+		const std::string& getTag() const {
+			return interned ? *interned : tag;
+		}
 	};
 
 	struct TransformComponent {
@@ -119,13 +131,24 @@ namespace Aspen {
 			}
 		};
 
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
-		std::unique_ptr<Buffer> vertexBuffer;
-		std::unique_ptr<Buffer> indexBuffer;
+		// The shape of a mesh. Entities rendering the same mesh share one geometry instead of each holding a copy.
+		struct Geometry {
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			std::string assetPath;  // Empty for procedural meshes.
+			uint64_t assetHash = 0; // Content hash of the source file (or of the geometry for procedural meshes).
+			std::unique_ptr<Buffer> vertexBuffer;
+			std::unique_ptr<Buffer> indexBuffer;
+			Math::BVH bvh; // Object space triangle BVH used for CPU ray queries.
+		};
+
+		std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>();
 		Texture2D texture; // TODO: I need to design a better way to associate textures with objects.
 
 		MeshComponent() = default;
+
+		MeshComponent(std::shared_ptr<Geometry> geometry)
+		    : geometry(std::move(geometry)){};
 	};
 
 	struct alignas(16) MaterialComponent {
@@ -183,9 +206,23 @@ namespace Aspen {
 		CameraControllerArcball(const CameraControllerArcball&) = default;
 	};
 
+	// Spins the entity around an axis every update. Used to drive dynamic transforms in generated scenes.
+	struct SpinComponent {
+		glm::vec3 axis{0.0f, -1.0f, 0.0f};
+		float angularSpeed = 1.0f; // Radians per second.
+	};
+
 	struct PointLightComponent {
+		static constexpr float MIN_IRRADIANCE = 0.01f; // Intensity over distance squared below which a light no longer contributes.
+
 		float lightIntensity = 1.0f;
 		glm::vec3 color{1.0f};
+
+		// Distance at which the light falls off to MIN_IRRADIANCE. Shading fades it out to nothing there.
+		float influenceRadius() const {
+			const float brightness = lightIntensity * glm::max(color.r, glm::max(color.g, color.b));
+			return glm::sqrt(glm::max(brightness, 0.0f) / MIN_IRRADIANCE);
+		}
 	};
 
 	struct RigidBody2dComponent {
@@ -0,0 +1,67 @@
+#include "Aspen/Scene/entity_command_buffer.hpp"
+
+#include "Aspen/Scene/entity.hpp"
+
+namespace Aspen {
+	EntityCommandBuffer::~EntityCommandBuffer() {
+		clear();
+	}
+
+	EntityCommandBuffer::EntityRef EntityCommandBuffer::createEntity(std::string_view name) {
+		// Copy the name into the arena so recording does not allocate a std::string per entity.
+		char* nameCopy = nullptr;
+		if (!name.empty()) {
+			nameCopy = static_cast<char*>(arena.allocate(name.size(), alignof(char)));
+			std::memcpy(nameCopy, name.data(), name.size());
+		}
+
+		EntityRef entity{};
+		entity.deferredIndex = deferredCount++;
+		push<CreateCommand>(entity, std::string_view(nameCopy, name.size()));
+
+		return entity;
+	}
+
+	void EntityCommandBuffer::destroyEntity(EntityRef entity) {
+		push<DestroyCommand>(entity);
+	}
+
+	void EntityCommandBuffer::playback(Scene& scene) {
+		createdEntities.resize(deferredCount, entt::null);
+
+		for (Command* command = head; command != nullptr; command = command->next) {
+			if (command->createsEntity()) {
+				auto* createCommand = static_cast<CreateCommand*>(command);
+				createdEntities[command->target.deferredIndex] = scene.createEntity(std::string(createCommand->name)).getEntity();
+				continue;
+			}
+
+			entt::entity entity = command->target.isDeferred() ? createdEntities[command->target.deferredIndex] : command->target.entity;
+
+			// The entity may have been destroyed by an earlier command (in this or another buffer).
+			if (!scene.m_Registry.valid(entity)) {
+				continue;
+			}
+
+			command->execute(scene.m_Registry, entity);
+		}
+
+		clear();
+	}
+
+	void EntityCommandBuffer::clear() {
+		// Payloads may own resources (e.g. GPU buffers in a MeshComponent that was never played back), so run their destructors.
+		for (Command* command = head; command != nullptr;) {
+			Command* next = command->next;
+			command->~Command();
+			command = next;
+		}
+
+		head = nullptr;
+		tail = nullptr;
+		commandCount = 0;
+		deferredCount = 0;
+		createdEntities.clear();
+		arena.reset();
+	}
+} // namespace Aspen
\ No newline at end of file
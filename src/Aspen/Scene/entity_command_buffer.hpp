@@ -0,0 +1,137 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Scene/scene.hpp"
+#include "Aspen/Utils/linear_arena.hpp"
+
+#include <string_view>
+
+namespace Aspen {
+	// Records structural changes (create, destroy, emplace, remove) so they can be applied to the scene later from the main thread.
+	// A command buffer must only be written to by one thread at a time, use Scene::getCommandBuffer() to get one per worker.
+	// Commands and their payloads live in a linear arena which is recycled after every playback.
+	class EntityCommandBuffer {
+	public:
+		// Refers to either an existing entity or one created earlier in this command buffer (which does not exist until playback).
+		struct EntityRef {
+			EntityRef() = default;
+			EntityRef(entt::entity entity)
+			    : entity(entity){};
+
+			entt::entity entity = entt::null;
+			uint32_t deferredIndex = std::numeric_limits<uint32_t>::max();
+
+			bool isDeferred() const {
+				return deferredIndex != std::numeric_limits<uint32_t>::max();
+			}
+		};
+
+		EntityCommandBuffer() = default;
+		~EntityCommandBuffer();
+
+		EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+		EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+		EntityCommandBuffer(EntityCommandBuffer&&) = delete;            // Move Constructor
+		EntityCommandBuffer& operator=(EntityCommandBuffer&&) = delete; // Move Assignment Operator
+
+		EntityRef createEntity(std::string_view name = {});
+		void destroyEntity(EntityRef entity);
+
+		// Adds the component, or replaces it if the entity already has one by the time the buffer is played back.
+		template <typename T, typename... Args>
+		void emplace(EntityRef entity, Args&&... args) {
+			push<EmplaceCommand<T>>(entity, std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		void remove(EntityRef entity) {
+			push<RemoveCommand<T>>(entity);
+		}
+
+		// Applies every recorded command to the scene in the order they were recorded, then clears the buffer.
+		void playback(Scene& scene);
+		void clear();
+
+		bool empty() const {
+			return commandCount == 0;
+		}
+
+		uint32_t size() const {
+			return commandCount;
+		}
+
+	private:
+		struct Command {
+			EntityRef target;
+			Command* next = nullptr;
+
+			Command(EntityRef target)
+			    : target(target){};
+			virtual ~Command() = default;
+			virtual void execute(entt::registry& registry, entt::entity entity) = 0;
+			virtual bool createsEntity() const {
+				return false;
+			}
+		};
+
+		struct CreateCommand : Command {
+			std::string_view name; // Points into the arena.
+
+			CreateCommand(EntityRef target, std::string_view name)
+			    : Command(target), name(name){};
+			void execute(entt::registry& registry, entt::entity entity) override {}
+			bool createsEntity() const override {
+				return true;
+			}
+		};
+
+		struct DestroyCommand : Command {
+			using Command::Command;
+			void execute(entt::registry& registry, entt::entity entity) override {
+				registry.destroy(entity);
+			}
+		};
+
+		template <typename T>
+		struct EmplaceCommand : Command {
+			T component;
+
+			template <typename... Args>
+			EmplaceCommand(EntityRef target, Args&&... args)
+			    : Command(target), component(std::forward<Args>(args)...){};
+			void execute(entt::registry& registry, entt::entity entity) override {
+				registry.emplace_or_replace<T>(entity, std::move(component));
+			}
+		};
+
+		template <typename T>
+		struct RemoveCommand : Command {
+			using Command::Command;
+			void execute(entt::registry& registry, entt::entity entity) override {
+				registry.remove<T>(entity);
+			}
+		};
+
+		template <typename T, typename... Args>
+		T* push(Args&&... args) {
+			T* command = arena.create<T>(std::forward<Args>(args)...);
+			if (tail) {
+				tail->next = command;
+			} else {
+				head = command;
+			}
+			tail = command;
+			commandCount++;
+			return command;
+		}
+
+		LinearArena arena{};
+		Command* head = nullptr;
+		Command* tail = nullptr;
+		uint32_t commandCount = 0;
+		uint32_t deferredCount = 0;
+
+		std::vector<entt::entity> createdEntities; // Maps deferred indices to real entities during playback.
+	};
+} // namespace Aspen
\ No newline at end of file
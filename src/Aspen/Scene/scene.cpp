@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "entity.hpp"
+#include "entity_command_buffer.hpp"
 #include "Aspen/Core/model.hpp"
 
 namespace Aspen {
@@ -29,6 +30,7 @@ namespace Aspen {
 
 	Entity Scene::createEntity(const std::string& name) {
 		Entity entity = {m_Registry.create(), this};
+		markTransformsChanged();
 
 		entity.addComponent<IDComponent>();
 		entity.addComponent<TransformComponent>();
@@ -38,33 +40,85 @@ namespace Aspen {
 		return entity;
 	}
 
+	std::vector<entt::entity> Scene::createEntities(size_t count, std::span<const TransformComponent> transforms, const std::string& tag) {
+		assert((transforms.empty() || transforms.size() == count) && "Transform count must match entity count!");
+
+		std::vector<entt::entity> entities(count);
+		if (count == 0) {
+			return entities;
+		}
+
+		// Grow the pools once instead of letting every emplace reallocate.
+		m_Registry.storage<IDComponent>().reserve(m_Registry.storage<IDComponent>().size() + count);
+		m_Registry.storage<TransformComponent>().reserve(m_Registry.storage<TransformComponent>().size() + count);
+
+		m_Registry.create(entities.begin(), entities.end());
+		markTransformsChanged();
+
+		std::vector<uint64_t> uuids(count);
+		UUID::generate(uuids);
+
+		std::vector<IDComponent> ids;
+		ids.reserve(count);
+		for (uint64_t uuid : uuids) {
+			ids.emplace_back(UUID(uuid));
+		}
+		m_Registry.insert<IDComponent>(entities.begin(), entities.end(), ids.begin());
+
+		if (transforms.empty()) {
+			m_Registry.insert<TransformComponent>(entities.begin(), entities.end());
+		} else {
+			m_Registry.insert<TransformComponent>(entities.begin(), entities.end(), transforms.begin());
+		}
+
+		if (!tag.empty()) {
+			m_Registry.storage<TagComponent>().reserve(m_Registry.storage<TagComponent>().size() + count);
+			m_Registry.insert<TagComponent>(entities.begin(), entities.end(), TagComponent{internTag(tag)});
+		}
+
+		return entities;
+	}
+
+	const std::string* Scene::internTag(const std::string& tag) {
+		// Elements of an unordered_set never move, so the pointer is stable across rehashes.
+		return &*m_tagTable.insert(tag).first;
+	}
+
 	void Scene::updateSceneData() {
-		// Concatenate all the models
+		markTransformsChanged();
+
+		// Concatenate all the models. Geometry shared between entities is only copied once.
 		std::vector<MeshComponent::Vertex> vertices;
 		std::vector<uint32_t> indices;
 		std::vector<MaterialComponent> materials;
 		std::vector<glm::uvec2> offsets;
 
+		m_sceneData.geometries.clear();
+		m_sceneData.geometryOffsets.clear();
+		m_sceneData.instanceGeometryIndices.clear();
+		m_sceneData.geometryIndices.clear();
+		m_sceneData.materialIndices.clear();
+
 		auto group = getRenderComponents();
 		for (const auto& entity : group) {
 			auto [mesh, meshMaterial] = group.get<MeshComponent, MaterialComponent>(entity);
 
-			// Remember the index, vertex offsets.
-			const auto indexOffset = static_cast<uint32_t>(indices.size());
-			const auto vertexOffset = static_cast<uint32_t>(vertices.size());
-			const auto materialOffset = static_cast<uint32_t>(materials.size());
+			auto [it, inserted] = m_sceneData.geometryIndices.try_emplace(mesh.geometry.get(), static_cast<uint32_t>(m_sceneData.geometries.size()));
+			if (inserted) {
+				// Remember the index, vertex offsets.
+				m_sceneData.geometries.push_back(mesh.geometry);
+				m_sceneData.geometryOffsets.emplace_back(static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(vertices.size()));
 
-			offsets.emplace_back(indexOffset, vertexOffset);
+				// Copy model data one after the other.
+				vertices.insert(vertices.end(), mesh.geometry->vertices.begin(), mesh.geometry->vertices.end());
+				indices.insert(indices.end(), mesh.geometry->indices.begin(), mesh.geometry->indices.end());
+			}
 
-			// Copy model data one after the other.
-			vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
-			indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+			// Materials are indexed per instance (gl_InstanceCustomIndexEXT), so one geometry can be drawn with many materials.
+			m_sceneData.instanceGeometryIndices.push_back(it->second);
+			offsets.push_back(m_sceneData.geometryOffsets[it->second]);
+			m_sceneData.materialIndices[entity] = static_cast<uint32_t>(materials.size());
 			materials.push_back(meshMaterial);
-
-			// Adjust the texture id.
-			for (size_t i = vertexOffset; i != vertices.size(); ++i) {
-				vertices[i].materialIndex = materialOffset;
-			}
 		}
 
 		Model::createVertexBuffers(device, vertices, m_sceneData.vertexBuffer);
@@ -131,6 +185,109 @@ namespace Aspen {
 		return -1;
 	}
 
+	int32_t Scene::addTexture(Texture2D& textureHandle, const ImageProperties& image, std::string relativeFilepath, VkFormat format, VkQueue copyQueue) {
+		textureHandle.loadFromImage(&device, std::move(relativeFilepath), image, format, copyQueue);
+
+		if (textureHandle.isTextureLoaded) {
+			return m_sceneData.textureCount++;
+		}
+
+		std::cout << "Loading of texture: " << textureHandle.filePath << " was not successful!" << std::endl;
+		return -1;
+	}
+
+	void Scene::buildInstanceBVH() {
+		m_instanceEntities.clear();
+		m_instanceInverseTransforms.clear();
+
+		std::vector<Math::AABB> instanceBounds;
+
+		auto group = getRenderComponents();
+		for (const auto& entity : group) {
+			auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(entity);
+			if (mesh.geometry->bvh.empty() || isDynamic(entity)) {
+				continue;
+			}
+
+			const glm::mat4& modelMatrix = transform.transform();
+			instanceBounds.push_back(mesh.geometry->bvh.getBounds().transformed(modelMatrix));
+			m_instanceEntities.push_back(entity);
+			m_instanceInverseTransforms.push_back(glm::inverse(modelMatrix));
+		}
+
+		m_instanceBVH.build(instanceBounds);
+		m_instanceBVHVersion = m_transformVersion;
+	}
+
+	RayHit Scene::rayCast(const Math::Ray& ray, float maxDistance) {
+		// Static instances only move when the transform version changes, so the top level over them is only rebuilt then.
+		// Animated instances move every update without changing it, there are few of them and they are tested one by one.
+		if (m_instanceBVHVersion != m_transformVersion) {
+			buildInstanceBVH();
+		}
+
+		RayHit hit{};
+		float tMax = maxDistance;
+
+		auto group = getRenderComponents();
+		auto intersectInstance = [&](entt::entity entity, const glm::mat4& inverseTransform, float& closestHit) {
+			// Bring the ray into object space. The direction is not normalized so hit distances stay in world space units.
+			Math::Ray localRay{glm::vec3(inverseTransform * glm::vec4(ray.origin, 1.0f)), glm::vec3(inverseTransform * glm::vec4(ray.direction, 0.0f))};
+
+			uint32_t triangleIndex;
+			if (!Model::intersect(*group.get<MeshComponent>(entity).geometry, localRay, closestHit, triangleIndex)) {
+				return false;
+			}
+
+			hit.entity = entity;
+			hit.distance = closestHit;
+			hit.triangleIndex = triangleIndex;
+			return true;
+		};
+
+		m_instanceBVH.traverse(ray, tMax, [&](uint32_t instanceIndex, float& closestHit) {
+			return intersectInstance(m_instanceEntities[instanceIndex], m_instanceInverseTransforms[instanceIndex], closestHit);
+		});
+
+		for (const auto& entity : getSpinningComponents()) {
+			if (!group.contains(entity) || group.get<MeshComponent>(entity).geometry->bvh.empty()) {
+				continue;
+			}
+			intersectInstance(entity, glm::inverse(group.get<TransformComponent>(entity).transform()), tMax);
+		}
+
+		if (hit) {
+			hit.position = ray.origin + ray.direction * hit.distance;
+		}
+
+		return hit;
+	}
+
+	EntityCommandBuffer& Scene::getCommandBuffer(uint32_t workerIndex) {
+		std::lock_guard<std::mutex> lock(m_commandBufferMutex);
+
+		if (workerIndex >= m_commandBuffers.size()) {
+			m_commandBuffers.resize(workerIndex + 1);
+		}
+
+		if (!m_commandBuffers[workerIndex]) {
+			m_commandBuffers[workerIndex] = std::make_unique<EntityCommandBuffer>();
+		}
+
+		return *m_commandBuffers[workerIndex];
+	}
+
+	void Scene::playbackCommandBuffers() {
+		std::lock_guard<std::mutex> lock(m_commandBufferMutex);
+
+		for (auto& commandBuffer : m_commandBuffers) {
+			if (commandBuffer && !commandBuffer->empty()) {
+				markTransformsChanged();
+				commandBuffer->playback(*this);
+			}
+		}
+	}
+
 	void Scene::OnUpdate() {
 		// Camera* mainCamera = nullptr;
 
@@ -2,6 +2,8 @@
 
 #include "Aspen/Scene/components.hpp"
 #include <entt/entt.hpp>
+#include <span>
+#include <mutex>
 
 namespace Aspen {
 	struct SceneData {
@@ -10,9 +12,28 @@ namespace Aspen {
 		std::unique_ptr<Buffer> offsetBuffer;
 		std::unique_ptr<Buffer> materialBuffer;
 		uint32_t textureCount = 0;
+
+		// Unique geometries in the order they were packed into the vertex/index buffers.
+		std::vector<std::shared_ptr<MeshComponent::Geometry>> geometries;
+		std::vector<glm::uvec2> geometryOffsets;       // First index and first vertex of each geometry.
+		std::vector<uint32_t> instanceGeometryIndices; // Geometry used by each render entity, in group order.
+		std::unordered_map<const MeshComponent::Geometry*, uint32_t> geometryIndices; // Index of each packed geometry in geometries.
+		std::unordered_map<entt::entity, uint32_t> materialIndices;                    // Index of each render entity's material in materialBuffer.
+	};
+
+	struct RayHit {
+		entt::entity entity = entt::null;
+		float distance = std::numeric_limits<float>::max();
+		glm::vec3 position{0.0f};
+		uint32_t triangleIndex = 0;
+
+		operator bool() const {
+			return entity != entt::null;
+		}
 	};
 
 	class Entity;
+	class EntityCommandBuffer;
 	class Scene {
 	public:
 		Scene(Device& device);
@@ -20,10 +41,31 @@ namespace Aspen {
 
 		void updateSceneData();
 		int32_t addTexture(Texture2D& textureHandle, std::string relativeFilepath, VkFormat format, VkQueue copyQueue);
+		int32_t addTexture(Texture2D& textureHandle, const ImageProperties& image, std::string relativeFilepath, VkFormat format, VkQueue copyQueue); // Uploads an already decoded image.
 
 		Entity createEntity(const std::string& name = std::string());
+
+		// Creates count entities at once. Component pools are reserved up front and UUIDs are generated in a single batch.
+		// If transforms is not empty it must hold one transform per entity.
+		// An empty tag skips the TagComponent entirely, otherwise all entities share one interned tag.
+		std::vector<entt::entity> createEntities(size_t count, std::span<const TransformComponent> transforms = {}, const std::string& tag = std::string());
+
+		// Returns a pointer to the scene owned copy of the tag, which stays valid for the lifetime of the scene.
+		const std::string* internTag(const std::string& tag);
+
 		void OnUpdate();
 
+		// Returns the command buffer owned by the given worker. Each worker index must only be used by one thread at a time.
+		// Only fetching a buffer takes a lock, recording into it does not.
+		EntityCommandBuffer& getCommandBuffer(uint32_t workerIndex);
+
+		// Applies all recorded structural changes. Buffers are played back in worker index order so the result is deterministic.
+		// Must be called from the main thread while no worker is recording.
+		void playbackCommandBuffers();
+
+		// Returns the closest renderable entity hit by a world space ray.
+		RayHit rayCast(const Math::Ray& ray, float maxDistance = std::numeric_limits<float>::max());
+
 		auto getRenderComponents() {
 			return m_Registry.group<TransformComponent>(entt::get<MeshComponent, MaterialComponent>);
 		};
@@ -36,6 +78,24 @@ namespace Aspen {
 			return m_Registry.group<PointLightComponent>(entt::get<TransformComponent>);
 		};
 
+		auto getSpinningComponents() {
+			return m_Registry.group<SpinComponent>(entt::get<TransformComponent>);
+		};
+
+		// Entities driven by a SpinComponent move every update, everything else only moves when it is edited.
+		bool isDynamic(entt::entity entity) const {
+			return m_Registry.all_of<SpinComponent>(entity);
+		}
+
+		// Counts the changes that can move a static entity: edits, creating entities and structural playback.
+		// Caches built from the static entities (e.g. shadow maps) compare it to know when they are stale.
+		void markTransformsChanged() {
+			++m_transformVersion;
+		}
+		uint64_t getTransformVersion() const {
+			return m_transformVersion;
+		}
+
 		const SceneData& getSceneData() const {
 			return m_sceneData;
 		}
@@ -48,11 +108,27 @@ namespace Aspen {
 		}
 
 	private:
+		void buildInstanceBVH();
+
 		entt::registry m_Registry;
 		Device& device;
 
 		SceneData m_sceneData{};
+		uint64_t m_transformVersion = 0;
+		std::unordered_set<std::string> m_tagTable;
+
+		std::vector<std::unique_ptr<EntityCommandBuffer>> m_commandBuffers;
+		std::mutex m_commandBufferMutex;
+
+		// Top level structure over the world space bounds of every static renderable instance, as of m_instanceBVHVersion.
+		Math::BVH m_instanceBVH;
+		std::vector<entt::entity> m_instanceEntities;
+		std::vector<glm::mat4> m_instanceInverseTransforms;
+		uint64_t m_instanceBVHVersion = std::numeric_limits<uint64_t>::max();
 
 		friend class Entity;
+		friend class EntityCommandBuffer;
+		friend class SceneSerializer;
+		friend class SceneGenerator;
 	};
 } // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "Aspen/Scene/scene_generator.hpp"
+
+#include "Aspen/Core/model.hpp"
+
+namespace Aspen {
+	namespace {
+		constexpr std::array<const char*, 4> MESH_ASSETS{
+		    "assets/models/cube.obj",
+		    "assets/models/UV-Sphere.obj",
+		    "assets/models/bunny.obj",
+		    "assets/models/dragon-lowres2.obj",
+		};
+
+		constexpr std::array<const char*, 6> TEXTURE_ASSETS{
+		    "assets/textures/Ceramic.png",
+		    "assets/textures/LaticeWall.png",
+		    "assets/textures/PaintedPlank.png",
+		    "assets/textures/RustedPlates.png",
+		    "assets/textures/Wool.jpg",
+		    "assets/textures/scratchedPaint.png",
+		};
+
+		constexpr uint32_t MAX_CLUSTER_COUNT = 32;
+		constexpr uint32_t ENTITIES_PER_CLUSTER = 500;
+	} // namespace
+
+	std::optional<StressSceneSettings> StressSceneSettings::fromCommandLine(int argc, char** argv) {
+		std::optional<StressSceneSettings> settings;
+
+		for (int i = 1; i + 1 < argc; i += 2) {
+			const std::string option = argv[i];
+			const std::string value = argv[i + 1];
+
+			try {
+				if (option == "--cpu-trace" || option == "--spawn-benchmark") {
+					continue; // Handled by main().
+				} else if (option == "--stress") {
+					settings.emplace().entityCount = static_cast<uint32_t>(std::stoul(value));
+				} else if (!settings) {
+					std::cout << "Ignoring " << option << ", it must come after --stress <count>." << std::endl;
+				} else if (option == "--distribution") {
+					if (value == "grid") {
+						settings->distribution = Distribution::Grid;
+					} else if (value == "uniform") {
+						settings->distribution = Distribution::Uniform;
+					} else if (value == "clusters") {
+						settings->distribution = Distribution::Clusters;
+					} else {
+						std::cout << "Unknown distribution: " << value << std::endl;
+					}
+				} else if (option == "--mesh-weights") {
+					// Four comma separated weights, at least one of which must be positive.
+					std::array<float, 4> weights{};
+					std::istringstream stream{value};
+					std::string weight;
+					size_t weightCount = 0;
+					bool valid = true;
+					while (std::getline(stream, weight, ',')) {
+						if (weightCount == weights.size()) {
+							valid = false;
+							break;
+						}
+						weights[weightCount] = std::stof(weight);
+						valid = valid && weights[weightCount] >= 0.0f;
+						++weightCount;
+					}
+					if (valid && weightCount == weights.size() && std::any_of(weights.begin(), weights.end(), [](float w) { return w > 0.0f; })) {
+						settings->meshWeights = weights;
+					} else {
+						std::cout << "Invalid mesh weights: " << value << ", expected four non-negative numbers such as 1,1,0,2." << std::endl;
+					}
+				} else if (option == "--metallic") {
+					settings->metallicFraction = glm::clamp(std::stof(value), 0.0f, 1.0f);
+				} else if (option == "--dielectric") {
+					settings->dielectricFraction = glm::clamp(std::stof(value), 0.0f, 1.0f);
+				} else if (option == "--materials") {
+					settings->materialCount = std::max(1u, static_cast<uint32_t>(std::stoul(value)));
+				} else if (option == "--textured") {
+					settings->texturedFraction = glm::clamp(std::stof(value), 0.0f, 1.0f);
+				} else if (option == "--lights") {
+					settings->pointLightCount = static_cast<uint32_t>(std::stoul(value));
+				} else if (option == "--animated") {
+					settings->animatedFraction = glm::clamp(std::stof(value), 0.0f, 1.0f);
+				} else if (option == "--seed") {
+					settings->seed = std::stoull(value);
+				} else {
+					std::cout << "Unknown option: " << option << std::endl;
+				}
+			} catch (const std::exception&) {
+				std::cout << "Invalid value for " << option << ": " << value << std::endl;
+			}
+		}
+
+		// Whatever is neither metallic nor dielectric is lambertian, so metals take precedence when the two add up to more than everything.
+		if (settings && settings->metallicFraction + settings->dielectricFraction > 1.0f) {
+			std::cout << "Metallic and dielectric fractions add up to more than 1, reducing the dielectric fraction to " << 1.0f - settings->metallicFraction << "." << std::endl;
+			settings->dielectricFraction = 1.0f - settings->metallicFraction;
+		}
+
+		return settings;
+	}
+
+	Math::AABB SceneGenerator::generate(const StressSceneSettings& settings) {
+		std::mt19937_64 rng(settings.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+
+		auto randomDirection = [&]() {
+			glm::vec3 direction{normal(rng), normal(rng), normal(rng)};
+			float length = glm::length(direction);
+			return length > 0.0f ? direction / length : glm::vec3(0.0f, -1.0f, 0.0f);
+		};
+
+		const uint32_t count = settings.entityCount;
+		const float halfExtent = 0.5f * settings.spacing * std::cbrt(static_cast<float>(count));
+
+		// Every asset is loaded once and shared by all of its instances. Meshes are rescaled to a common size so the spacing means the same for all of them.
+		std::array<std::shared_ptr<MeshComponent::Geometry>, MESH_ASSETS.size()> geometries;
+		std::array<float, MESH_ASSETS.size()> unitScales{};
+		for (size_t i = 0; i < MESH_ASSETS.size(); ++i) {
+			if (settings.meshWeights[i] <= 0.0f) {
+				continue;
+			}
+
+			geometries[i] = std::make_shared<MeshComponent::Geometry>();
+			Model::createModelFromFile(scene.device, *geometries[i], MESH_ASSETS[i]);
+
+			glm::vec3 extent = geometries[i]->bvh.getBounds().max - geometries[i]->bvh.getBounds().min;
+			unitScales[i] = 1.0f / std::max(glm::max(extent.x, glm::max(extent.y, extent.z)), 1e-4f);
+		}
+		std::discrete_distribution<uint32_t> pickMesh(settings.meshWeights.begin(), settings.meshWeights.end());
+
+		// Material palette. Textured materials temporarily store the index into TEXTURE_ASSETS, it becomes a scene texture id once loaded.
+		std::vector<MaterialComponent> palette(std::max(settings.materialCount, 1u));
+		for (auto& material : palette) {
+			float type = unit(rng);
+			if (type < settings.metallicFraction) {
+				material.materialModel = MaterialComponent::MaterialType::Metallic;
+				material.fuzziness = 0.3f * unit(rng);
+			} else if (type < settings.metallicFraction + settings.dielectricFraction) {
+				material.materialModel = MaterialComponent::MaterialType::Dielectric;
+				material.fuzziness = 0.0f;
+				material.refractionIndex = 1.3f + 0.2f * unit(rng);
+			} else {
+				material.materialModel = MaterialComponent::MaterialType::Lambertian;
+			}
+
+			material.diffuse = glm::vec4(0.2f + 0.8f * unit(rng), 0.2f + 0.8f * unit(rng), 0.2f + 0.8f * unit(rng), 1.0f);
+			material.specular = 1.0f + 59.0f * unit(rng);
+			material.diffuseTextureId = unit(rng) < settings.texturedFraction ? static_cast<int32_t>(rng() % TEXTURE_ASSETS.size()) : -1;
+		}
+
+		// Cluster centres, only used by the clustered distribution.
+		std::vector<glm::vec3> clusterCentres(std::clamp(count / ENTITIES_PER_CLUSTER, 1u, MAX_CLUSTER_COUNT));
+		for (auto& centre : clusterCentres) {
+			centre = glm::vec3(unit(rng), unit(rng), unit(rng)) * (2.0f * halfExtent) - halfExtent;
+		}
+		const float clusterRadius = halfExtent / (2.0f * std::cbrt(static_cast<float>(clusterCentres.size())));
+
+		const auto gridSide = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(count))));
+		const float gridOffset = 0.5f * static_cast<float>(gridSide - 1);
+
+		Math::AABB bounds{};
+		std::vector<TransformComponent> transforms(count);
+		std::vector<uint32_t> meshIndices(count);
+		std::vector<uint32_t> materialIndices(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			auto& transform = transforms[i];
+
+			switch (settings.distribution) {
+				case StressSceneSettings::Distribution::Grid: {
+					glm::vec3 cell{static_cast<float>(i % gridSide), static_cast<float>(i / (gridSide * gridSide)), static_cast<float>((i / gridSide) % gridSide)};
+					transform.translation = (cell - gridOffset) * settings.spacing;
+					break;
+				}
+				case StressSceneSettings::Distribution::Uniform:
+					transform.translation = glm::vec3(unit(rng), unit(rng), unit(rng)) * (2.0f * halfExtent) - halfExtent;
+					break;
+				case StressSceneSettings::Distribution::Clusters:
+					transform.translation = clusterCentres[rng() % clusterCentres.size()] + glm::vec3(normal(rng), normal(rng), normal(rng)) * clusterRadius;
+					break;
+			}
+
+			meshIndices[i] = pickMesh(rng);
+			materialIndices[i] = static_cast<uint32_t>(rng() % palette.size());
+
+			transform.rotation = glm::angleAxis(glm::two_pi<float>() * unit(rng), randomDirection());
+			transform.scale = glm::vec3(unitScales[meshIndices[i]] * settings.spacing * (0.45f + 0.15f * unit(rng)));
+
+			bounds.grow(transform.translation);
+		}
+
+		std::vector<entt::entity> entities = scene.createEntities(count, transforms, "Generated");
+		auto& registry = scene.m_Registry;
+
+		std::array<int32_t, TEXTURE_ASSETS.size()> textureIds;
+		std::array<bool, TEXTURE_ASSETS.size()> texturesRequested{};
+		textureIds.fill(-1);
+
+		std::vector<MaterialComponent> materials(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			auto& mesh = registry.emplace<MeshComponent>(entities[i], geometries[meshIndices[i]]);
+
+			MaterialComponent& material = materials[i];
+			material = palette[materialIndices[i]];
+			if (material.diffuseTextureId != -1) {
+				const auto slot = static_cast<size_t>(material.diffuseTextureId);
+
+				// The first entity to use a texture owns it, the others sample it through their material's texture id.
+				if (!texturesRequested[slot]) {
+					texturesRequested[slot] = true;
+					textureIds[slot] = scene.addTexture(mesh.texture, TEXTURE_ASSETS[slot], VK_FORMAT_R8G8B8A8_SRGB, scene.device.graphicsQueue());
+				}
+				material.diffuseTextureId = textureIds[slot];
+			}
+		}
+
+		// The render systems need at least one texture, so fall back to texturing the first entity.
+		if (count > 0 && scene.m_sceneData.textureCount == 0) {
+			materials[0].diffuseTextureId = scene.addTexture(registry.get<MeshComponent>(entities[0]).texture, TEXTURE_ASSETS[0], VK_FORMAT_R8G8B8A8_SRGB, scene.device.graphicsQueue());
+		}
+		registry.insert<MaterialComponent>(entities.begin(), entities.end(), materials.begin());
+
+		// Animated entities.
+		std::vector<entt::entity> spinningEntities;
+		std::vector<SpinComponent> spins;
+		for (uint32_t i = 0; i < count; ++i) {
+			if (unit(rng) < settings.animatedFraction) {
+				spinningEntities.push_back(entities[i]);
+				spins.push_back({randomDirection(), 0.25f + 1.75f * unit(rng)});
+			}
+		}
+		registry.insert<SpinComponent>(spinningEntities.begin(), spinningEntities.end(), spins.begin());
+
+		// Point lights float above the scene (the y axis points down). Many lights share the scene between them, so their
+		// intensity, and with it their radius of influence, drops as there are more of them.
+		if (settings.pointLightCount > 0) {
+			std::vector<TransformComponent> lightTransforms(settings.pointLightCount);
+			std::vector<PointLightComponent> lights(settings.pointLightCount);
+			for (uint32_t i = 0; i < settings.pointLightCount; ++i) {
+				lightTransforms[i].translation = glm::vec3(unit(rng), 0.0f, unit(rng)) * (2.0f * halfExtent) - glm::vec3(halfExtent, 0.0f, halfExtent);
+				lightTransforms[i].translation.y = bounds.min.y - settings.spacing;
+				lights[i].color = glm::vec3(0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng));
+				lights[i].lightIntensity = std::max(3.0f, 4.0f * halfExtent / static_cast<float>(settings.pointLightCount));
+			}
+
+			std::vector<entt::entity> lightEntities = scene.createEntities(settings.pointLightCount, lightTransforms, "PointLight");
+			registry.insert<PointLightComponent>(lightEntities.begin(), lightEntities.end(), lights.begin());
+		}
+
+		return bounds;
+	}
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Scene/scene.hpp"
+
+#include <optional>
+
+namespace Aspen {
+	// Describes a procedurally populated scene used to measure how the engine scales with entity count.
+	// The same settings (including the seed) always produce the same scene.
+	struct StressSceneSettings {
+		enum class Distribution {
+			Grid,     // Evenly spaced on a cube shaped grid.
+			Uniform,  // Uniformly random inside a cube.
+			Clusters, // Normally distributed around a handful of random centres.
+		};
+
+		uint32_t entityCount = 1000;
+		Distribution distribution = Distribution::Grid;
+		float spacing = 1.5f; // Average distance between neighbouring entities.
+
+		// Relative weights of cube.obj, UV-Sphere.obj, bunny.obj and dragon-lowres2.obj.
+		std::array<float, 4> meshWeights{1.0f, 1.0f, 1.0f, 1.0f};
+
+		// Entities pick their material from a fixed palette, so many of them share identical materials.
+		uint32_t materialCount = 16;
+		float metallicFraction = 0.25f;
+		float dielectricFraction = 0.1f;
+		float texturedFraction = 0.5f;
+
+		uint32_t pointLightCount = 4;
+		float animatedFraction = 0.1f; // Fraction of entities that spin every update.
+		uint64_t seed = 1337;
+
+		// Returns settings if the command line contains --stress <count>, followed by any of
+		// --distribution grid|uniform|clusters, --mesh-weights <cube>,<sphere>,<bunny>,<dragon>, --materials <n>, --metallic <f>,
+		// --dielectric <f>, --textured <f>, --lights <n>, --animated <f>, --seed <n>.
+		static std::optional<StressSceneSettings> fromCommandLine(int argc, char** argv);
+	};
+
+	class SceneGenerator {
+	public:
+		SceneGenerator(Scene& scene)
+		    : scene(scene){};
+
+		// Appends the generated entities to the scene and returns their world space bounds.
+		// The caller is responsible for rebuilding the scene data afterwards.
+		Math::AABB generate(const StressSceneSettings& settings);
+
+	private:
+		Scene& scene;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,559 @@
+#include "Aspen/Scene/scene_serializer.hpp"
+
+#include "Aspen/Core/model.hpp"
+#include "Aspen/Utils/mapped_file.hpp"
+
+namespace Aspen {
+	namespace {
+		constexpr uint32_t SNAPSHOT_MAGIC = 0x4E435341; // "ASCN"
+		constexpr uint32_t SNAPSHOT_VERSION = 2; // 2 added the spin sections.
+		constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+		constexpr uint64_t SECTION_ALIGNMENT = 16; // Enough for MaterialComponent (alignas(16)) to be used in place.
+
+		enum class SectionType : uint32_t {
+			UUIDs = 0,
+			TagIndices,
+			StringOffsets,
+			StringData,
+			Translations,
+			Rotations,
+			Scales,
+			MeshRows,
+			MeshAssetIndices,
+			MeshTextureIndices,
+			Assets,
+			AssetVertices,
+			AssetIndices,
+			MaterialRows,
+			Materials,
+			PointLightRows,
+			PointLights,
+			SpinRows,
+			SpinAxes,
+			SpinSpeeds,
+			Count
+		};
+
+		struct FileHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entityCount;
+			uint32_t sectionCount;
+		};
+
+		struct SectionHeader {
+			SectionType type;
+			uint32_t elementSize;
+			uint64_t count;
+			uint64_t offset; // From the start of the file.
+		};
+
+		struct AssetRecord {
+			uint64_t contentHash;
+			uint32_t pathIndex; // INVALID_INDEX for embedded (procedural) geometry.
+			uint32_t vertexOffset;
+			uint32_t vertexCount;
+			uint32_t indexOffset;
+			uint32_t indexCount;
+			uint32_t padding;
+		};
+
+		// Deduplicated strings, stored as one blob plus an offsets array (count + 1 entries).
+		class StringTable {
+		public:
+			uint32_t add(const std::string& string) {
+				auto [it, inserted] = lookup.try_emplace(string, static_cast<uint32_t>(offsets.size() - 1));
+				if (inserted) {
+					data.insert(data.end(), string.begin(), string.end());
+					offsets.push_back(static_cast<uint32_t>(data.size()));
+				}
+				return it->second;
+			}
+
+			std::vector<uint32_t> offsets{0};
+			std::vector<char> data;
+
+		private:
+			std::unordered_map<std::string, uint32_t> lookup;
+		};
+
+		class SnapshotWriter {
+		public:
+			template <typename T>
+			void addSection(SectionType type, const std::vector<T>& elements) {
+				sections.push_back({type, static_cast<uint32_t>(sizeof(T)), elements.size(), elements.data()});
+			}
+
+			bool write(const std::string& filePath, uint32_t entityCount) {
+				std::ofstream file{filePath, std::ios::binary | std::ios::trunc};
+				if (!file.is_open()) {
+					return false;
+				}
+
+				FileHeader header{SNAPSHOT_MAGIC, SNAPSHOT_VERSION, entityCount, static_cast<uint32_t>(sections.size())};
+
+				// Lay out the section data after the section table.
+				std::vector<SectionHeader> sectionHeaders(sections.size());
+				uint64_t offset = alignOffset(sizeof(FileHeader) + sizeof(SectionHeader) * sections.size());
+				for (size_t i = 0; i < sections.size(); ++i) {
+					sectionHeaders[i] = {sections[i].type, sections[i].elementSize, sections[i].count, offset};
+					offset = alignOffset(offset + sections[i].elementSize * sections[i].count);
+				}
+
+				file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+				file.write(reinterpret_cast<const char*>(sectionHeaders.data()), static_cast<std::streamsize>(sizeof(SectionHeader) * sectionHeaders.size()));
+
+				const char padding[SECTION_ALIGNMENT]{};
+				for (size_t i = 0; i < sections.size(); ++i) {
+					uint64_t position = static_cast<uint64_t>(file.tellp());
+					file.write(padding, static_cast<std::streamsize>(sectionHeaders[i].offset - position));
+					file.write(static_cast<const char*>(sections[i].data), static_cast<std::streamsize>(sections[i].elementSize * sections[i].count));
+				}
+
+				return file.good();
+			}
+
+		private:
+			struct Section {
+				SectionType type;
+				uint32_t elementSize;
+				uint64_t count;
+				const void* data;
+			};
+
+			static uint64_t alignOffset(uint64_t offset) {
+				return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+			}
+
+			std::vector<Section> sections;
+		};
+
+		class SnapshotReader {
+		public:
+			SnapshotReader(const MappedFile& file)
+			    : file(file) {
+				if (!file.isOpen() || file.getSize() < sizeof(FileHeader)) {
+					return;
+				}
+
+				const auto* fileHeader = reinterpret_cast<const FileHeader*>(file.getData());
+				if (fileHeader->magic != SNAPSHOT_MAGIC || fileHeader->version != SNAPSHOT_VERSION) {
+					return;
+				}
+
+				if (file.getSize() < sizeof(FileHeader) + sizeof(SectionHeader) * fileHeader->sectionCount) {
+					return;
+				}
+
+				const auto* sectionHeaders = reinterpret_cast<const SectionHeader*>(file.getData() + sizeof(FileHeader));
+				for (uint32_t i = 0; i < fileHeader->sectionCount; ++i) {
+					const SectionHeader& section = sectionHeaders[i];
+					if (section.type >= SectionType::Count || section.offset > file.getSize()) {
+						return;
+					}
+					// Divided rather than multiplied, so a huge count cannot overflow past the check.
+					if (section.elementSize != 0 && section.count > (file.getSize() - section.offset) / section.elementSize) {
+						return;
+					}
+					sections[static_cast<size_t>(section.type)] = &section;
+				}
+
+				header = fileHeader;
+			}
+
+			// Also false once a section was asked for with the wrong element type.
+			bool isValid() const {
+				return header != nullptr && !elementSizeMismatch;
+			}
+
+			uint32_t getEntityCount() const {
+				return header->entityCount;
+			}
+
+			// Returns a view straight into the mapped file. Missing sections, and sections of another element size, are returned as empty spans.
+			template <typename T>
+			std::span<const T> getSection(SectionType type) {
+				const SectionHeader* section = sections[static_cast<size_t>(type)];
+				if (section == nullptr) {
+					return {};
+				}
+
+				if (section->elementSize != sizeof(T)) {
+					elementSizeMismatch = true;
+					return {};
+				}
+
+				return {reinterpret_cast<const T*>(file.getData() + section->offset), static_cast<size_t>(section->count)};
+			}
+
+		private:
+			const MappedFile& file;
+			const FileHeader* header = nullptr;
+			bool elementSizeMismatch = false;
+			std::array<const SectionHeader*, static_cast<size_t>(SectionType::Count)> sections{};
+		};
+	} // namespace
+
+	bool SceneSerializer::serialize(const std::string& filePath) {
+		entt::registry& registry = scene.m_Registry;
+
+		// The runtime camera is owned by the application, not the scene.
+		std::vector<entt::entity> entities;
+		auto view = registry.view<IDComponent, TransformComponent>(entt::exclude<CameraComponent>);
+		for (auto entity : view) {
+			entities.push_back(entity);
+		}
+
+		StringTable strings;
+		std::vector<uint64_t> uuids;
+		std::vector<uint32_t> tagIndices;
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+
+		std::vector<uint32_t> meshRows, meshAssetIndices, meshTextureIndices;
+		std::vector<AssetRecord> assets;
+		std::vector<MeshComponent::Vertex> assetVertices;
+		std::vector<uint32_t> assetIndices;
+		std::unordered_map<uint64_t, uint32_t> assetLookup;
+
+		std::vector<uint32_t> materialRows;
+		std::vector<MaterialComponent> materials;
+		std::vector<uint32_t> pointLightRows;
+		std::vector<PointLightComponent> pointLights;
+		std::vector<uint32_t> spinRows;
+		std::vector<glm::vec3> spinAxes;
+		std::vector<float> spinSpeeds;
+
+		uuids.reserve(entities.size());
+		tagIndices.reserve(entities.size());
+		translations.reserve(entities.size());
+		rotations.reserve(entities.size());
+		scales.reserve(entities.size());
+
+		for (uint32_t row = 0; row < static_cast<uint32_t>(entities.size()); ++row) {
+			entt::entity entity = entities[row];
+			auto [id, transform] = view.get<IDComponent, TransformComponent>(entity);
+
+			uuids.push_back(id.id);
+			translations.push_back(transform.translation);
+			rotations.push_back(transform.rotation);
+			scales.push_back(transform.scale);
+
+			auto* tag = registry.try_get<TagComponent>(entity);
+			tagIndices.push_back(tag ? strings.add(tag->getTag()) : INVALID_INDEX);
+
+			if (auto* mesh = registry.try_get<MeshComponent>(entity)) {
+				const MeshComponent::Geometry& geometry = *mesh->geometry;
+				uint64_t contentHash = geometry.assetHash;
+				if (contentHash == 0) {
+					contentHash = hashBytes(geometry.vertices.data(), geometry.vertices.size() * sizeof(MeshComponent::Vertex));
+					contentHash = hashBytes(geometry.indices.data(), geometry.indices.size() * sizeof(uint32_t), contentHash);
+				}
+
+				auto [it, inserted] = assetLookup.try_emplace(contentHash, static_cast<uint32_t>(assets.size()));
+				if (inserted) {
+					AssetRecord asset{};
+					asset.contentHash = contentHash;
+					asset.pathIndex = INVALID_INDEX;
+
+					if (!geometry.assetPath.empty()) {
+						asset.pathIndex = strings.add(geometry.assetPath);
+					} else {
+						// Procedural meshes have nothing to reload from, so embed their geometry.
+						asset.vertexOffset = static_cast<uint32_t>(assetVertices.size());
+						asset.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+						asset.indexOffset = static_cast<uint32_t>(assetIndices.size());
+						asset.indexCount = static_cast<uint32_t>(geometry.indices.size());
+						assetVertices.insert(assetVertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+						assetIndices.insert(assetIndices.end(), geometry.indices.begin(), geometry.indices.end());
+					}
+
+					assets.push_back(asset);
+				}
+
+				meshRows.push_back(row);
+				meshAssetIndices.push_back(it->second);
+				meshTextureIndices.push_back(mesh->texture.isTextureLoaded ? strings.add(mesh->texture.filePath) : INVALID_INDEX);
+			}
+
+			if (auto* material = registry.try_get<MaterialComponent>(entity)) {
+				materialRows.push_back(row);
+				materials.push_back(*material);
+			}
+
+			if (auto* pointLight = registry.try_get<PointLightComponent>(entity)) {
+				pointLightRows.push_back(row);
+				pointLights.push_back(*pointLight);
+			}
+
+			if (auto* spin = registry.try_get<SpinComponent>(entity)) {
+				spinRows.push_back(row);
+				spinAxes.push_back(spin->axis);
+				spinSpeeds.push_back(spin->angularSpeed);
+			}
+		}
+
+		SnapshotWriter writer;
+		writer.addSection(SectionType::UUIDs, uuids);
+		writer.addSection(SectionType::TagIndices, tagIndices);
+		writer.addSection(SectionType::StringOffsets, strings.offsets);
+		writer.addSection(SectionType::StringData, strings.data);
+		writer.addSection(SectionType::Translations, translations);
+		writer.addSection(SectionType::Rotations, rotations);
+		writer.addSection(SectionType::Scales, scales);
+		writer.addSection(SectionType::MeshRows, meshRows);
+		writer.addSection(SectionType::MeshAssetIndices, meshAssetIndices);
+		writer.addSection(SectionType::MeshTextureIndices, meshTextureIndices);
+		writer.addSection(SectionType::Assets, assets);
+		writer.addSection(SectionType::AssetVertices, assetVertices);
+		writer.addSection(SectionType::AssetIndices, assetIndices);
+		writer.addSection(SectionType::MaterialRows, materialRows);
+		writer.addSection(SectionType::Materials, materials);
+		writer.addSection(SectionType::PointLightRows, pointLightRows);
+		writer.addSection(SectionType::PointLights, pointLights);
+		writer.addSection(SectionType::SpinRows, spinRows);
+		writer.addSection(SectionType::SpinAxes, spinAxes);
+		writer.addSection(SectionType::SpinSpeeds, spinSpeeds);
+
+		if (!writer.write(filePath, static_cast<uint32_t>(entities.size()))) {
+			std::cout << "Failed to write scene snapshot: " << filePath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SceneSerializer::deserialize(const std::string& filePath) {
+		MappedFile file{filePath};
+		SnapshotReader reader{file};
+		if (!reader.isValid()) {
+			std::cout << "Could not read scene snapshot: " << filePath << std::endl;
+			return false;
+		}
+
+		entt::registry& registry = scene.m_Registry;
+		const uint32_t entityCount = reader.getEntityCount();
+
+		auto uuids = reader.getSection<uint64_t>(SectionType::UUIDs);
+		auto tagIndices = reader.getSection<uint32_t>(SectionType::TagIndices);
+		auto stringOffsets = reader.getSection<uint32_t>(SectionType::StringOffsets);
+		auto stringData = reader.getSection<char>(SectionType::StringData);
+		auto translations = reader.getSection<glm::vec3>(SectionType::Translations);
+		auto rotations = reader.getSection<glm::quat>(SectionType::Rotations);
+		auto scales = reader.getSection<glm::vec3>(SectionType::Scales);
+		auto meshRows = reader.getSection<uint32_t>(SectionType::MeshRows);
+		auto meshAssetIndices = reader.getSection<uint32_t>(SectionType::MeshAssetIndices);
+		auto meshTextureIndices = reader.getSection<uint32_t>(SectionType::MeshTextureIndices);
+		auto assets = reader.getSection<AssetRecord>(SectionType::Assets);
+		auto assetVertices = reader.getSection<MeshComponent::Vertex>(SectionType::AssetVertices);
+		auto assetIndices = reader.getSection<uint32_t>(SectionType::AssetIndices);
+		auto materialRows = reader.getSection<uint32_t>(SectionType::MaterialRows);
+		auto materials = reader.getSection<MaterialComponent>(SectionType::Materials);
+		auto pointLightRows = reader.getSection<uint32_t>(SectionType::PointLightRows);
+		auto pointLights = reader.getSection<PointLightComponent>(SectionType::PointLights);
+		auto spinRows = reader.getSection<uint32_t>(SectionType::SpinRows);
+		auto spinAxes = reader.getSection<glm::vec3>(SectionType::SpinAxes);
+		auto spinSpeeds = reader.getSection<float>(SectionType::SpinSpeeds);
+
+		// Every index read from the file is checked before anything is added to the scene, so a corrupt snapshot leaves it untouched.
+		auto isString = [&](uint32_t index) {
+			return index < stringOffsets.size() - 1;
+		};
+		// Rows are written in increasing order, which also rules out emplacing a component twice.
+		auto areRows = [&](std::span<const uint32_t> rows) {
+			for (size_t i = 0; i < rows.size(); ++i) {
+				if (rows[i] >= entityCount || (i > 0 && rows[i] <= rows[i - 1])) {
+					return false;
+				}
+			}
+			return true;
+		};
+		auto isConsistent = [&]() {
+			if (!reader.isValid()) {
+				return false;
+			}
+
+			if (uuids.size() != entityCount || tagIndices.size() != entityCount || translations.size() != entityCount || rotations.size() != entityCount || scales.size() != entityCount) {
+				return false;
+			}
+
+			if (stringOffsets.empty() || stringOffsets.back() > stringData.size()) {
+				return false;
+			}
+			for (size_t i = 1; i < stringOffsets.size(); ++i) {
+				if (stringOffsets[i] < stringOffsets[i - 1]) {
+					return false;
+				}
+			}
+
+			for (uint32_t tagIndex : tagIndices) {
+				if (tagIndex != INVALID_INDEX && !isString(tagIndex)) {
+					return false;
+				}
+			}
+
+			if (!areRows(materialRows) || materials.size() != materialRows.size() || !areRows(pointLightRows) || pointLights.size() != pointLightRows.size()) {
+				return false;
+			}
+
+			if (!areRows(spinRows) || spinAxes.size() != spinRows.size() || spinSpeeds.size() != spinRows.size()) {
+				return false;
+			}
+
+			if (!areRows(meshRows) || meshAssetIndices.size() != meshRows.size() || meshTextureIndices.size() != meshRows.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < meshRows.size(); ++i) {
+				if (meshAssetIndices[i] >= assets.size() || (meshTextureIndices[i] != INVALID_INDEX && !isString(meshTextureIndices[i]))) {
+					return false;
+				}
+			}
+
+			for (const AssetRecord& asset : assets) {
+				if (asset.pathIndex != INVALID_INDEX) {
+					if (!isString(asset.pathIndex)) {
+						return false;
+					}
+					continue;
+				}
+
+				if (uint64_t{asset.vertexOffset} + asset.vertexCount > assetVertices.size() || uint64_t{asset.indexOffset} + asset.indexCount > assetIndices.size()) {
+					return false;
+				}
+				for (uint32_t index : assetIndices.subspan(asset.indexOffset, asset.indexCount)) {
+					if (index >= asset.vertexCount) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		};
+
+		if (!isConsistent()) {
+			std::cout << "Scene snapshot is corrupt: " << filePath << std::endl;
+			return false;
+		}
+
+		auto getString = [&](uint32_t index) {
+			return std::string(stringData.data() + stringOffsets[index], stringOffsets[index + 1] - stringOffsets[index]);
+		};
+
+		// Entities using the same asset share one geometry, just like when the scene was built. Each unique asset is only read from disk once,
+		// before any entity is created, so a missing asset also leaves the scene untouched.
+		std::vector<std::shared_ptr<MeshComponent::Geometry>> assetGeometry(assets.size());
+		for (size_t assetIndex = 0; assetIndex < assets.size(); ++assetIndex) {
+			const AssetRecord& asset = assets[assetIndex];
+			auto& geometry = assetGeometry[assetIndex];
+
+			geometry = std::make_shared<MeshComponent::Geometry>();
+			if (asset.pathIndex != INVALID_INDEX) {
+				try {
+					Model::loadModelFromFile(*geometry, getString(asset.pathIndex));
+				} catch (const std::exception& error) {
+					std::cout << "Could not load " << getString(asset.pathIndex) << " for scene snapshot " << filePath << ": " << error.what() << std::endl;
+					return false;
+				}
+				if (geometry->assetHash != asset.contentHash) {
+					std::cout << "Warning: " << geometry->assetPath << " has changed since the scene snapshot was saved." << std::endl;
+				}
+			} else {
+				geometry->vertices.assign(assetVertices.begin() + asset.vertexOffset, assetVertices.begin() + asset.vertexOffset + asset.vertexCount);
+				geometry->indices.assign(assetIndices.begin() + asset.indexOffset, assetIndices.begin() + asset.indexOffset + asset.indexCount);
+				geometry->assetHash = asset.contentHash;
+			}
+			Model::makeBuffer(scene.device, *geometry);
+		}
+
+		// Entities, IDs and transforms.
+		std::vector<TransformComponent> transforms(entityCount);
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			transforms[i].translation = translations[i];
+			transforms[i].rotation = rotations[i];
+			transforms[i].scale = scales[i];
+		}
+
+		std::vector<entt::entity> entities = scene.createEntities(entityCount, transforms);
+
+		auto& idStorage = registry.storage<IDComponent>();
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			idStorage.get(entities[i]).id = UUID(uuids[i]);
+		}
+
+		// Tags are interned, so every entity sharing a tag points at the same string.
+		std::vector<const std::string*> internedTags(stringOffsets.size() - 1, nullptr);
+		registry.storage<TagComponent>().reserve(registry.storage<TagComponent>().size() + entityCount);
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			uint32_t tagIndex = tagIndices[i];
+			if (tagIndex == INVALID_INDEX) {
+				continue;
+			}
+
+			if (!internedTags[tagIndex]) {
+				internedTags[tagIndex] = scene.internTag(getString(tagIndex));
+			}
+			registry.emplace<TagComponent>(entities[i], internedTags[tagIndex]);
+		}
+
+		auto toEntities = [&](std::span<const uint32_t> rows) {
+			std::vector<entt::entity> rowEntities(rows.size());
+			for (size_t i = 0; i < rows.size(); ++i) {
+				rowEntities[i] = entities[rows[i]];
+			}
+			return rowEntities;
+		};
+
+		// Plain data components are copied straight out of the mapped file.
+		{
+			auto materialEntities = toEntities(materialRows);
+			registry.insert<MaterialComponent>(materialEntities.begin(), materialEntities.end(), materials.begin());
+
+			auto pointLightEntities = toEntities(pointLightRows);
+			registry.insert<PointLightComponent>(pointLightEntities.begin(), pointLightEntities.end(), pointLights.begin());
+
+			auto spinEntities = toEntities(spinRows);
+			auto& spinStorage = registry.storage<SpinComponent>();
+			spinStorage.reserve(spinStorage.size() + spinEntities.size());
+			for (size_t i = 0; i < spinEntities.size(); ++i) {
+				registry.emplace<SpinComponent>(spinEntities[i], spinAxes[i], spinSpeeds[i]);
+			}
+		}
+
+		// Meshes.
+		{
+			auto meshEntities = toEntities(meshRows);
+			std::unordered_map<int32_t, int32_t> textureIdRemap;
+			std::unordered_map<uint32_t, int32_t> textureIdsByPath; // Paths are deduplicated by the string table, so its index identifies one file.
+			for (size_t i = 0; i < meshEntities.size(); ++i) {
+				auto& mesh = registry.emplace<MeshComponent>(meshEntities[i], assetGeometry[meshAssetIndices[i]]);
+
+				// Texture ids are handed out in load order, so remember how the saved ids map onto the new ones. Each file is only loaded
+				// by the first mesh using it, the others sample it through their material's texture id like generated scenes do.
+				if (meshTextureIndices[i] != INVALID_INDEX) {
+					auto [it, inserted] = textureIdsByPath.try_emplace(meshTextureIndices[i], -1);
+					if (inserted) {
+						it->second = scene.addTexture(mesh.texture, getString(meshTextureIndices[i]), VK_FORMAT_R8G8B8A8_SRGB, scene.device.graphicsQueue());
+					}
+					int32_t textureId = it->second;
+
+					auto* material = registry.try_get<MaterialComponent>(meshEntities[i]);
+					if (material && material->diffuseTextureId != -1) {
+						textureIdRemap[material->diffuseTextureId] = textureId;
+					}
+				}
+			}
+
+			// Materials can reference a texture owned by another entity's mesh, so remap them all once every texture is loaded.
+			for (entt::entity entity : meshEntities) {
+				auto* material = registry.try_get<MaterialComponent>(entity);
+				if (material && material->diffuseTextureId != -1) {
+					auto it = textureIdRemap.find(material->diffuseTextureId);
+					material->diffuseTextureId = it != textureIdRemap.end() ? it->second : -1;
+				}
+			}
+		}
+
+		return true;
+	}
+} // namespace Aspen
\ No newline at end of file
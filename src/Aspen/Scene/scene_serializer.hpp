@@ -0,0 +1,24 @@
+#pragma once
+#include "pch.h"
+
+#include "Aspen/Scene/scene.hpp"
+
+namespace Aspen {
+	// Saves and restores a scene as a binary snapshot.
+	// Components are stored as structure-of-arrays sections so loading is mostly bulk copies straight out of the mapped file.
+	// Meshes are stored as references to their source asset (by path and content hash), procedural meshes are embedded.
+	class SceneSerializer {
+	public:
+		SceneSerializer(Scene& scene)
+		    : scene(scene){};
+
+		bool serialize(const std::string& filePath);
+
+		// Appends the snapshot's entities to the scene. The caller is responsible for rebuilding the scene data afterwards.
+		// Returns false without touching the scene if the snapshot cannot be read, is corrupt or references a mesh that fails to load.
+		bool deserialize(const std::string& filePath);
+
+	private:
+		Scene& scene;
+	};
+} // namespace Aspen
\ No newline at end of file
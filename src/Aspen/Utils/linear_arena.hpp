@@ -0,0 +1,85 @@
+#pragma once
+#include "pch.h"
+
+namespace Aspen {
+	// A bump allocator. Allocations are never freed individually, the whole arena is reset at once.
+	// Blocks are kept around after a reset so steady state usage does not touch the heap.
+	class LinearArena {
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+		LinearArena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+		    : blockSize(blockSize){};
+		~LinearArena() = default;
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		LinearArena(LinearArena&&) = delete;            // Move Constructor
+		LinearArena& operator=(LinearArena&&) = delete; // Move Assignment Operator
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+			assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two!");
+
+			while (currentBlock < blocks.size()) {
+				if (void* memory = allocateFromBlock(blocks[currentBlock], size, alignment)) {
+					return memory;
+				}
+
+				// Move on to the next (possibly recycled) block.
+				currentBlock++;
+				offset = 0;
+			}
+
+			// Oversized allocations get a block of their own.
+			size_t newBlockSize = std::max(blockSize, size + alignment);
+			blocks.push_back({std::make_unique<std::byte[]>(newBlockSize), newBlockSize});
+			currentBlock = blocks.size() - 1;
+			offset = 0;
+
+			return allocateFromBlock(blocks.back(), size, alignment);
+		}
+
+		template <typename T, typename... Args>
+		T* create(Args&&... args) {
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		void reset() {
+			currentBlock = 0;
+			offset = 0;
+		}
+
+		size_t capacity() const {
+			size_t total = 0;
+			for (const auto& block : blocks) {
+				total += block.size;
+			}
+			return total;
+		}
+
+	private:
+		struct Block {
+			std::unique_ptr<std::byte[]> memory;
+			size_t size;
+		};
+
+		void* allocateFromBlock(Block& block, size_t size, size_t alignment) {
+			uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+			uintptr_t aligned = (base + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+			size_t alignedOffset = static_cast<size_t>(aligned - base);
+
+			if (alignedOffset + size > block.size) {
+				return nullptr;
+			}
+
+			offset = alignedOffset + size;
+			return block.memory.get() + alignedOffset;
+		}
+
+		std::vector<Block> blocks;
+		size_t currentBlock = 0;
+		size_t offset = 0;
+		size_t blockSize;
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "Aspen/Utils/mapped_file.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Aspen {
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filePath) {
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		fileHandle = file;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			return;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) {
+			return;
+		}
+
+		data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+
+	MappedFile::~MappedFile() {
+		if (data) {
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle) {
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle) {
+			CloseHandle(fileHandle);
+		}
+	}
+#else
+	MappedFile::MappedFile(const std::string& filePath) {
+		fileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor == -1) {
+			return;
+		}
+
+		struct stat fileStats {};
+		if (fstat(fileDescriptor, &fileStats) != 0 || fileStats.st_size == 0) {
+			return;
+		}
+		size = static_cast<size_t>(fileStats.st_size);
+
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (mapping == MAP_FAILED) {
+			return;
+		}
+
+		// The whole file is read front to back exactly once.
+		madvise(mapping, size, MADV_SEQUENTIAL);
+		data = static_cast<const uint8_t*>(mapping);
+	}
+
+	MappedFile::~MappedFile() {
+		if (data) {
+			munmap(const_cast<uint8_t*>(data), size);
+		}
+		if (fileDescriptor != -1) {
+			close(fileDescriptor);
+		}
+	}
+#endif
+} // namespace Aspen
\ No newline at end of file
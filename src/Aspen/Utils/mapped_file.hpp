@@ -0,0 +1,40 @@
+#pragma once
+#include "pch.h"
+
+namespace Aspen {
+	// Read-only memory mapping of a whole file.
+	class MappedFile {
+	public:
+		MappedFile(const std::string& filePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&&) = delete;            // Move Constructor
+		MappedFile& operator=(MappedFile&&) = delete; // Move Assignment Operator
+
+		bool isOpen() const {
+			return data != nullptr;
+		}
+
+		const uint8_t* getData() const {
+			return data;
+		}
+
+		size_t getSize() const {
+			return size;
+		}
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+	};
+} // namespace Aspen
\ No newline at end of file
@@ -9,4 +9,30 @@ namespace Aspen {
 		seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
+
+	// 64-bit FNV-1a. Used for content hashes of assets on disk, so the result must not change between runs or platforms.
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Returns the content hash of a file, or 0 if the file could not be read.
+	inline uint64_t hashFile(const std::string& filePath) {
+		std::ifstream file{filePath, std::ios::ate | std::ios::binary};
+		if (!file.is_open()) {
+			return 0;
+		}
+
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		std::vector<char> buffer(fileSize);
+		file.seekg(0);
+		file.read(buffer.data(), static_cast<std::streamsize>(fileSize));
+
+		return hashBytes(buffer.data(), buffer.size());
+	}
 } // namespace Aspen
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 // Std
 #include <cassert>
+#include <cmath>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
@@ -14,6 +15,7 @@
 #include <sstream>
 
 #include <algorithm>
+#include <bit>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -23,6 +25,7 @@
 
 // Data Structures
 #include <array>
+#include <deque>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>